@@ -0,0 +1,618 @@
+/*
+  Copyright (c) 2009 Dave Gamble
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Throughput benchmark for parsing, printing, minifying and patching.
+ *
+ * usage: cjson_bench [seconds per measurement] [document]
+ *
+ * Every document of the corpus is generated with a fixed seed, so the numbers are comparable across versions. Each
+ * result is printed as one line of JSON:
+ *   mb_per_s                 megabytes of input text handled per second of CPU time
+ *   allocations_per_document allocations through the cJSON hooks for one run (cJSON_Utils' own buffers aren't counted)
+ *   peak_heap_bytes          the most memory allocated through the hooks at once during one run
+ *   max_rss_kb               peak resident size of the whole process so far (0 where getrusage isn't available) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cJSON.h"
+#include "cJSON_Utils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define BENCH_HAVE_RUSAGE
+#endif
+
+/* allocation counting hooks, only installed for the single run that is measured */
+typedef union
+{
+    size_t size;
+    double align_double;
+    void *align_pointer;
+} bench_header;
+
+/* the hooks cJSON currently uses, text printed by cJSON has to be freed with them */
+static cJSON_Hooks hooks = {malloc, free};
+
+static size_t allocations = 0;
+static size_t heap = 0;
+static size_t heap_peak = 0;
+
+static void *counting_malloc(size_t size)
+{
+    bench_header *header = (bench_header*)malloc(sizeof(bench_header) + size);
+    if (!header)
+    {
+        return NULL;
+    }
+    header->size = size;
+    allocations++;
+    heap += size;
+    if (heap > heap_peak)
+    {
+        heap_peak = heap;
+    }
+
+    return header + 1;
+}
+
+static void counting_free(void *pointer)
+{
+    bench_header *header = NULL;
+    if (!pointer)
+    {
+        return;
+    }
+    header = (bench_header*)pointer - 1;
+    heap -= header->size;
+    free(header);
+}
+
+/* the same pseudo random numbers everywhere */
+static unsigned long seed = 1;
+
+static unsigned long bench_random(void)
+{
+    seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+
+    return seed >> 8;
+}
+
+/* Documents are generated twice: revision 1 changes every 16th value of revision 0, to have something to diff.
+ * Large containers are filled with an index, which knows their last child, and handed out without one. */
+static cJSON *create_number(int revision, int i)
+{
+    unsigned long r = bench_random();
+    if (revision && ((i % 16) == 0))
+    {
+        r++;
+    }
+    if (r & 1)
+    {
+        return cJSON_CreateNumber((double)(r % 100000));
+    }
+
+    return cJSON_CreateNumber((double)r / 1000.0 - 40000.0);
+}
+
+static cJSON *create_string(int revision, int i)
+{
+    /* mostly ASCII, with some characters that have to be escaped and some UTF-8 */
+    static const char *pieces[] = {"lorem", "ipsum", "dolor", " ", "sit", "amet", "\"quoted\"", "tab\t", "line\n", "\xc3\xa9t\xc3\xa9", "\xe2\x82\xac", "\\"};
+    char text[128];
+    size_t length = 0;
+    size_t piece = 0;
+    size_t count = 2 + bench_random() % 10;
+    text[0] = '\0';
+    for (; count > 0; count--)
+    {
+        piece = bench_random() % (sizeof(pieces) / sizeof(pieces[0]));
+        if ((length + strlen(pieces[piece])) < (sizeof(text) - 1))
+        {
+            strcpy(text + length, pieces[piece]);
+            length += strlen(pieces[piece]);
+        }
+    }
+    if (revision && ((i % 16) == 0))
+    {
+        text[0] = 'X';
+    }
+
+    return cJSON_CreateString(text);
+}
+
+/* arrays of numbers */
+static cJSON *create_numeric(int revision)
+{
+    cJSON *root = cJSON_CreateArray();
+    cJSON *row = NULL;
+    int i = 0;
+    int j = 0;
+    cJSON_EnableIndex(root);
+    for (i = 0; i < 10000; i++)
+    {
+        row = cJSON_CreateArray();
+        for (j = 0; j < 8; j++)
+        {
+            cJSON_AddItemToArray(row, create_number(revision, i * 8 + j));
+        }
+        cJSON_AddItemToArray(root, row);
+    }
+    cJSON_DisableIndex(root);
+
+    return root;
+}
+
+/* an array of strings */
+static cJSON *create_strings(int revision)
+{
+    cJSON *root = cJSON_CreateArray();
+    int i = 0;
+    cJSON_EnableIndex(root);
+    for (i = 0; i < 20000; i++)
+    {
+        cJSON_AddItemToArray(root, create_string(revision, i));
+    }
+    cJSON_DisableIndex(root);
+
+    return root;
+}
+
+/* objects in arrays in objects, 500 levels down */
+static cJSON *create_deep(int revision)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *level = root;
+    cJSON *array = NULL;
+    cJSON *next = NULL;
+    int i = 0;
+    for (i = 0; i < 500; i++)
+    {
+        cJSON_AddItemToObject(level, "id", create_number(revision, i));
+        cJSON_AddItemToObject(level, "name", create_string(revision, i));
+        array = cJSON_CreateArray();
+        cJSON_AddItemToArray(array, create_number(revision, i + 1));
+        next = cJSON_CreateObject();
+        cJSON_AddItemToArray(array, next);
+        cJSON_AddItemToObject(level, "children", array);
+        level = next;
+    }
+
+    return root;
+}
+
+/* one object with many members */
+static cJSON *create_wide(int revision)
+{
+    cJSON *root = cJSON_CreateObject();
+    char key[32];
+    int i = 0;
+    cJSON_EnableIndex(root);
+    for (i = 0; i < 20000; i++)
+    {
+        sprintf(key, "member_%05d", i);
+        cJSON_AddItemToObject(root, key, (i & 1) ? create_number(revision, i) : create_string(revision, i));
+    }
+    cJSON_DisableIndex(root);
+
+    return root;
+}
+
+/* records, printed one per line for the NDJSON document */
+static cJSON *create_records(int revision)
+{
+    cJSON *root = cJSON_CreateArray();
+    cJSON *record = NULL;
+    cJSON *tags = NULL;
+    int i = 0;
+    cJSON_EnableIndex(root);
+    for (i = 0; i < 5000; i++)
+    {
+        record = cJSON_CreateObject();
+        cJSON_AddNumberToObject(record, "id", i);
+        cJSON_AddItemToObject(record, "name", create_string(revision, i));
+        cJSON_AddItemToObject(record, "score", create_number(revision, i));
+        cJSON_AddItemToObject(record, "active", cJSON_CreateBool(bench_random() & 1));
+        tags = cJSON_CreateArray();
+        cJSON_AddItemToArray(tags, cJSON_CreateString("alpha"));
+        cJSON_AddItemToArray(tags, cJSON_CreateString("beta"));
+        cJSON_AddItemToObject(record, "tags", tags);
+        cJSON_AddItemToArray(root, record);
+    }
+    cJSON_DisableIndex(root);
+
+    return root;
+}
+
+/* the records of an array, one unformatted line each */
+static char *print_lines(cJSON *array)
+{
+    cJSON *record = NULL;
+    size_t length = 0;
+    size_t offset = 0;
+    char *text = NULL;
+    for (record = array->child; record; record = record->next)
+    {
+        length += cJSON_PrintLength(record, 0) + 1;
+    }
+    text = (char*)hooks.malloc_fn(length + 1);
+    if (!text)
+    {
+        return NULL;
+    }
+    for (record = array->child; record; record = record->next)
+    {
+        length = cJSON_PrintLength(record, 0);
+        cJSON_PrintPreallocated(record, text + offset, (int)length + 1, 0);
+        offset += length;
+        text[offset++] = '\n';
+    }
+    text[offset] = '\0';
+
+    return text;
+}
+
+typedef struct
+{
+    const char *name;
+    cJSON *(*create)(int revision);
+    /* one document per line */
+    int lines;
+} document;
+
+static const document corpus[] =
+{
+    {"numeric", create_numeric, 0},
+    {"strings", create_strings, 0},
+    {"deep", create_deep, 0},
+    {"wide", create_wide, 0},
+    {"ndjson", create_records, 1}
+};
+
+/* what the operations work on */
+typedef struct
+{
+    const document *document;
+    /* unformatted (or NDJSON) and formatted text */
+    char *text;
+    char *formatted;
+    size_t length;
+    size_t formatted_length;
+    /* parsed text and its revision */
+    cJSON *from;
+    cJSON *to;
+    cJSON *patches;
+} input;
+
+/* Operations return the bytes of input they handled, 0 on failure. CPU time spent in between start() and stop() is
+ * added to elapsed, so setup and cleanup aren't measured. */
+static clock_t started = 0;
+static clock_t elapsed = 0;
+
+static void start(void)
+{
+    started = clock();
+}
+
+static void stop(void)
+{
+    elapsed += clock() - started;
+}
+
+static size_t bench_parse(const input *in)
+{
+    cJSON *item = NULL;
+    const char *position = in->text;
+    const char *end = NULL;
+    if (!in->document->lines)
+    {
+        start();
+        item = cJSON_Parse(in->text);
+        stop();
+        if (!item)
+        {
+            return 0;
+        }
+        cJSON_Delete(item);
+
+        return in->length;
+    }
+
+    while (*position)
+    {
+        start();
+        item = cJSON_ParseWithOpts(position, &end, 0);
+        stop();
+        if (!item || (*end != '\n'))
+        {
+            cJSON_Delete(item);
+            return 0;
+        }
+        cJSON_Delete(item);
+        position = end + 1;
+    }
+
+    return in->length;
+}
+
+static size_t bench_print(const input *in)
+{
+    const cJSON *record = NULL;
+    char *text = NULL;
+    if (!in->document->lines)
+    {
+        start();
+        text = cJSON_PrintUnformatted(in->from);
+        stop();
+        if (!text)
+        {
+            return 0;
+        }
+        hooks.free_fn(text);
+
+        return in->length;
+    }
+
+    for (record = in->from->child; record; record = record->next)
+    {
+        start();
+        text = cJSON_PrintUnformatted(record);
+        stop();
+        if (!text)
+        {
+            return 0;
+        }
+        hooks.free_fn(text);
+    }
+
+    return in->length;
+}
+
+static size_t bench_minify(const input *in)
+{
+    char *text = (char*)malloc(in->formatted_length + 1);
+    if (!text)
+    {
+        return 0;
+    }
+    memcpy(text, in->formatted, in->formatted_length + 1);
+    start();
+    cJSON_Minify(text);
+    stop();
+    free(text);
+
+    return in->formatted_length;
+}
+
+static size_t bench_generate_patches(const input *in)
+{
+    cJSON *patches = NULL;
+    start();
+    patches = cJSONUtils_GeneratePatches(in->from, in->to);
+    stop();
+    if (!patches)
+    {
+        return 0;
+    }
+    cJSON_Delete(patches);
+
+    return in->length;
+}
+
+static size_t bench_apply_patches(const input *in)
+{
+    cJSON *object = cJSON_Duplicate(in->from, 1);
+    int status = 0;
+    if (!object)
+    {
+        return 0;
+    }
+    start();
+    status = cJSONUtils_ApplyPatches(object, in->patches);
+    stop();
+    cJSON_Delete(object);
+
+    return (status == 0) ? in->length : 0;
+}
+
+typedef struct
+{
+    const char *name;
+    size_t (*run)(const input *in);
+    /* needs a document that is a single value, so not NDJSON */
+    int single;
+} operation;
+
+static const operation operations[] =
+{
+    {"parse", bench_parse, 0},
+    {"print_unformatted", bench_print, 0},
+    {"minify", bench_minify, 0},
+    {"generate_patches", bench_generate_patches, 1},
+    {"apply_patches", bench_apply_patches, 1}
+};
+
+static long max_rss_kb(void)
+{
+#ifdef BENCH_HAVE_RUSAGE
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    /* bytes on macOS */
+    return (long)(usage.ru_maxrss / 1024);
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/* generate both revisions of a document and everything the operations need */
+static int prepare(input *in, const document *doc)
+{
+    cJSON *tree = NULL;
+    memset(in, '\0', sizeof(input));
+    in->document = doc;
+
+    seed = 1;
+    tree = doc->create(0);
+    seed = 1;
+    in->to = doc->create(1);
+    if (!tree || !in->to)
+    {
+        cJSON_Delete(tree);
+        return 0;
+    }
+    in->text = doc->lines ? print_lines(tree) : cJSON_PrintUnformatted(tree);
+    in->formatted = cJSON_Print(tree);
+    cJSON_Delete(tree);
+    if (!in->text || !in->formatted)
+    {
+        return 0;
+    }
+    in->length = strlen(in->text);
+    in->formatted_length = strlen(in->formatted);
+
+    if (doc->lines)
+    {
+        /* the records the lines were printed from */
+        seed = 1;
+        in->from = doc->create(0);
+    }
+    else
+    {
+        in->from = cJSON_Parse(in->text);
+    }
+    in->patches = in->from ? cJSONUtils_GeneratePatches(in->from, in->to) : NULL;
+
+    return in->patches != NULL;
+}
+
+static void release(input *in)
+{
+    hooks.free_fn(in->text);
+    hooks.free_fn(in->formatted);
+    cJSON_Delete(in->from);
+    cJSON_Delete(in->to);
+    cJSON_Delete(in->patches);
+}
+
+/* one line of results for op on doc, 0 if op failed */
+static int measure(const document *doc, const operation *op, double seconds)
+{
+    input in;
+    size_t bytes = 0;
+    size_t total = 0;
+    size_t heap_before = 0;
+    long iterations = 0;
+    double cpu_seconds = 0;
+    int success = 1;
+
+    /* count the allocations of one run, with inputs made with the counting hooks too so they can be freed */
+    hooks.malloc_fn = counting_malloc;
+    hooks.free_fn = counting_free;
+    cJSON_InitHooks(&hooks);
+    success = prepare(&in, doc);
+    if (success)
+    {
+        allocations = 0;
+        heap_before = heap;
+        heap_peak = heap;
+        success = op->run(&in) != 0;
+    }
+    release(&in);
+    hooks.malloc_fn = malloc;
+    hooks.free_fn = free;
+    cJSON_InitHooks(NULL);
+    if (!success)
+    {
+        return 0;
+    }
+
+    if (!prepare(&in, doc))
+    {
+        release(&in);
+        return 0;
+    }
+    elapsed = 0;
+    do
+    {
+        bytes = op->run(&in);
+        if (bytes == 0)
+        {
+            release(&in);
+            return 0;
+        }
+        total += bytes;
+        iterations++;
+        cpu_seconds = (double)elapsed / CLOCKS_PER_SEC;
+    } while (cpu_seconds < seconds);
+    release(&in);
+
+    printf("{\"document\":\"%s\",\"operation\":\"%s\",\"bytes\":%lu,\"iterations\":%ld,\"mb_per_s\":%.2f,"
+           "\"allocations_per_document\":%lu,\"peak_heap_bytes\":%lu,\"max_rss_kb\":%ld}\n",
+           doc->name, op->name, (unsigned long)(total / (size_t)iterations), iterations,
+           (cpu_seconds > 0) ? ((double)total / (1024.0 * 1024.0) / cpu_seconds) : 0.0,
+           (unsigned long)allocations, (unsigned long)(heap_peak - heap_before), max_rss_kb());
+    fflush(stdout);
+
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = 0.5;
+    size_t d = 0;
+    size_t o = 0;
+    int status = EXIT_SUCCESS;
+
+    if (argc > 1)
+    {
+        seconds = atof(argv[1]);
+    }
+    for (d = 0; d < (sizeof(corpus) / sizeof(corpus[0])); d++)
+    {
+        if ((argc > 2) && strcmp(argv[2], corpus[d].name))
+        {
+            continue;
+        }
+        for (o = 0; o < (sizeof(operations) / sizeof(operations[0])); o++)
+        {
+            if (operations[o].single && corpus[d].lines)
+            {
+                continue;
+            }
+            if (!measure(&corpus[d], &operations[o], seconds))
+            {
+                fprintf(stderr, "%s failed on %s\n", operations[o].name, corpus[d].name);
+                status = EXIT_FAILURE;
+            }
+        }
+    }
+
+    return status;
+}
@@ -30,6 +30,7 @@
 #include <float.h>
 #include <limits.h>
 #include <ctype.h>
+#include <locale.h>
 #include "cJSON.h"
 
 /* Determine the number of bits that an integer has using the preprocessor */
@@ -51,6 +52,17 @@ typedef int cjbool;
 #define true ((cjbool)1)
 #define false ((cjbool)0)
 
+/* unsigned 64 bit integer, ISO C90 doesn't have one */
+#if ULONG_MAX > 4294967295UL
+    typedef unsigned long cjuint64;
+#elif defined(_MSC_VER)
+    typedef unsigned __int64 cjuint64;
+#elif defined(__GNUC__)
+    __extension__ typedef unsigned long long cjuint64;
+#else
+    #error "Failed to find a 64 bit integer type"
+#endif
+
 static const char *global_ep = NULL;
 
 const char *cJSON_GetErrorPtr(void)
@@ -61,9 +73,14 @@ const char *cJSON_GetErrorPtr(void)
 /* case insensitive strcmp */
 static int cJSON_strcasecmp(const char *s1, const char *s2)
 {
+    if (s1 == s2)
+    {
+        /* both NULL, or the same (e.g. interned) string */
+        return 0;
+    }
     if (!s1)
     {
-        return (s1 == s2) ? 0 : 1; /* both NULL? */
+        return 1;
     }
     if (!s2)
     {
@@ -83,16 +100,154 @@ static int cJSON_strcasecmp(const char *s1, const char *s2)
 static void *(*cJSON_malloc)(size_t sz) = malloc;
 static void (*cJSON_free)(void *ptr) = free;
 
-static char* cJSON_strdup(const char* str)
+/* allocation functions used by the internals, the context is passed on to them */
+typedef struct internal_hooks
+{
+    void *(*allocate)(void *context, size_t size);
+    void (*deallocate)(void *context, void *pointer);
+    /* optional, NULL means allocate + memcpy + deallocate */
+    void *(*reallocate)(void *context, void *pointer, size_t size);
+    void *context;
+#ifdef CJSON_STATS
+    /* where the allocations are counted, NULL for the global counters */
+    cJSON_Stats *stats;
+#endif
+} internal_hooks;
+
+/* forward to the global hooks set with cJSON_InitHooks */
+static void *global_allocate(void *context, size_t size)
+{
+    (void)context;
+    return cJSON_malloc(size);
+}
+
+static void global_deallocate(void *context, void *pointer)
+{
+    (void)context;
+    cJSON_free(pointer);
+}
+
+static void *global_reallocate(void *context, void *pointer, size_t size)
+{
+    (void)context;
+    return realloc(pointer, size);
+}
+
+#ifdef CJSON_STATS
+static internal_hooks global_hooks = { global_allocate, global_deallocate, global_reallocate, NULL, NULL };
+#else
+static internal_hooks global_hooks = { global_allocate, global_deallocate, global_reallocate, NULL };
+#endif
+
+/* see cJSON_Stats, the macros compile to nothing without CJSON_STATS */
+#ifdef CJSON_STATS
+static cJSON_Stats stats;
+static cJSON_StatsFunction stats_begin = NULL;
+static cJSON_StatsFunction stats_end = NULL;
+static void *stats_context = NULL;
+
+/* the counters the allocations through hooks go to (hooks may be NULL) */
+static cJSON_Stats *stats_of(const internal_hooks * const hooks)
+{
+    return (hooks && hooks->stats) ? hooks->stats : &stats;
+}
+
+/* arrays and objects deeper than the deepest so far count for max_depth */
+static void stats_enter(unsigned long * const depth, const internal_hooks * const hooks)
+{
+    cJSON_Stats * const counters = stats_of(hooks);
+    if (++*depth > counters->max_depth)
+    {
+        counters->max_depth = *depth;
+    }
+}
+
+#define STATS_ADD(counter, amount) ((void)(stats.counter += (unsigned long)(amount)))
+#define STATS_COUNT(hooks, counter, amount) ((void)(stats_of(hooks)->counter += (unsigned long)(amount)))
+#define STATS_MAX(hooks, counter, value) ((void)((stats_of(hooks)->counter < (unsigned long)(value)) ? (stats_of(hooks)->counter = (unsigned long)(value)) : 0))
+#define STATS_ENTER(buffer) stats_enter(&(buffer)->depth, (buffer)->hooks)
+#define STATS_LEAVE(buffer) ((void)(buffer)->depth--)
+#define STATS_BEGIN(operation) (stats_begin ? stats_begin(stats_context, (operation), &stats) : (void)0)
+#define STATS_END(operation) (stats_end ? stats_end(stats_context, (operation), &stats) : (void)0)
+#else
+#define STATS_ADD(counter, amount) ((void)0)
+#define STATS_COUNT(hooks, counter, amount) ((void)0)
+#define STATS_MAX(hooks, counter, value) ((void)0)
+#define STATS_ENTER(buffer) ((void)0)
+#define STATS_LEAVE(buffer) ((void)0)
+#define STATS_BEGIN(operation) ((void)0)
+#define STATS_END(operation) ((void)0)
+#endif
+
+int cJSON_GetStats(cJSON_Stats *stats_out)
+{
+    if (!stats_out)
+    {
+        return false;
+    }
+#ifdef CJSON_STATS
+    *stats_out = stats;
+    return true;
+#else
+    memset(stats_out, '\0', sizeof(cJSON_Stats));
+    return false;
+#endif
+}
+
+void cJSON_ResetStats(void)
+{
+#ifdef CJSON_STATS
+    memset(&stats, '\0', sizeof(stats));
+#endif
+}
+
+void cJSON_SetStatsCallbacks(cJSON_StatsFunction begin, cJSON_StatsFunction end, void *context)
+{
+#ifdef CJSON_STATS
+    stats_begin = begin;
+    stats_end = end;
+    stats_context = context;
+#else
+    (void)begin;
+    (void)end;
+    (void)context;
+#endif
+}
+
+/* Take over a user supplied allocator, NULL means the global hooks. Returns false if it is unusable. */
+static cjbool hooks_from_allocator(internal_hooks * const hooks, const cJSON_Allocator * const allocator)
+{
+    if (!allocator)
+    {
+        *hooks = global_hooks;
+        return true;
+    }
+    if (!allocator->malloc_fn || !allocator->free_fn)
+    {
+        return false;
+    }
+    hooks->allocate = allocator->malloc_fn;
+    hooks->deallocate = allocator->free_fn;
+    hooks->reallocate = allocator->realloc_fn;
+    hooks->context = allocator->context;
+#ifdef CJSON_STATS
+    hooks->stats = NULL;
+#endif
+
+    return true;
+}
+
+static char* cJSON_strdup(const char* str, const internal_hooks * const hooks)
 {
     size_t len = 0;
     char *copy = NULL;
 
     len = strlen(str) + 1;
-    if (!(copy = (char*)cJSON_malloc(len)))
+    if (!(copy = (char*)hooks->allocate(hooks->context, len)))
     {
         return NULL;
     }
+    STATS_COUNT(hooks, string_allocations, 1);
     memcpy(copy, str, len);
 
     return copy;
@@ -105,2158 +260,7164 @@ void cJSON_InitHooks(cJSON_Hooks* hooks)
         /* Reset hooks */
         cJSON_malloc = malloc;
         cJSON_free = free;
+        global_hooks.reallocate = global_reallocate;
         return;
     }
 
     cJSON_malloc = (hooks->malloc_fn) ? hooks->malloc_fn : malloc;
     cJSON_free = (hooks->free_fn) ? hooks->free_fn : free;
+
+    /* realloc can only be used together with the standard malloc and free */
+    global_hooks.reallocate = ((cJSON_malloc == malloc) && (cJSON_free == free)) ? global_reallocate : NULL;
 }
 
 /* Internal constructor. */
-static cJSON *cJSON_New_Item(void)
+static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)cJSON_malloc(sizeof(cJSON));
+    cJSON* node = (cJSON*)hooks->allocate(hooks->context, sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
+        STATS_COUNT(hooks, node_allocations, 1);
     }
 
     return node;
 }
 
-/* Delete a cJSON structure. */
-void cJSON_Delete(cJSON *c)
+static struct cJSON_Index *create_index(const internal_hooks * const hooks);
+static void index_build(const cJSON * const item);
+static void delete_index(struct cJSON_Index *index);
+static cjbool materialize(const cJSON * const item);
+static void index_rehook(cJSON *item, const internal_hooks * const hooks);
+
+/* A subtree frozen by cJSON_Share. Items flagged cJSON_IsShared show its content and each hold a reference, the last
+ * one to go frees it. */
+typedef struct cJSON_Shared
+{
+    volatile long references;
+    cJSON *root;
+} cJSON_Shared;
+
+/* items flagged cJSON_IsShared are allocated with the subtree they hold a reference to */
+typedef struct
+{
+    cJSON item;
+    cJSON_Shared *shared;
+} shared_item;
+
+static void shared_unref(cJSON_Shared *shared);
+static cjbool unshare(cJSON *item);
+
+/* Delete a cJSON structure, giving the memory back to the hooks it came from. */
+static void delete_item(cJSON *c, const internal_hooks * const hooks)
 {
     cJSON *next = NULL;
     while (c)
     {
         next = c->next;
-        if (!(c->type & cJSON_IsReference) && c->child)
+        if (c->index)
         {
-            cJSON_Delete(c->child);
+            delete_index(c->index);
         }
-        if (!(c->type & cJSON_IsReference) && c->valuestring)
+        if (!(c->type & (cJSON_IsReference | cJSON_IsShared)) && c->child)
         {
-            cJSON_free(c->valuestring);
+            delete_item(c->child, hooks);
+        }
+        if (!(c->type & (cJSON_IsReference | cJSON_ValueStringIsConst | cJSON_IsShared)) && c->valuestring)
+        {
+            hooks->deallocate(hooks->context, c->valuestring);
         }
         if (!(c->type & cJSON_StringIsConst) && c->string)
         {
-            cJSON_free(c->string);
+            hooks->deallocate(hooks->context, c->string);
+        }
+        if (c->type & cJSON_IsShared)
+        {
+            shared_unref(((shared_item*)c)->shared);
         }
-        cJSON_free(c);
+        hooks->deallocate(hooks->context, c);
         c = next;
     }
 }
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static const char *parse_number(cJSON *item, const char *num)
+void cJSON_Delete(cJSON *c)
 {
-    double n = 0;
-    double sign = 1;
-    double scale = 0;
-    int subscale = 0;
-    int signsubscale = 1;
-
-    /* Has sign? */
-    if (*num == '-')
-    {
-        sign = -1;
-        num++;
-    }
-    /* is zero */
-    if (*num == '0')
+    if (c && (c->type & cJSON_IsImmutable))
     {
-        num++;
+        /* belongs to a shared subtree */
+        return;
     }
-    /* Number? */
-    if ((*num >= '1') && (*num <= '9'))
+    delete_item(c, &global_hooks);
+}
+
+void cJSON_DeleteWithAllocator(cJSON *c, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    if (hooks_from_allocator(&hooks, allocator))
     {
-        do
-        {
-            n = (n * 10.0) + (*num++ - '0');
-        }
-        while ((*num >= '0') && (*num<='9'));
+        delete_item(c, &hooks);
     }
-    /* Fractional part? */
-    if ((*num == '.') && (num[1] >= '0') && (num[1] <= '9'))
+}
+
+/* Arena allocator: memory is bump allocated from big chunks and only given back all at once. */
+typedef struct arena_chunk
+{
+    struct arena_chunk *next;
+    size_t size; /* usable bytes after the header */
+    size_t used;
+} arena_chunk;
+
+struct cJSON_Arena
+{
+    /* the chunk that is currently allocated from comes first */
+    arena_chunk *chunks;
+    size_t chunk_size;
+};
+
+/* every type a cJSON tree stores has to be suitably aligned */
+typedef union
+{
+    double d;
+    void *p;
+    long l;
+} arena_alignment;
+
+#define ARENA_ALIGN(size) ((((size) + sizeof(arena_alignment) - 1) / sizeof(arena_alignment)) * sizeof(arena_alignment))
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(arena_chunk))
+#define ARENA_DEFAULT_CHUNK_SIZE 65536
+
+static arena_chunk *arena_new_chunk(size_t size)
+{
+    arena_chunk *chunk = (arena_chunk*)cJSON_malloc(ARENA_HEADER_SIZE + size);
+    if (!chunk)
     {
-        num++;
-        do
-        {
-            n = (n  *10.0) + (*num++ - '0');
-            scale--;
-        } while ((*num >= '0') && (*num <= '9'));
+        return NULL;
     }
-    /* Exponent? */
-    if ((*num == 'e') || (*num == 'E'))
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+static void *arena_allocate(void *context, size_t size)
+{
+    cJSON_Arena *arena = (cJSON_Arena*)context;
+    arena_chunk *chunk = arena->chunks;
+    void *pointer = NULL;
+
+    size = ARENA_ALIGN(size);
+    if (!chunk || ((chunk->size - chunk->used) < size))
     {
-        num++;
-        /* With sign? */
-        if (*num == '+')
+        if (size > (arena->chunk_size / 4))
         {
-            num++;
-        }
-        else if (*num == '-')
-        {
-            signsubscale = -1;
-            num++;
+            /* big allocations get a chunk of their own, so the current one can still be filled up */
+            chunk = arena_new_chunk(size);
+            if (!chunk)
+            {
+                return NULL;
+            }
+            chunk->used = size;
+            if (arena->chunks)
+            {
+                chunk->next = arena->chunks->next;
+                arena->chunks->next = chunk;
+            }
+            else
+            {
+                arena->chunks = chunk;
+            }
+
+            return ((char*)chunk) + ARENA_HEADER_SIZE;
         }
-        /* Number? */
-        while ((*num>='0') && (*num<='9'))
+
+        chunk = arena_new_chunk(arena->chunk_size);
+        if (!chunk)
         {
-            subscale = (subscale * 10) + (*num++ - '0');
+            return NULL;
         }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
     }
 
-    /* number = +/- number.fraction * 10^+/- exponent */
-    n = sign * n * pow(10.0, (scale + subscale * signsubscale));
+    pointer = ((char*)chunk) + ARENA_HEADER_SIZE + chunk->used;
+    chunk->used += size;
 
-    item->valuedouble = n;
-    item->valueint = (int)n;
-    item->type = cJSON_Number;
+    return pointer;
+}
 
-    return num;
+static void arena_deallocate(void *context, void *pointer)
+{
+    /* memory is only given back by cJSON_ArenaReset or cJSON_DeleteArena */
+    (void)context;
+    (void)pointer;
 }
 
-/* calculate the next largest power of 2 */
-static int pow2gt (int x)
+cJSON_Arena *cJSON_CreateArena(size_t chunk_size)
 {
-    --x;
+    cJSON_Arena *arena = (cJSON_Arena*)cJSON_malloc(sizeof(cJSON_Arena));
+    if (!arena)
+    {
+        return NULL;
+    }
+    arena->chunks = NULL;
+    arena->chunk_size = chunk_size ? ARENA_ALIGN(chunk_size) : ARENA_DEFAULT_CHUNK_SIZE;
 
-    x |= x >> 1;
-    x |= x >> 2;
-    x |= x >> 4;
-#if INTEGER_SIZE & 0x1110 /* at least 16 bit */
-    x |= x >> 8;
-#endif
-#if INTEGER_SIZE & 0x1100 /* at least 32 bit */
-    x |= x >> 16;
-#endif
-#if INT_SIZE & 0x1000 /* 64 bit */
-    x |= x >> 32;
-#endif
+    return arena;
+}
 
-    return x + 1;
+void cJSON_ArenaReset(cJSON_Arena *arena)
+{
+    arena_chunk *chunk = NULL;
+    arena_chunk *next = NULL;
+    arena_chunk *keep = NULL;
+
+    if (!arena)
+    {
+        return;
+    }
+
+    /* free everything but one regular sized chunk, which is reused by the next parse */
+    for (chunk = arena->chunks; chunk; chunk = next)
+    {
+        next = chunk->next;
+        if (!keep && (chunk->size == arena->chunk_size))
+        {
+            keep = chunk;
+            keep->next = NULL;
+            keep->used = 0;
+        }
+        else
+        {
+            cJSON_free(chunk);
+        }
+    }
+    arena->chunks = keep;
 }
 
-typedef struct
+void cJSON_GetArenaAllocator(cJSON_Arena *arena, cJSON_Allocator *allocator)
 {
-    char *buffer;
-    int length;
-    int offset;
-    cjbool noalloc;
-} printbuffer;
+    if (!allocator)
+    {
+        return;
+    }
+    allocator->context = arena;
+    allocator->malloc_fn = arena_allocate;
+    allocator->realloc_fn = NULL;
+    allocator->free_fn = arena_deallocate;
+}
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static char* ensure(printbuffer *p, int needed)
+void cJSON_DeleteArena(cJSON_Arena *arena)
 {
-    char *newbuffer = NULL;
-    int newsize = 0;
-    if (!p || !p->buffer)
+    if (!arena)
     {
-        return NULL;
+        return;
     }
-    needed += p->offset;
-    if (needed <= p->length)
+    cJSON_ArenaReset(arena);
+    if (arena->chunks)
     {
-        return p->buffer + p->offset;
+        cJSON_free(arena->chunks);
     }
+    cJSON_free(arena);
+}
 
-    if (p->noalloc) {
-        return NULL;
+/* Move all chunks of from into arena, so they are released together. The chunk arena allocates from stays first. */
+static void arena_adopt(cJSON_Arena * const arena, cJSON_Arena * const from)
+{
+    arena_chunk *last = NULL;
+    if (!from->chunks)
+    {
+        return;
     }
 
-    newsize = pow2gt(needed);
-    newbuffer = (char*)cJSON_malloc(newsize);
-    if (!newbuffer)
+    if (!arena->chunks)
     {
-        cJSON_free(p->buffer);
-        p->length = 0;
-        p->buffer = NULL;
+        arena->chunks = from->chunks;
+    }
+    else
+    {
+        for (last = from->chunks; last->next; last = last->next)
+        {
+        }
+        last->next = arena->chunks->next;
+        arena->chunks->next = from->chunks;
+    }
+    from->chunks = NULL;
+}
+
+typedef struct
+{
+    const char *string;
+    size_t length;
+    unsigned long hash;
+} string_table_entry;
+
+struct cJSON_StringTable
+{
+    /* the strings themselves, they are only released together */
+    cJSON_Arena *strings;
+    /* open addressing hash table (linear probing), at most half full */
+    string_table_entry *entries;
+    size_t size; /* 0 or a power of 2 */
+    size_t count;
+};
+
+#define STRING_TABLE_MIN_SIZE 64
+
+/* FNV-1a, like index_hash but byte exact */
+static unsigned long string_hash(const char *string, size_t length)
+{
+    const unsigned char *ptr = (const unsigned char*)string;
+    unsigned long hash = 2166136261UL;
+    for (; length > 0; length--, ptr++)
+    {
+        hash ^= (unsigned long)*ptr;
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return hash;
+}
 
+cJSON_StringTable *cJSON_CreateStringTable(void)
+{
+    cJSON_StringTable *table = (cJSON_StringTable*)cJSON_malloc(sizeof(cJSON_StringTable));
+    if (!table)
+    {
         return NULL;
     }
-    if (newbuffer)
+    memset(table, '\0', sizeof(cJSON_StringTable));
+    table->strings = cJSON_CreateArena(0);
+    if (!table->strings)
     {
-        memcpy(newbuffer, p->buffer, p->length);
+        cJSON_free(table);
+        return NULL;
     }
-    cJSON_free(p->buffer);
-    p->length = newsize;
-    p->buffer = newbuffer;
 
-    return newbuffer + p->offset;
+    return table;
 }
 
-/* calculate the new length of the string in a printbuffer */
-static int update(const printbuffer *p)
+void cJSON_DeleteStringTable(cJSON_StringTable *table)
 {
-    char *str = NULL;
-    if (!p || !p->buffer)
+    if (!table)
     {
-        return 0;
+        return;
     }
-    str = p->buffer + p->offset;
-
-    return p->offset + strlen(str);
+    cJSON_DeleteArena(table->strings);
+    if (table->entries)
+    {
+        cJSON_free(table->entries);
+    }
+    cJSON_free(table);
 }
 
-/* Render the number nicely from the given item into a string. */
-static char *print_number(const cJSON *item, printbuffer *p)
+static cjbool string_table_grow(cJSON_StringTable * const table)
 {
-    char *str = NULL;
-    double d = item->valuedouble;
-    /* special case for 0. */
-    if (d == 0)
+    const size_t size = (table->size > 0) ? (table->size * 2) : STRING_TABLE_MIN_SIZE;
+    string_table_entry *entries = (string_table_entry*)cJSON_malloc(size * sizeof(string_table_entry));
+    size_t slot = 0;
+    size_t i = 0;
+    if (!entries)
     {
-        if (p)
-        {
-            str = ensure(p, 2);
-        }
-        else
-        {
-            str = (char*)cJSON_malloc(2);
-        }
-        if (str)
-        {
-            strcpy(str,"0");
-        }
+        return false;
     }
-    /* value is an int */
-    else if ((fabs(((double)item->valueint) - d) <= DBL_EPSILON) && (d <= INT_MAX) && (d >= INT_MIN))
+    memset(entries, '\0', size * sizeof(string_table_entry));
+
+    for (i = 0; i < table->size; i++)
     {
-        if (p)
-        {
-            str = ensure(p, 21);
-        }
-        else
+        if (table->entries[i].string)
         {
-            /* 2^64+1 can be represented in 21 chars. */
-            str = (char*)cJSON_malloc(21);
-        }
-        if (str)
-        {
-            sprintf(str, "%d", item->valueint);
+            for (slot = (size_t)table->entries[i].hash & (size - 1); entries[slot].string; slot = (slot + 1) & (size - 1))
+            {
+            }
+            entries[slot] = table->entries[i];
         }
     }
-    /* value is a floating point number */
-    else
+    if (table->entries)
     {
-        if (p)
-        {
-            /* This is a nice tradeoff. */
-            str = ensure(p, 64);
-        }
-        else
-        {
-            /* This is a nice tradeoff. */
-            str=(char*)cJSON_malloc(64);
-        }
-        if (str)
-        {
-            /* This checks for NaN and Infinity */
-            if ((d * 0) != 0)
-            {
-                sprintf(str, "null");
-            }
-            else if ((fabs(floor(d) - d) <= DBL_EPSILON) && (fabs(d) < 1.0e60))
-            {
-                sprintf(str, "%.0f", d);
-            }
-            else if ((fabs(d) < 1.0e-6) || (fabs(d) > 1.0e9))
-            {
-                sprintf(str, "%e", d);
-            }
-            else
-            {
-                sprintf(str, "%f", d);
-            }
-        }
+        cJSON_free(table->entries);
     }
-    return str;
+    table->entries = entries;
+    table->size = size;
+
+    return true;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const char *str)
+/* The table's copy of the length bytes at string (zero terminated), added if it isn't in there yet. NULL if out of memory. */
+static const char *string_table_intern(cJSON_StringTable * const table, const char * const string, const size_t length)
 {
-    unsigned h = 0;
-    /* first digit */
-    if ((*str >= '0') && (*str <= '9'))
+    const unsigned long hash = string_hash(string, length);
+    string_table_entry *entry = NULL;
+    char *copy = NULL;
+    size_t slot = 0;
+
+    if (((table->count + 1) * 2 > table->size) && !string_table_grow(table))
     {
-        h += (*str) - '0';
+        return NULL;
     }
-    else if ((*str >= 'A') && (*str <= 'F'))
+    for (slot = (size_t)hash & (table->size - 1); table->entries[slot].string; slot = (slot + 1) & (table->size - 1))
     {
-        h += 10 + (*str) - 'A';
+        entry = table->entries + slot;
+        if ((entry->hash == hash) && (entry->length == length) && !memcmp(entry->string, string, length))
+        {
+            return entry->string;
+        }
     }
-    else if ((*str >= 'a') && (*str <= 'f'))
+
+    copy = (char*)arena_allocate(table->strings, length + 1);
+    if (!copy)
     {
-        h += 10 + (*str) - 'a';
+        return NULL;
     }
-    else /* invalid */
+    memcpy(copy, string, length);
+    copy[length] = '\0';
+    entry = table->entries + slot;
+    entry->string = copy;
+    entry->length = length;
+    entry->hash = hash;
+    table->count++;
+
+    return copy;
+}
+
+const char *cJSON_InternString(cJSON_StringTable *table, const char *string)
+{
+    return (table && string) ? string_table_intern(table, string, strlen(string)) : NULL;
+}
+
+/* state of a single parse, so parsing never has to touch global variables */
+typedef struct
+{
+    /* start of the input, error positions are relative to it */
+    const char *content;
+    /* one past the last byte of the input, nothing at or after it is read. A zero byte ends the input as well,
+     * NULL if that is the only end (the zero terminated entry points don't need a strlen). */
+    const char *end;
+    /* where and why parsing failed */
+    const char *error;
+    int error_code;
+    const internal_hooks *hooks;
+    /* arrays and objects with at least this many children get an index, 0 for none */
+    size_t index_threshold;
+    /* arrays and objects become lazy nodes, parsed when they are first accessed */
+    cjbool lazy;
+    /* the input has been checked already (a lazy node is being materialized) */
+    cjbool validated;
+    /* keys, and string values up to intern_value_length bytes, are taken from here (NULL for none) */
+    cJSON_StringTable *strings;
+    size_t intern_value_length;
+    /* the input is writable, strings are unescaped where they are and the tree points into it */
+    cjbool in_place;
+#ifdef CJSON_STATS
+    /* arrays and objects currently being parsed */
+    unsigned long depth;
+#endif
+} parse_buffer;
+
+/* is ptr before the end of the input? Without an end the input is zero terminated, and the zero is the end. */
+static cjbool before_end(const char * const ptr, const char * const end)
+{
+    return !end || (ptr < end);
+}
+
+/* is the input at ptr the given character (and not past the end)? */
+static cjbool is_char(const parse_buffer * const buffer, const char * const ptr, const char character)
+{
+    return before_end(ptr, buffer->end) && (*ptr == character);
+}
+
+/* is the input at ptr a digit? */
+static cjbool is_digit(const parse_buffer * const buffer, const char * const ptr)
+{
+    return before_end(ptr, buffer->end) && (*ptr >= '0') && (*ptr <= '9');
+}
+
+/* does the input at ptr start with the literal? */
+static cjbool starts_with(const parse_buffer * const buffer, const char * const ptr, const char * const literal, const size_t length)
+{
+    if (!buffer->end)
     {
-        return 0;
+        /* stops at the terminating zero */
+        return !strncmp(ptr, literal, length);
     }
+    return ((size_t)(buffer->end - ptr) >= length) && !memcmp(ptr, literal, length);
+}
 
+/* remember where and why parsing failed, always returns NULL */
+static const char *parse_error(parse_buffer * const buffer, const char *position, int code)
+{
+    buffer->error = position;
+    buffer->error_code = code;
 
-    /* second digit */
-    h = h << 4;
-    str++;
-    if ((*str >= '0') && (*str <= '9'))
+    return NULL;
+}
+
+/* powers of ten that are exact as a double */
+static const double exact_powers_of_ten[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAX_EXACT_POWER_OF_TEN 22
+/* integers up to 2^53 are exact as a double */
+#define MAX_EXACT_MANTISSA (((cjuint64)1) << 53)
+/* significant digits that always fit into the 64 bit mantissa */
+#define MAX_MANTISSA_DIGITS 19
+
+/* With wider intermediate results (x87) the fast path rounds twice, so everything goes through strtod there. */
+#if !defined(FLT_EVAL_METHOD) || (FLT_EVAL_METHOD == 0) || (FLT_EVAL_METHOD == 1)
+    #define NUMBER_FAST_PATH
+#endif
+
+/* Exactly convert mantissa * 10^exponent if that is possible with a single correctly rounded
+ * multiplication or division (Clinger's fast path). Returns false if it isn't. */
+static cjbool convert_number_fast(cjuint64 mantissa, int exponent, double * const number)
+{
+#ifdef NUMBER_FAST_PATH
+    if (mantissa == 0)
     {
-        h += (*str) - '0';
+        *number = 0;
+        return true;
     }
-    else if ((*str >= 'A') && (*str <= 'F'))
+    if (mantissa > MAX_EXACT_MANTISSA)
     {
-        h += 10 + (*str) - 'A';
+        return false;
     }
-    else if ((*str >= 'a') && (*str <= 'f'))
+    if ((exponent < 0) && (exponent >= -MAX_EXACT_POWER_OF_TEN))
     {
-        h += 10 + (*str) - 'a';
+        *number = (double)mantissa / exact_powers_of_ten[-exponent];
+        return true;
     }
-    else /* invalid */
+    /* something like 12e30 still works if the mantissa stays exact with a part of the exponent moved into it */
+    while ((exponent > MAX_EXACT_POWER_OF_TEN) && (mantissa <= (MAX_EXACT_MANTISSA / 10)))
     {
-        return 0;
+        mantissa *= 10;
+        exponent--;
     }
-
-    /* third digit */
-    h = h << 4;
-    str++;
-    if ((*str >= '0') && (*str <= '9'))
+    if ((exponent >= 0) && (exponent <= MAX_EXACT_POWER_OF_TEN))
     {
-        h += (*str) - '0';
+        *number = (double)mantissa * exact_powers_of_ten[exponent];
+        return true;
     }
-    else if ((*str >= 'A') && (*str <= 'F'))
+#else
+    (void)mantissa;
+    (void)exponent;
+    (void)number;
+#endif
+
+    return false;
+}
+
+/* get the decimal point character of the current locale */
+static char get_decimal_point(void)
+{
+    struct lconv *lconv = localeconv();
+    return (lconv && lconv->decimal_point && lconv->decimal_point[0]) ? lconv->decimal_point[0] : '.';
+}
+
+/* Convert the number text between start and end with strtod, which is always exact but a lot slower.
+ * strtod expects the decimal point of the current locale, so it gets a copy that uses that one. */
+static cjbool convert_number_slow(const char *start, const char *end, double * const number, parse_buffer * const buffer)
+{
+    char small_copy[64];
+    char *copy = small_copy;
+    const size_t length = (size_t)(end - start);
+    const char decimal_point = get_decimal_point();
+    size_t i = 0;
+
+    if (length >= sizeof(small_copy))
     {
-        h += 10 + (*str) - 'A';
+        copy = (char*)buffer->hooks->allocate(buffer->hooks->context, length + 1);
+        if (!copy)
+        {
+            return false;
+        }
     }
-    else if ((*str >= 'a') && (*str <= 'f'))
+    for (i = 0; i < length; i++)
     {
-        h += 10 + (*str) - 'a';
+        copy[i] = (start[i] == '.') ? decimal_point : start[i];
     }
-    else /* invalid */
+    copy[length] = '\0';
+
+    *number = strtod(copy, NULL);
+
+    if (copy != small_copy)
     {
-        return 0;
+        buffer->hooks->deallocate(buffer->hooks->context, copy);
     }
 
-    /* fourth digit */
-    h = h << 4;
-    str++;
-    if ((*str >= '0') && (*str <= '9'))
+    return true;
+}
+
+/* magnitude of the smallest cJSON_int64, 2^63 */
+#define MIN_INT64_MAGNITUDE (((cjuint64)1) << 63)
+
+/* the cJSON_int64 with the given magnitude (at most MIN_INT64_MAGNITUDE if negative) and sign */
+static cJSON_int64 int64_from_magnitude(const cjuint64 magnitude, const cjbool negative)
+{
+    if (!negative)
     {
-        h += (*str) - '0';
+        return (cJSON_int64)magnitude;
     }
-    else if ((*str >= 'A') && (*str <= 'F'))
+    if (magnitude == 0)
     {
-        h += 10 + (*str) - 'A';
+        return 0;
     }
-    else if ((*str >= 'a') && (*str <= 'f'))
+    /* -2^63 doesn't have a positive counterpart */
+    return -(cJSON_int64)(magnitude - 1) - 1;
+}
+
+/* valueint for a number, saturated instead of overflowing */
+static int clamp_to_int(const double number)
+{
+    if (number >= INT_MAX)
     {
-        h += 10 + (*str) - 'a';
+        return INT_MAX;
     }
-    else /* invalid */
+    if (number <= INT_MIN)
     {
-        return 0;
+        return INT_MIN;
     }
 
-    return h;
+    return (int)number;
 }
 
-/* first bytes of UTF8 encoding for a given length in bytes */
-static const unsigned char firstByteMark[7] =
-{
-    0x00, /* should never happen */
-    0x00, /* 0xxxxxxx */
-    0xC0, /* 110xxxxx */
-    0xE0, /* 1110xxxx */
-    0xF0, /* 11110xxx */
-    0xF8,
-    0xFC
-};
-
-/* Parse the input text into an unescaped cstring, and populate item. */
-static const char *parse_string(cJSON *item, const char *str, const char **ep)
+/* Parse the input text to generate a number, and populate the result into item. */
+static const char *parse_number(cJSON *item, const char *num, parse_buffer * const buffer)
 {
-    const char *ptr = str + 1;
-    const char *end_ptr =str + 1;
-    char *ptr2 = NULL;
-    char *out = NULL;
-    int len = 0;
-    unsigned uc = 0;
-    unsigned uc2 = 0;
+    const char *start = num;
+    double n = 0;
+    cjbool negative = false;
+    /* the significant digits, as long as they fit */
+    cjuint64 mantissa = 0;
+    int digits = 0;
+    cjbool truncated = false;
+    /* of the mantissa, including the exponent part of the number */
+    int exponent = 0;
+    int subscale = 0;
+    int signsubscale = 1;
+    /* no fraction and no exponent */
+    cjbool integer = true;
 
-    /* not a string! */
-    if (*str != '\"')
+    /* Has sign? */
+    if (is_char(buffer, num, '-'))
     {
-        *ep = str;
-        return NULL;
+        negative = true;
+        num++;
     }
-
-    while ((*end_ptr != '\"') && *end_ptr)
+    /* is zero */
+    if (is_char(buffer, num, '0'))
     {
-        if (*end_ptr++ == '\\')
+        num++;
+    }
+    /* Number? */
+    if (is_digit(buffer, num) && (*num != '0'))
+    {
+        do
         {
-            if (*end_ptr == '\0')
+            if (digits < MAX_MANTISSA_DIGITS)
             {
-                /* prevent buffer overflow when last input character is a backslash */
-                return NULL;
+                mantissa = (mantissa * 10) + (cjuint64)(*num - '0');
+                digits++;
             }
-            /* Skip escaped quotes. */
-            end_ptr++;
+            else
+            {
+                truncated = true;
+            }
+            num++;
         }
-        len++;
+        while (is_digit(buffer, num));
     }
-
-    /* This is at most how long we need for the string, roughly. */
-    out = (char*)cJSON_malloc(len + 1);
-    if (!out)
+    /* Fractional part? */
+    if (is_char(buffer, num, '.') && is_digit(buffer, num + 1))
     {
-        return NULL;
+        integer = false;
+        num++;
+        do
+        {
+            if (digits < MAX_MANTISSA_DIGITS)
+            {
+                /* leading zeros of the fraction aren't significant */
+                if ((mantissa != 0) || (*num != '0'))
+                {
+                    digits++;
+                }
+                mantissa = (mantissa * 10) + (cjuint64)(*num - '0');
+                exponent--;
+            }
+            else
+            {
+                truncated = true;
+            }
+            num++;
+        } while (is_digit(buffer, num));
     }
-    item->valuestring = out; /* assign here so out will be deleted during cJSON_Delete() later */
-    item->type = cJSON_String;
-
-    ptr = str + 1;
-    ptr2 = out;
-    /* loop through the string literal */
-    while (ptr < end_ptr)
+    /* Exponent? */
+    if (is_char(buffer, num, 'e') || is_char(buffer, num, 'E'))
     {
-        if (*ptr != '\\')
+        integer = false;
+        num++;
+        /* With sign? */
+        if (is_char(buffer, num, '+'))
         {
-            *ptr2++ = *ptr++;
+            num++;
         }
-        /* escape sequence */
-        else
+        else if (is_char(buffer, num, '-'))
         {
-            ptr++;
-            switch (*ptr)
+            signsubscale = -1;
+            num++;
+        }
+        /* Number? */
+        while (is_digit(buffer, num))
+        {
+            /* anything this big is 0 or infinity anyway, don't let it overflow */
+            if (subscale < 100000)
             {
-                case 'b':
-                    *ptr2++ = '\b';
-                    break;
-                case 'f':
-                    *ptr2++ = '\f';
-                    break;
-                case 'n':
-                    *ptr2++ = '\n';
-                    break;
-                case 'r':
-                    *ptr2++ = '\r';
-                    break;
-                case 't':
-                    *ptr2++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *ptr2++ = *ptr;
-                    break;
-                case 'u':
-                    /* transcode utf16 to utf8. See RFC2781 and RFC3629. */
-                    uc = parse_hex4(ptr + 1); /* get the unicode char. */
-                    ptr += 4;
-                    if (ptr >= end_ptr)
-                    {
-                        /* invalid */
-                        *ep = str;
-                        return NULL;
-                    }
-                    /* check for invalid. */
-                    if (((uc >= 0xDC00) && (uc <= 0xDFFF)) || (uc == 0))
-                    {
-                        *ep = str;
-                        return NULL;
-                    }
+                subscale = (subscale * 10) + (*num - '0');
+            }
+            num++;
+        }
+    }
+    exponent += subscale * signsubscale;
 
-                    /* UTF16 surrogate pairs. */
-                    if ((uc >= 0xD800) && (uc<=0xDBFF))
-                    {
-                        if ((ptr + 6) > end_ptr)
-                        {
-                            /* invalid */
-                            *ep = str;
-                            return NULL;
-                        }
-                        if ((ptr[1] != '\\') || (ptr[2] != 'u'))
-                        {
-                            /* missing second-half of surrogate. */
-                            *ep = str;
-                            return NULL;
-                        }
-                        uc2 = parse_hex4(ptr + 3);
-                        ptr += 6; /* \uXXXX */
-                        if ((uc2 < 0xDC00) || (uc2 > 0xDFFF))
-                        {
-                            /* invalid second-half of surrogate. */
-                            *ep = str;
-                            return NULL;
-                        }
-                        /* calculate unicode codepoint from the surrogate pair */
-                        uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
-                    }
+    /* number = +/- mantissa * 10^exponent */
+    if (!truncated && convert_number_fast(mantissa, exponent, &n))
+    {
+        if (negative)
+        {
+            n = -n;
+        }
+    }
+    else if (!convert_number_slow(start, num, &n, buffer))
+    {
+        return parse_error(buffer, start, cJSON_Error_Memory);
+    }
 
-                    /* encode as UTF8
-                     * takes at maximum 4 bytes to encode:
-                     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-                    len = 4;
-                    if (uc < 0x80)
-                    {
-                        /* normal ascii, encoding 0xxxxxxx */
-                        len = 1;
-                    }
-                    else if (uc < 0x800)
-                    {
-                        /* two bytes, encoding 110xxxxx 10xxxxxx */
-                        len = 2;
-                    }
-                    else if (uc < 0x10000)
-                    {
-                        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-                        len = 3;
-                    }
-                    ptr2 += len;
-
-                    switch (len) {
-                        case 4:
-                            /* 10xxxxxx */
-                            *--ptr2 = ((uc | 0x80) & 0xBF);
-                            uc >>= 6;
-                        case 3:
-                            /* 10xxxxxx */
-                            *--ptr2 = ((uc | 0x80) & 0xBF);
-                            uc >>= 6;
-                        case 2:
-                            /* 10xxxxxx */
-                            *--ptr2 = ((uc | 0x80) & 0xBF);
-                            uc >>= 6;
-                        case 1:
-                            /* depending on the length in bytes this determines the
-                             * encoding ofthe first UTF8 byte */
-                            *--ptr2 = (uc | firstByteMark[len]);
-                    }
-                    ptr2 += len;
-                    break;
-                default:
-                    *ep = str;
-                    return NULL;
-            }
-            ptr++;
-        }
-    }
-    *ptr2 = '\0';
-    if (*ptr == '\"')
+    item->valuedouble = n;
+    item->valueint = clamp_to_int(n);
+    item->type = cJSON_Number;
+    if (integer && !truncated && (mantissa <= (negative ? MIN_INT64_MAGNITUDE : (MIN_INT64_MAGNITUDE - 1))))
     {
-        ptr++;
+        /* keep the exact value, the double can't represent every integer beyond 2^53 */
+        item->valueint64 = int64_from_magnitude(mantissa, negative);
+        item->type |= cJSON_NumberIsInt64;
     }
 
-    return ptr;
+    return num;
 }
 
-/* Render the cstring provided to an escaped version that can be printed. */
-static char *print_string_ptr(const char *str, printbuffer *p)
+/* calculate the next largest power of 2 */
+static int pow2gt (int x)
 {
-    const char *ptr = NULL;
-    char *ptr2 = NULL;
-    char *out = NULL;
-    int len = 0;
-    cjbool flag = false;
-    unsigned char token = '\0';
+    --x;
 
-    /* empty string */
-    if (!str)
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+#if INTEGER_SIZE & 0x1110 /* at least 16 bit */
+    x |= x >> 8;
+#endif
+#if INTEGER_SIZE & 0x1100 /* at least 32 bit */
+    x |= x >> 16;
+#endif
+#if INT_SIZE & 0x1000 /* 64 bit */
+    x |= x >> 32;
+#endif
+
+    return x + 1;
+}
+
+typedef struct
+{
+    char *buffer;
+    int length;
+    int offset;
+    cjbool noalloc;
+    const internal_hooks *hooks;
+    /* if set, a full buffer is handed to write_fn and reused instead of growing it */
+    cJSON_WriteFunction write_fn;
+    void *write_context;
+} printbuffer;
+
+/* pass everything in the buffer on to the writer of p */
+static cjbool flush_printbuffer(printbuffer * const p)
+{
+    if (p->offset > 0)
     {
-        if (p)
+        if (!p->write_fn(p->write_context, p->buffer, (size_t)p->offset))
         {
-            out = ensure(p, 3);
+            return false;
         }
-        else
+        p->offset = 0;
+    }
+
+    return true;
+}
+
+/* realloc printbuffer if necessary to have at least "needed" bytes more */
+static char* ensure(printbuffer *p, int needed)
+{
+    char *newbuffer = NULL;
+    int newsize = 0;
+    if (!p || !p->buffer)
+    {
+        return NULL;
+    }
+    if ((p->offset + needed) <= p->length)
+    {
+        return p->buffer + p->offset;
+    }
+    if (p->write_fn)
+    {
+        /* make room by writing out what is there */
+        if (!flush_printbuffer(p))
         {
-            out = (char*)cJSON_malloc(3);
+            return NULL;
         }
-        if (!out)
+        if (needed <= p->length)
         {
-            return NULL;
+            return p->buffer;
         }
-        strcpy(out, "\"\"");
+    }
+    needed += p->offset;
 
-        return out;
+    if (p->noalloc) {
+        return NULL;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (ptr = str; *ptr; ptr++)
+    newsize = pow2gt(needed);
+    if (p->hooks->reallocate)
     {
-        flag |= (((*ptr > 0) && (*ptr < 32)) /* unprintable characters */
-                || (*ptr == '\"') /* double quote */
-                || (*ptr == '\\')) /* backslash */
-            ? 1
-            : 0;
+        /* reallocate with realloc if available */
+        newbuffer = (char*)p->hooks->reallocate(p->hooks->context, p->buffer, newsize);
     }
-    /* no characters have to be escaped */
-    if (!flag)
+    else
     {
-        len = ptr - str;
-        if (p)
+        /* otherwise reallocate manually */
+        newbuffer = (char*)p->hooks->allocate(p->hooks->context, newsize);
+        if (newbuffer)
         {
-            out = ensure(p, len + 3);
+            memcpy(newbuffer, p->buffer, p->length);
+            p->hooks->deallocate(p->hooks->context, p->buffer);
+            p->buffer = NULL;
         }
-        else
+    }
+    if (!newbuffer)
+    {
+        p->hooks->deallocate(p->hooks->context, p->buffer);
+        p->length = 0;
+        p->buffer = NULL;
+
+        return NULL;
+    }
+    p->length = newsize;
+    p->buffer = newbuffer;
+    STATS_ADD(buffer_reallocations, 1);
+
+    return newbuffer + p->offset;
+}
+
+/* append length bytes of text */
+static cjbool print_raw(printbuffer * const p, const char * const text, const int length)
+{
+    char *out = ensure(p, length);
+    if (!out)
+    {
+        return false;
+    }
+    memcpy(out, text, (size_t)length);
+    p->offset += length;
+
+    return true;
+}
+
+/* append depth tabs */
+static cjbool print_indentation(printbuffer * const p, const int depth)
+{
+    char *out = ensure(p, depth);
+    if (!out)
+    {
+        return false;
+    }
+    memset(out, '\t', (size_t)depth);
+    p->offset += depth;
+
+    return true;
+}
+
+/* "00" to "99", so integers can be printed two digits at a time */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Write number to str (at least 20 characters, no terminating zero is written), returns the number of characters. */
+static size_t print_int64(char * const str, const cJSON_int64 number)
+{
+    char digits[20];
+    char *end = digits + sizeof(digits);
+    char *ptr = end;
+    size_t length = 0;
+    /* the magnitude of negative numbers, computed in unsigned so -2^63 doesn't overflow */
+    cjuint64 magnitude = (number < 0) ? ((cjuint64)0 - (cjuint64)number) : (cjuint64)number;
+    size_t pair = 0;
+
+    while (magnitude >= 100)
+    {
+        pair = (size_t)(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--ptr = digit_pairs[pair + 1];
+        *--ptr = digit_pairs[pair];
+    }
+    if (magnitude >= 10)
+    {
+        pair = (size_t)magnitude * 2;
+        *--ptr = digit_pairs[pair + 1];
+        *--ptr = digit_pairs[pair];
+    }
+    else
+    {
+        *--ptr = (char)('0' + magnitude);
+    }
+
+    if (number < 0)
+    {
+        str[length++] = '-';
+    }
+    memcpy(str + length, ptr, (size_t)(end - ptr));
+
+    return length + (size_t)(end - ptr);
+}
+
+/* Printing doubles with the shortest text that is read back as the same double, using Grisu2 from
+ * Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers" (PLDI 2010).
+ * This needs IEEE 754 doubles, everything else gets 17 significant digits from sprintf. */
+#if (FLT_RADIX == 2) && (DBL_MANT_DIG == 53) && (DBL_MAX_EXP == 1024) && (DBL_MIN_EXP == -1021)
+    #define PRINT_DOUBLE_GRISU
+#endif
+
+#ifdef PRINT_DOUBLE_GRISU
+/* a floating point number f * 2^e with a 64 bit significand */
+typedef struct
+{
+    cjuint64 f;
+    int e;
+} diy_fp;
+
+#define DOUBLE_HIDDEN_BIT (((cjuint64)1) << 52)
+#define DOUBLE_SIGNIFICAND_MASK (DOUBLE_HIDDEN_BIT - 1)
+
+/* 10^-348, 10^-340, ..., 10^340 normalized to 64 bit significands, split into 32 bit halves so they don't need
+ * 64 bit constants. Generated with exact rational arithmetic and rounded to nearest. */
+typedef struct
+{
+    unsigned long high;
+    unsigned long low;
+    int e;
+} cached_power;
+
+static const cached_power cached_powers[] =
+{
+    {0xFA8FD5A0, 0x081C0288, -1220}, /* 1e-348 */
+    {0xBAAEE17F, 0xA23EBF76, -1193}, /* 1e-340 */
+    {0x8B16FB20, 0x3055AC76, -1166}, /* 1e-332 */
+    {0xCF42894A, 0x5DCE35EA, -1140}, /* 1e-324 */
+    {0x9A6BB0AA, 0x55653B2D, -1113}, /* 1e-316 */
+    {0xE61ACF03, 0x3D1A45DF, -1087}, /* 1e-308 */
+    {0xAB70FE17, 0xC79AC6CA, -1060}, /* 1e-300 */
+    {0xFF77B1FC, 0xBEBCDC4F, -1034}, /* 1e-292 */
+    {0xBE5691EF, 0x416BD60C, -1007}, /* 1e-284 */
+    {0x8DD01FAD, 0x907FFC3C,  -980}, /* 1e-276 */
+    {0xD3515C28, 0x31559A83,  -954}, /* 1e-268 */
+    {0x9D71AC8F, 0xADA6C9B5,  -927}, /* 1e-260 */
+    {0xEA9C2277, 0x23EE8BCB,  -901}, /* 1e-252 */
+    {0xAECC4991, 0x4078536D,  -874}, /* 1e-244 */
+    {0x823C1279, 0x5DB6CE57,  -847}, /* 1e-236 */
+    {0xC2109436, 0x4DFB5637,  -821}, /* 1e-228 */
+    {0x9096EA6F, 0x3848984F,  -794}, /* 1e-220 */
+    {0xD77485CB, 0x25823AC7,  -768}, /* 1e-212 */
+    {0xA086CFCD, 0x97BF97F4,  -741}, /* 1e-204 */
+    {0xEF340A98, 0x172AACE5,  -715}, /* 1e-196 */
+    {0xB23867FB, 0x2A35B28E,  -688}, /* 1e-188 */
+    {0x84C8D4DF, 0xD2C63F3B,  -661}, /* 1e-180 */
+    {0xC5DD4427, 0x1AD3CDBA,  -635}, /* 1e-172 */
+    {0x936B9FCE, 0xBB25C996,  -608}, /* 1e-164 */
+    {0xDBAC6C24, 0x7D62A584,  -582}, /* 1e-156 */
+    {0xA3AB6658, 0x0D5FDAF6,  -555}, /* 1e-148 */
+    {0xF3E2F893, 0xDEC3F126,  -529}, /* 1e-140 */
+    {0xB5B5ADA8, 0xAAFF80B8,  -502}, /* 1e-132 */
+    {0x87625F05, 0x6C7C4A8B,  -475}, /* 1e-124 */
+    {0xC9BCFF60, 0x34C13053,  -449}, /* 1e-116 */
+    {0x964E858C, 0x91BA2655,  -422}, /* 1e-108 */
+    {0xDFF97724, 0x70297EBD,  -396}, /* 1e-100 */
+    {0xA6DFBD9F, 0xB8E5B88F,  -369}, /* 1e-92 */
+    {0xF8A95FCF, 0x88747D94,  -343}, /* 1e-84 */
+    {0xB9447093, 0x8FA89BCF,  -316}, /* 1e-76 */
+    {0x8A08F0F8, 0xBF0F156B,  -289}, /* 1e-68 */
+    {0xCDB02555, 0x653131B6,  -263}, /* 1e-60 */
+    {0x993FE2C6, 0xD07B7FAC,  -236}, /* 1e-52 */
+    {0xE45C10C4, 0x2A2B3B06,  -210}, /* 1e-44 */
+    {0xAA242499, 0x697392D3,  -183}, /* 1e-36 */
+    {0xFD87B5F2, 0x8300CA0E,  -157}, /* 1e-28 */
+    {0xBCE50864, 0x92111AEB,  -130}, /* 1e-20 */
+    {0x8CBCCC09, 0x6F5088CC,  -103}, /* 1e-12 */
+    {0xD1B71758, 0xE219652C,   -77}, /* 1e-4 */
+    {0x9C400000, 0x00000000,   -50}, /* 1e4 */
+    {0xE8D4A510, 0x00000000,   -24}, /* 1e12 */
+    {0xAD78EBC5, 0xAC620000,     3}, /* 1e20 */
+    {0x813F3978, 0xF8940984,    30}, /* 1e28 */
+    {0xC097CE7B, 0xC90715B3,    56}, /* 1e36 */
+    {0x8F7E32CE, 0x7BEA5C70,    83}, /* 1e44 */
+    {0xD5D238A4, 0xABE98068,   109}, /* 1e52 */
+    {0x9F4F2726, 0x179A2245,   136}, /* 1e60 */
+    {0xED63A231, 0xD4C4FB27,   162}, /* 1e68 */
+    {0xB0DE6538, 0x8CC8ADA8,   189}, /* 1e76 */
+    {0x83C7088E, 0x1AAB65DB,   216}, /* 1e84 */
+    {0xC45D1DF9, 0x42711D9A,   242}, /* 1e92 */
+    {0x924D692C, 0xA61BE758,   269}, /* 1e100 */
+    {0xDA01EE64, 0x1A708DEA,   295}, /* 1e108 */
+    {0xA26DA399, 0x9AEF774A,   322}, /* 1e116 */
+    {0xF209787B, 0xB47D6B85,   348}, /* 1e124 */
+    {0xB454E4A1, 0x79DD1877,   375}, /* 1e132 */
+    {0x865B8692, 0x5B9BC5C2,   402}, /* 1e140 */
+    {0xC83553C5, 0xC8965D3D,   428}, /* 1e148 */
+    {0x952AB45C, 0xFA97A0B3,   455}, /* 1e156 */
+    {0xDE469FBD, 0x99A05FE3,   481}, /* 1e164 */
+    {0xA59BC234, 0xDB398C25,   508}, /* 1e172 */
+    {0xF6C69A72, 0xA3989F5C,   534}, /* 1e180 */
+    {0xB7DCBF53, 0x54E9BECE,   561}, /* 1e188 */
+    {0x88FCF317, 0xF22241E2,   588}, /* 1e196 */
+    {0xCC20CE9B, 0xD35C78A5,   614}, /* 1e204 */
+    {0x98165AF3, 0x7B2153DF,   641}, /* 1e212 */
+    {0xE2A0B5DC, 0x971F303A,   667}, /* 1e220 */
+    {0xA8D9D153, 0x5CE3B396,   694}, /* 1e228 */
+    {0xFB9B7CD9, 0xA4A7443C,   720}, /* 1e236 */
+    {0xBB764C4C, 0xA7A44410,   747}, /* 1e244 */
+    {0x8BAB8EEF, 0xB6409C1A,   774}, /* 1e252 */
+    {0xD01FEF10, 0xA657842C,   800}, /* 1e260 */
+    {0x9B10A4E5, 0xE9913129,   827}, /* 1e268 */
+    {0xE7109BFB, 0xA19C0C9D,   853}, /* 1e276 */
+    {0xAC2820D9, 0x623BF429,   880}, /* 1e284 */
+    {0x80444B5E, 0x7AA7CF85,   907}, /* 1e292 */
+    {0xBF21E440, 0x03ACDD2D,   933}, /* 1e300 */
+    {0x8E679C2F, 0x5E44FF8F,   960}, /* 1e308 */
+    {0xD433179D, 0x9C8CB841,   986}, /* 1e316 */
+    {0x9E19DB92, 0xB4E31BA9,  1013}, /* 1e324 */
+    {0xEB96BF6E, 0xBADF77D9,  1039}, /* 1e332 */
+    {0xAF87023B, 0x9BF0EE6B,  1066}  /* 1e340 */
+};
+#define CACHED_POWERS_MIN_EXPONENT (-348)
+#define CACHED_POWERS_STEP 8
+
+static const unsigned long powers_of_ten_32[] =
+{
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+static diy_fp diy_fp_from_double(const double number)
+{
+    diy_fp fp;
+    cjuint64 bits = 0;
+    int biased_exponent = 0;
+
+    memcpy(&bits, &number, sizeof(bits));
+    biased_exponent = (int)((bits >> 52) & 0x7FF);
+    fp.f = bits & DOUBLE_SIGNIFICAND_MASK;
+    if (biased_exponent != 0)
+    {
+        fp.f += DOUBLE_HIDDEN_BIT;
+        fp.e = biased_exponent - 1075;
+    }
+    else
+    {
+        /* subnormal */
+        fp.e = -1074;
+    }
+
+    return fp;
+}
+
+/* the upper 64 bits of the product (rounded) */
+static diy_fp diy_fp_multiply(const diy_fp x, const diy_fp y)
+{
+    const cjuint64 mask = (cjuint64)0xFFFFFFFFUL;
+    const cjuint64 a = x.f >> 32;
+    const cjuint64 b = x.f & mask;
+    const cjuint64 c = y.f >> 32;
+    const cjuint64 d = y.f & mask;
+    const cjuint64 ad = a * d;
+    const cjuint64 bc = b * c;
+    cjuint64 middle = ((b * d) >> 32) + (ad & mask) + (bc & mask);
+    diy_fp product;
+
+    /* round */
+    middle += ((cjuint64)1) << 31;
+    product.f = (a * c) + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    product.e = x.e + y.e + 64;
+
+    return product;
+}
+
+static diy_fp diy_fp_normalize(diy_fp fp)
+{
+    while (!(fp.f & (((cjuint64)1) << 63)))
+    {
+        fp.f <<= 1;
+        fp.e--;
+    }
+
+    return fp;
+}
+
+/* the boundaries between number and its neighbours, minus gets the exponent of plus */
+static void normalized_boundaries(const diy_fp number, diy_fp * const minus, diy_fp * const plus)
+{
+    plus->f = (number.f << 1) + 1;
+    plus->e = number.e - 1;
+    *plus = diy_fp_normalize(*plus);
+
+    if (number.f == DOUBLE_HIDDEN_BIT)
+    {
+        /* the lower neighbour is closer for powers of 2 */
+        minus->f = (number.f << 2) - 1;
+        minus->e = number.e - 2;
+    }
+    else
+    {
+        minus->f = (number.f << 1) - 1;
+        minus->e = number.e - 1;
+    }
+    minus->f <<= minus->e - plus->e;
+    minus->e = plus->e;
+}
+
+/* the cached power of ten c = 10^-k that brings a number with binary exponent e into the range Grisu needs */
+static diy_fp get_cached_power(const int e, int * const k)
+{
+    const double dk = ((-61 - e) * 0.30102999566398114) + 347;
+    int index = (int)dk;
+    diy_fp power;
+
+    if ((dk - index) > 0.0)
+    {
+        index++;
+    }
+    index = (index / CACHED_POWERS_STEP) + 1;
+    *k = -(CACHED_POWERS_MIN_EXPONENT + (index * CACHED_POWERS_STEP));
+
+    power.f = ((cjuint64)cached_powers[index].high << 32) | (cjuint64)cached_powers[index].low;
+    power.e = cached_powers[index].e;
+
+    return power;
+}
+
+/* move the last digit towards the exact value as long as that stays inside the rounding interval */
+static void grisu_round(char * const digits, const int length, const cjuint64 delta, cjuint64 rest, const cjuint64 ten_kappa, const cjuint64 distance)
+{
+    while ((rest < distance) && ((delta - rest) >= ten_kappa)
+            && (((rest + ten_kappa) < distance) || ((distance - rest) > (rest + ten_kappa - distance))))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+/* generate the shortest digits in the interval [plus - delta, plus], number is the exact value */
+static void grisu_digits(const diy_fp number, const diy_fp plus, cjuint64 delta, char * const digits, int * const length, int * const k)
+{
+    const int shift = -plus.e;
+    const cjuint64 one = ((cjuint64)1) << shift;
+    const cjuint64 distance = plus.f - number.f;
+    unsigned long integral = (unsigned long)(plus.f >> shift);
+    cjuint64 fraction = plus.f & (one - 1);
+    cjuint64 rest = 0;
+    int kappa = 10;
+    unsigned long digit = 0;
+
+    /* number of digits of the integral part */
+    while ((kappa > 1) && (integral < powers_of_ten_32[kappa - 1]))
+    {
+        kappa--;
+    }
+
+    *length = 0;
+    while (kappa > 0)
+    {
+        digit = integral / powers_of_ten_32[kappa - 1];
+        integral %= powers_of_ten_32[kappa - 1];
+        if (digit || *length)
         {
-            out = (char*)cJSON_malloc(len + 3);
+            digits[(*length)++] = (char)('0' + digit);
         }
-        if (!out)
+        kappa--;
+        rest = ((cjuint64)integral << shift) + fraction;
+        if (rest <= delta)
         {
-            return NULL;
+            *k += kappa;
+            grisu_round(digits, *length, delta, rest, (cjuint64)powers_of_ten_32[kappa] << shift, distance);
+            return;
         }
-
-        ptr2 = out;
-        *ptr2++ = '\"';
-        strcpy(ptr2, str);
-        ptr2[len] = '\"';
-        ptr2[len + 1] = '\0';
-
-        return out;
     }
 
-    ptr = str;
-    /* calculate additional space that is needed for escaping */
-    while ((token = *ptr))
+    for (;;)
     {
-        ++len;
-        if (strchr("\"\\\b\f\n\r\t", token))
+        fraction *= 10;
+        delta *= 10;
+        digit = (unsigned long)(fraction >> shift);
+        if (digit || *length)
         {
-            len++; /* +1 for the backslash */
+            digits[(*length)++] = (char)('0' + digit);
         }
-        else if (token < 32)
+        fraction &= one - 1;
+        kappa--;
+        if (fraction < delta)
         {
-            len += 5; /* +5 for \uXXXX */
+            *k += kappa;
+            grisu_round(digits, *length, delta, fraction, one, (-kappa < 10) ? (distance * powers_of_ten_32[-kappa]) : 0);
+            return;
         }
-        ptr++;
     }
+}
+
+/* the shortest digits of a positive, finite number = digits * 10^k */
+static void grisu2(const double number, char * const digits, int * const length, int * const k)
+{
+    const diy_fp value = diy_fp_from_double(number);
+    diy_fp minus;
+    diy_fp plus;
+    diy_fp power;
+    diy_fp scaled;
+
+    normalized_boundaries(value, &minus, &plus);
+    power = get_cached_power(plus.e, k);
+    scaled = diy_fp_multiply(diy_fp_normalize(value), power);
+    plus = diy_fp_multiply(plus, power);
+    minus = diy_fp_multiply(minus, power);
+    /* stay inside the interval, the multiplications weren't exact */
+    minus.f++;
+    plus.f--;
+
+    grisu_digits(scaled, plus, plus.f - minus.f, digits, length, k);
+}
+#endif
+
+/* Write a finite, non zero number (at most 26 characters including the terminating zero) to str, returns the length.
+ * Like JavaScript, numbers with up to 21 integral digits are written without exponent, and precision is never lost. */
+static size_t print_double(char * const str, double number)
+{
+#ifdef PRINT_DOUBLE_GRISU
+    char *ptr = str;
+    char digits[32];
+    int length = 0;
+    int k = 0;
+    /* where the decimal point goes, relative to the first digit */
+    int point = 0;
 
-    if (p)
+    if (number < 0)
     {
-        out = ensure(p, len + 3);
+        *ptr++ = '-';
+        number = -number;
     }
-    else
+    grisu2(number, digits, &length, &k);
+    point = length + k;
+
+    if ((length <= point) && (point <= 21))
     {
-        out = (char*)cJSON_malloc(len + 3);
+        /* integer, 1234e7 -> 12340000000 */
+        memcpy(ptr, digits, (size_t)length);
+        memset(ptr + length, '0', (size_t)(point - length));
+        ptr += point;
     }
-    if (!out)
+    else if ((point > 0) && (point <= 21))
     {
-        return NULL;
+        /* 1234e-2 -> 12.34 */
+        memcpy(ptr, digits, (size_t)point);
+        ptr[point] = '.';
+        memcpy(ptr + point + 1, digits + point, (size_t)(length - point));
+        ptr += length + 1;
     }
-
-    ptr2 = out;
-    ptr = str;
-    *ptr2++ = '\"';
-    /* copy the string */
-    while (*ptr)
+    else if ((point > -6) && (point <= 0))
     {
-        if (((unsigned char)*ptr > 31) && (*ptr != '\"') && (*ptr != '\\'))
+        /* 1234e-6 -> 0.001234 */
+        *ptr++ = '0';
+        *ptr++ = '.';
+        memset(ptr, '0', (size_t)-point);
+        memcpy(ptr - point, digits, (size_t)length);
+        ptr += length - point;
+    }
+    else
+    {
+        /* 1234e30 -> 1.234e+33 */
+        *ptr++ = digits[0];
+        if (length > 1)
         {
-            /* normal character, copy */
-            *ptr2++ = *ptr++;
+            *ptr++ = '.';
+            memcpy(ptr, digits + 1, (size_t)(length - 1));
+            ptr += length - 1;
         }
-        else
+        *ptr++ = 'e';
+        if (point > 0)
         {
-            /* character needs to be escaped */
-            *ptr2++ = '\\';
-            switch (token = *ptr++)
-            {
-                case '\\':
-                    *ptr2++ = '\\';
-                    break;
-                case '\"':
-                    *ptr2++ = '\"';
-                    break;
-                case '\b':
-                    *ptr2++ = 'b';
-                    break;
-                case '\f':
-                    *ptr2++ = 'f';
-                    break;
-                case '\n':
-                    *ptr2++ = 'n';
-                    break;
-                case '\r':
-                    *ptr2++ = 'r';
+            /* the sign of negative exponents comes from print_int64 */
+            *ptr++ = '+';
+        }
+        ptr += print_int64(ptr, point - 1);
+    }
+    *ptr = '\0';
+
+    return (size_t)(ptr - str);
+#else
+    sprintf(str, "%.17g", number);
+    return strlen(str);
+#endif
+}
+
+/* Is valueint64 the item's number? Code that assigns valuedouble directly leaves the flag set, the stale integer
+ * no longer matches then and valuedouble wins. */
+static cjbool number_is_int64(const cJSON * const item)
+{
+    return (item->type & cJSON_NumberIsInt64) && ((double)item->valueint64 == item->valuedouble);
+}
+
+/* Render the number nicely from the given item into a string. */
+static cjbool print_number(const cJSON *item, printbuffer * const p)
+{
+    double d = item->valuedouble;
+    size_t length = 0;
+    char number[26];
+    /* 2^64+1 can be represented in 21 chars, every double in 26 */
+    char *str = ensure(p, 26);
+    if (!str)
+    {
+        if (!p->noalloc || !p->buffer)
+        {
+            return false;
+        }
+        /* a preallocated buffer may still have room for the number itself, see cJSON_PrintLength */
+        str = number;
+    }
+
+    /* special case for 0. */
+    if (d == 0)
+    {
+        str[length++] = '0';
+    }
+    /* value is an int */
+    else if (number_is_int64(item) || (((double)item->valueint == d) && (d <= INT_MAX) && (d >= INT_MIN)))
+    {
+        length = print_int64(str, number_is_int64(item) ? item->valueint64 : item->valueint);
+    }
+    /* This checks for NaN and Infinity */
+    else if ((d * 0) != 0)
+    {
+        memcpy(str, "null", 4);
+        length = 4;
+    }
+    /* value is a floating point number */
+    else
+    {
+        length = print_double(str, d);
+    }
+    if (str == number)
+    {
+        return print_raw(p, number, (int)length);
+    }
+    p->offset += (int)length;
+
+    return true;
+}
+
+/* parse 4 digit hexadecimal number */
+static unsigned parse_hex4(const char *str)
+{
+    unsigned h = 0;
+    /* first digit */
+    if ((*str >= '0') && (*str <= '9'))
+    {
+        h += (*str) - '0';
+    }
+    else if ((*str >= 'A') && (*str <= 'F'))
+    {
+        h += 10 + (*str) - 'A';
+    }
+    else if ((*str >= 'a') && (*str <= 'f'))
+    {
+        h += 10 + (*str) - 'a';
+    }
+    else /* invalid */
+    {
+        return 0;
+    }
+
+
+    /* second digit */
+    h = h << 4;
+    str++;
+    if ((*str >= '0') && (*str <= '9'))
+    {
+        h += (*str) - '0';
+    }
+    else if ((*str >= 'A') && (*str <= 'F'))
+    {
+        h += 10 + (*str) - 'A';
+    }
+    else if ((*str >= 'a') && (*str <= 'f'))
+    {
+        h += 10 + (*str) - 'a';
+    }
+    else /* invalid */
+    {
+        return 0;
+    }
+
+    /* third digit */
+    h = h << 4;
+    str++;
+    if ((*str >= '0') && (*str <= '9'))
+    {
+        h += (*str) - '0';
+    }
+    else if ((*str >= 'A') && (*str <= 'F'))
+    {
+        h += 10 + (*str) - 'A';
+    }
+    else if ((*str >= 'a') && (*str <= 'f'))
+    {
+        h += 10 + (*str) - 'a';
+    }
+    else /* invalid */
+    {
+        return 0;
+    }
+
+    /* fourth digit */
+    h = h << 4;
+    str++;
+    if ((*str >= '0') && (*str <= '9'))
+    {
+        h += (*str) - '0';
+    }
+    else if ((*str >= 'A') && (*str <= 'F'))
+    {
+        h += 10 + (*str) - 'A';
+    }
+    else if ((*str >= 'a') && (*str <= 'f'))
+    {
+        h += 10 + (*str) - 'a';
+    }
+    else /* invalid */
+    {
+        return 0;
+    }
+
+    return h;
+}
+
+/* Scanning the input a block of 16 bytes at a time, on targets where SSE2 or NEON is always there.
+ * Blocks are read with aligned loads, which can't cross into the next page, so looking at the bytes
+ * after the terminating zero can't fault (they are ignored). Define CJSON_NO_SIMD to use the bytewise loops only. */
+#if !defined(CJSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+    #define SCAN_SSE2
+    #include <emmintrin.h>
+#elif !defined(CJSON_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    #define SCAN_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(SCAN_SSE2) || defined(SCAN_NEON)
+    #define SCAN_BLOCKS
+    #define SCAN_BLOCK_SIZE 16
+    #define scan_aligned(ptr) ((((size_t)(ptr)) % SCAN_BLOCK_SIZE) == 0)
+    /* reading the rest of a block would upset AddressSanitizer */
+    #if defined(__SANITIZE_ADDRESS__)
+        #define SCAN_NO_SANITIZE __attribute__((no_sanitize_address))
+    #elif defined(__has_feature)
+        #if __has_feature(address_sanitizer)
+            #define SCAN_NO_SANITIZE __attribute__((no_sanitize_address))
+        #endif
+    #endif
+#endif
+#ifndef SCAN_NO_SANITIZE
+    #define SCAN_NO_SANITIZE
+#endif
+
+/* does c end a run of characters that can be copied out of a string literal as they are? */
+#define ends_string_run(c) (((c) == '\"') || ((c) == '\\') || (((unsigned char)(c)) < 0x20))
+
+#ifdef SCAN_SSE2
+/* position of the lowest set bit, mask mustn't be 0 */
+static int lowest_bit(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int position = 0;
+    while (!(mask & 1))
+    {
+        mask >>= 1;
+        position++;
+    }
+
+    return position;
+#endif
+}
+#endif
+
+/* Find the first '\"', '\\' or control character (the terminating zero is one) in [ptr, end), end if there is none. */
+static SCAN_NO_SANITIZE const char *scan_string_run(const char *ptr, const char * const end)
+{
+#if defined(SCAN_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i block;
+    int mask = 0;
+#elif defined(SCAN_NEON)
+    const uint8x16_t quote = vdupq_n_u8('\"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x20);
+    uint8x16_t block;
+    uint32x2_t folded;
+#endif
+
+#ifdef SCAN_BLOCKS
+    /* bytewise up to the first block boundary */
+    while (before_end(ptr, end) && !scan_aligned(ptr))
+#else
+    while (before_end(ptr, end))
+#endif
+    {
+        if (ends_string_run(*ptr))
+        {
+            return ptr;
+        }
+        ptr++;
+    }
+
+    /* a block that starts before end is on the same page as the last byte of the input */
+#if defined(SCAN_SSE2)
+    for (; before_end(ptr, end); ptr += SCAN_BLOCK_SIZE)
+    {
+        block = _mm_load_si128((const __m128i*)(const void*)ptr);
+        /* unsigned block <= 0x1F is max(block, 0x1F) == 0x1F */
+        mask = _mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                    _mm_cmpeq_epi8(_mm_max_epu8(block, control), control)));
+        if (mask)
+        {
+            ptr += lowest_bit((unsigned int)mask);
+            return before_end(ptr, end) ? ptr : end;
+        }
+    }
+#elif defined(SCAN_NEON)
+    for (; before_end(ptr, end); ptr += SCAN_BLOCK_SIZE)
+    {
+        block = vld1q_u8((const uint8_t*)(const void*)ptr);
+        block = vorrq_u8(vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backslash)), vcltq_u8(block, control));
+        folded = vreinterpret_u32_u8(vorr_u8(vget_low_u8(block), vget_high_u8(block)));
+        if (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1))
+        {
+            /* it's somewhere in this block */
+            while (before_end(ptr, end) && !ends_string_run(*ptr))
+            {
+                ptr++;
+            }
+            return ptr;
+        }
+    }
+#endif
+
+    return end;
+}
+
+/* first bytes of UTF8 encoding for a given length in bytes */
+static const unsigned char firstByteMark[7] =
+{
+    0x00, /* should never happen */
+    0x00, /* 0xxxxxxx */
+    0xC0, /* 110xxxxx */
+    0xE0, /* 1110xxxx */
+    0xF0, /* 11110xxx */
+    0xF8,
+    0xFC
+};
+
+/* Decode the \uXXXX escape at ptr (pointing at the 'u'), and the second half of a surrogate pair after it.
+ * Returns the last character of the escape, NULL if it is invalid. */
+static const char *parse_unicode_escape(const char *ptr, const char * const end_ptr, unsigned * const codepoint)
+{
+    unsigned uc = 0;
+    unsigned uc2 = 0;
+
+    /* transcode utf16 to utf8. See RFC2781 and RFC3629. */
+    if ((end_ptr - ptr) <= 4)
+    {
+        /* not enough characters left for the 4 hex digits */
+        return NULL;
+    }
+    uc = parse_hex4(ptr + 1); /* get the unicode char. */
+    ptr += 4;
+    /* check for invalid. */
+    if (((uc >= 0xDC00) && (uc <= 0xDFFF)) || (uc == 0))
+    {
+        return NULL;
+    }
+
+    /* UTF16 surrogate pairs. */
+    if ((uc >= 0xD800) && (uc<=0xDBFF))
+    {
+        if ((end_ptr - ptr) <= 6)
+        {
+            /* invalid */
+            return NULL;
+        }
+        if ((ptr[1] != '\\') || (ptr[2] != 'u'))
+        {
+            /* missing second-half of surrogate. */
+            return NULL;
+        }
+        uc2 = parse_hex4(ptr + 3);
+        ptr += 6; /* \uXXXX */
+        if ((uc2 < 0xDC00) || (uc2 > 0xDFFF))
+        {
+            /* invalid second-half of surrogate. */
+            return NULL;
+        }
+        /* calculate unicode codepoint from the surrogate pair */
+        uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
+    }
+    *codepoint = uc;
+
+    return ptr;
+}
+
+/* Unescape the string contents [ptr, end_ptr) (without the quotes) into out, which has room for end_ptr - ptr bytes.
+ * Returns the end of the output, or NULL with error_code set. */
+static char *unescape_string(const char *ptr, const char * const end_ptr, char *out, int * const error_code)
+{
+    char *ptr2 = out;
+    unsigned uc = 0;
+    int len = 0;
+
+    /* loop through the string literal */
+    while (ptr < end_ptr)
+    {
+        if (*ptr != '\\')
+        {
+            /* copy the whole run, it ends at a backslash or end_ptr at the latest */
+            const char *run_end = scan_string_run(ptr + 1, end_ptr);
+            /* the two overlap when unescaping in place */
+            memmove(ptr2, ptr, (size_t)(run_end - ptr));
+            ptr2 += run_end - ptr;
+            ptr = run_end;
+        }
+        /* escape sequence */
+        else
+        {
+            ptr++;
+            if (ptr == end_ptr)
+            {
+                *error_code = cJSON_Error_InvalidString;
+                return NULL;
+            }
+            switch (*ptr)
+            {
+                case 'b':
+                    *ptr2++ = '\b';
                     break;
-                case '\t':
-                    *ptr2++ = 't';
+                case 'f':
+                    *ptr2++ = '\f';
                     break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf(ptr2, "u%04x", token);
-                    ptr2 += 5;
+                case 'n':
+                    *ptr2++ = '\n';
                     break;
-            }
+                case 'r':
+                    *ptr2++ = '\r';
+                    break;
+                case 't':
+                    *ptr2++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *ptr2++ = *ptr;
+                    break;
+                case 'u':
+                    ptr = parse_unicode_escape(ptr, end_ptr, &uc);
+                    if (!ptr)
+                    {
+                        *error_code = cJSON_Error_InvalidUnicode;
+                        return NULL;
+                    }
+
+                    /* encode as UTF8
+                     * takes at maximum 4 bytes to encode:
+                     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+                    len = 4;
+                    if (uc < 0x80)
+                    {
+                        /* normal ascii, encoding 0xxxxxxx */
+                        len = 1;
+                    }
+                    else if (uc < 0x800)
+                    {
+                        /* two bytes, encoding 110xxxxx 10xxxxxx */
+                        len = 2;
+                    }
+                    else if (uc < 0x10000)
+                    {
+                        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+                        len = 3;
+                    }
+                    ptr2 += len;
+
+                    switch (len) {
+                        case 4:
+                            /* 10xxxxxx */
+                            *--ptr2 = ((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            /* fall through */
+                        case 3:
+                            /* 10xxxxxx */
+                            *--ptr2 = ((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            /* fall through */
+                        case 2:
+                            /* 10xxxxxx */
+                            *--ptr2 = ((uc | 0x80) & 0xBF);
+                            uc >>= 6;
+                            /* fall through */
+                        case 1:
+                            /* depending on the length in bytes this determines the
+                             * encoding ofthe first UTF8 byte */
+                            *--ptr2 = (uc | firstByteMark[len]);
+                    }
+                    ptr2 += len;
+                    break;
+                default:
+                    *error_code = cJSON_Error_InvalidEscape;
+                    return NULL;
+            }
+            ptr++;
+        }
+    }
+
+    return ptr2;
+}
+
+/* Find the closing quote of the string at str, NULL (with the error set) if there is none.
+ * *length is at most how long the unescaped contents are, shorter than the input if there are escapes. */
+static const char *string_end(const char *str, parse_buffer * const buffer, size_t * const length)
+{
+    const char *ptr = NULL;
+    const char *end_ptr = NULL;
+    size_t len = 0;
+
+    /* not a string! */
+    if (!is_char(buffer, str, '\"'))
+    {
+        return parse_error(buffer, str, cJSON_Error_InvalidString);
+    }
+
+    end_ptr = str + 1;
+    for (;;)
+    {
+        /* everything up to the next quote, backslash or control character is copied as it is */
+        ptr = scan_string_run(end_ptr, buffer->end);
+        len += (size_t)(ptr - end_ptr);
+        end_ptr = ptr;
+        if ((end_ptr == buffer->end) || !*end_ptr)
+        {
+            /* no closing quote */
+            return parse_error(buffer, str, cJSON_Error_InvalidString);
+        }
+        if (*end_ptr == '\"')
+        {
+            break;
+        }
+        if (*end_ptr++ == '\\')
+        {
+            if ((end_ptr == buffer->end) || (*end_ptr == '\0'))
+            {
+                /* prevent buffer overflow when last input character is a backslash */
+                return parse_error(buffer, str, cJSON_Error_InvalidString);
+            }
+            /* Skip escaped quotes. */
+            end_ptr++;
+        }
+        len++;
+    }
+    *length = len;
+
+    return end_ptr;
+}
+
+/* Give item a string that it doesn't own, as its key or as its value. */
+static void set_const_string(cJSON * const item, const char * const string, const cjbool key)
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    if (key)
+    {
+        item->string = (char*)string;
+        item->type |= cJSON_StringIsConst;
+    }
+    else
+    {
+        item->valuestring = (char*)string;
+        item->type = cJSON_String | cJSON_ValueStringIsConst;
+    }
+#pragma GCC diagnostic pop
+}
+
+/* Take a string from the parse's string table. Returns the end of the string as parse_string does. */
+static const char *parse_interned(cJSON *item, const char *str, const char *end_ptr, size_t len, const cjbool key, parse_buffer * const buffer)
+{
+    char decoded[64];
+    char *out = NULL;
+    char *ptr2 = NULL;
+    const char *interned = NULL;
+    int error_code = cJSON_Error_None;
+
+    if (len == (size_t)(end_ptr - (str + 1)))
+    {
+        /* no escapes, the input is the string */
+        interned = string_table_intern(buffer->strings, str + 1, len);
+    }
+    else
+    {
+        out = (len < sizeof(decoded)) ? decoded : (char*)buffer->hooks->allocate(buffer->hooks->context, len + 1);
+        if (!out)
+        {
+            return parse_error(buffer, str, cJSON_Error_Memory);
+        }
+        ptr2 = unescape_string(str + 1, end_ptr, out, &error_code);
+        if (ptr2)
+        {
+            *ptr2 = '\0';
+            /* keys and values are C strings, the same goes for the table */
+            interned = string_table_intern(buffer->strings, out, strlen(out));
+        }
+        if (out != decoded)
+        {
+            buffer->hooks->deallocate(buffer->hooks->context, out);
+        }
+        if (!ptr2)
+        {
+            return parse_error(buffer, str, error_code);
+        }
+    }
+    if (!interned)
+    {
+        return parse_error(buffer, str, cJSON_Error_Memory);
+    }
+    /* the table owns the string, Delete must not free it */
+    set_const_string(item, interned, key);
+
+    return end_ptr + 1;
+}
+
+/* Unescape a string where it is in the (writable) input and terminate it there. */
+static const char *parse_in_place(cJSON *item, const char *str, const char *end_ptr, size_t len, const cjbool key, parse_buffer * const buffer)
+{
+    char *out = NULL;
+    char *ptr2 = NULL;
+    int error_code = cJSON_Error_None;
+
+    /* the caller of cJSON_ParseInSitu handed the input over for writing */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    out = (char*)(str + 1);
+#pragma GCC diagnostic pop
+    if (len == (size_t)(end_ptr - (str + 1)))
+    {
+        /* no escapes, only the closing quote changes */
+        ptr2 = out + len;
+    }
+    else if (!(ptr2 = unescape_string(str + 1, end_ptr, out, &error_code)))
+    {
+        return parse_error(buffer, str, error_code);
+    }
+    *ptr2 = '\0';
+    set_const_string(item, out, key);
+    item->type |= cJSON_StringIsInBuffer;
+
+    return end_ptr + 1;
+}
+
+/* Parse the input text into an unescaped cstring, and populate item (its string if it is a key). */
+static const char *parse_string(cJSON *item, const char *str, const cjbool key, parse_buffer * const buffer)
+{
+    const char *end_ptr = NULL;
+    char *ptr2 = NULL;
+    char *out = NULL;
+    size_t len = 0;
+    int error_code = cJSON_Error_None;
+
+    end_ptr = string_end(str, buffer, &len);
+    if (!end_ptr)
+    {
+        return NULL;
+    }
+    if (buffer->strings && (key || (len <= buffer->intern_value_length)))
+    {
+        return parse_interned(item, str, end_ptr, len, key, buffer);
+    }
+    if (buffer->in_place)
+    {
+        return parse_in_place(item, str, end_ptr, len, key, buffer);
+    }
+
+    /* This is at most how long we need for the string, roughly. */
+    out = (char*)buffer->hooks->allocate(buffer->hooks->context, len + 1);
+    if (!out)
+    {
+        return parse_error(buffer, str, cJSON_Error_Memory);
+    }
+    STATS_COUNT(buffer->hooks, string_allocations, 1);
+    /* assign here so out will be deleted during cJSON_Delete() later */
+    if (key)
+    {
+        item->string = out;
+    }
+    else
+    {
+        item->valuestring = out;
+        item->type = cJSON_String;
+    }
+
+    ptr2 = unescape_string(str + 1, end_ptr, out, &error_code);
+    if (!ptr2)
+    {
+        return parse_error(buffer, str, error_code);
+    }
+    *ptr2 = '\0';
+
+    /* skip the closing quote */
+    return end_ptr + 1;
+}
+
+/* Render the cstring provided to an escaped version that can be printed. */
+static cjbool print_string_ptr(const char *str, printbuffer * const p)
+{
+    const char *ptr = NULL;
+    char *ptr2 = NULL;
+    char *out = NULL;
+    int len = 0;
+    /* additional space that is needed for escaping */
+    int escapes = 0;
+    unsigned char token = '\0';
+
+    /* empty string */
+    if (!str)
+    {
+        return print_raw(p, "\"\"", 2);
+    }
+
+    for (ptr = str; *ptr; ptr++)
+    {
+        switch ((unsigned char)*ptr)
+        {
+            case '\"':
+            case '\\':
+            case '\b':
+            case '\f':
+            case '\n':
+            case '\r':
+            case '\t':
+                /* +1 for the backslash */
+                escapes++;
+                break;
+            default:
+                if ((unsigned char)*ptr < 32)
+                {
+                    /* +5 for \uXXXX */
+                    escapes += 5;
+                }
+                break;
+        }
+    }
+    len = (int)(ptr - str) + escapes;
+
+    out = ensure(p, len + 2);
+    if (!out)
+    {
+        return false;
+    }
+    p->offset += len + 2;
+
+    ptr2 = out;
+    *ptr2++ = '\"';
+    /* no characters have to be escaped */
+    if (!escapes)
+    {
+        memcpy(ptr2, str, (size_t)len);
+        ptr2[len] = '\"';
+
+        return true;
+    }
+
+    ptr = str;
+    /* copy the string */
+    while (*ptr)
+    {
+        if (((unsigned char)*ptr > 31) && (*ptr != '\"') && (*ptr != '\\'))
+        {
+            /* normal character, copy */
+            *ptr2++ = *ptr++;
+        }
+        else
+        {
+            /* character needs to be escaped */
+            *ptr2++ = '\\';
+            switch (token = *ptr++)
+            {
+                case '\\':
+                    *ptr2++ = '\\';
+                    break;
+                case '\"':
+                    *ptr2++ = '\"';
+                    break;
+                case '\b':
+                    *ptr2++ = 'b';
+                    break;
+                case '\f':
+                    *ptr2++ = 'f';
+                    break;
+                case '\n':
+                    *ptr2++ = 'n';
+                    break;
+                case '\r':
+                    *ptr2++ = 'r';
+                    break;
+                case '\t':
+                    *ptr2++ = 't';
+                    break;
+                default:
+                    /* escape and print as unicode codepoint */
+                    memcpy(ptr2, "u00", 3);
+                    ptr2[3] = "0123456789abcdef"[token >> 4];
+                    ptr2[4] = "0123456789abcdef"[token & 0x0F];
+                    ptr2 += 5;
+                    break;
+            }
+        }
+    }
+    *ptr2 = '\"';
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cjbool print_string(const cJSON *item, printbuffer * const p)
+{
+    return print_string_ptr(item->valuestring, p);
+}
+
+/* Predeclare these prototypes. */
+static const char *parse_value(cJSON *item, const char *value, parse_buffer * const buffer);
+static cjbool print_value(const cJSON *item, int depth, cjbool fmt, printbuffer * const p);
+static const char *parse_array(cJSON *item, const char *value, parse_buffer * const buffer);
+static cjbool print_array(const cJSON *item, int depth, cjbool fmt, printbuffer * const p);
+static const char *parse_object(cJSON *item, const char *value, parse_buffer * const buffer);
+
+static const char *parse_lazy(cJSON *item, const char *value, parse_buffer * const buffer);
+static cjbool print_object(const cJSON *item, int depth, cjbool fmt, printbuffer * const p);
+
+/* Utility to jump whitespace and cr/lf, stops at end at the latest */
+static SCAN_NO_SANITIZE const char *skip(const char *in, const char * const end)
+{
+#if defined(SCAN_SSE2)
+    const __m128i space = _mm_set1_epi8(32);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i block;
+    int mask = 0;
+#elif defined(SCAN_NEON)
+    const uint8x16_t space = vdupq_n_u8(33);
+    uint8x16_t block;
+    uint32x2_t folded;
+#endif
+
+    if (!in)
+    {
+        return NULL;
+    }
+
+#ifdef SCAN_BLOCKS
+    /* bytewise up to the first block boundary, most of the time there are only a few spaces anyway */
+    while (before_end(in, end) && !scan_aligned(in))
+#else
+    while (before_end(in, end))
+#endif
+    {
+        if (!*in || ((unsigned char)*in > 32))
+        {
+            return in;
+        }
+        in++;
+    }
+
+    /* a block that starts before end is on the same page as the last byte of the input */
+#if defined(SCAN_SSE2)
+    for (; before_end(in, end); in += SCAN_BLOCK_SIZE)
+    {
+        block = _mm_load_si128((const __m128i*)(const void*)in);
+        /* bits of the bytes that are whitespace and not the terminating zero */
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(block, space), space)) & ~_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+        if (mask != 0xFFFF)
+        {
+            in += lowest_bit(~(unsigned int)mask);
+            return before_end(in, end) ? in : end;
+        }
+    }
+#elif defined(SCAN_NEON)
+    for (; before_end(in, end); in += SCAN_BLOCK_SIZE)
+    {
+        block = vld1q_u8((const uint8_t*)(const void*)in);
+        /* bytes that aren't whitespace, or are the terminating zero */
+        block = vorrq_u8(vcgeq_u8(block, space), vceqq_u8(block, vdupq_n_u8(0)));
+        folded = vreinterpret_u32_u8(vorr_u8(vget_low_u8(block), vget_high_u8(block)));
+        if (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1))
+        {
+            while (before_end(in, end) && *in && ((unsigned char)*in <= 32))
+            {
+                in++;
+            }
+            return in;
+        }
+    }
+#endif
+
+    return end;
+}
+
+/* Parse an object - create a new root, and populate. value_end is NULL for zero terminated input. */
+static cJSON *parse_root(const char *value, const char *value_end, const char **return_parse_end, cjbool require_null_terminated, parse_buffer * const buffer)
+{
+    const char *end = NULL;
+    cJSON *c = NULL;
+
+    buffer->content = value;
+    buffer->end = value_end;
+    buffer->error = NULL;
+    buffer->error_code = cJSON_Error_None;
+    if (!value)
+    {
+        parse_error(buffer, NULL, cJSON_Error_InvalidArgument);
+        return NULL;
+    }
+
+    STATS_BEGIN("parse");
+    c = cJSON_New_Item(buffer->hooks);
+    if (!c) /* memory fail */
+    {
+        parse_error(buffer, value, cJSON_Error_Memory);
+        STATS_END("parse");
+        return NULL;
+    }
+
+    end = parse_value(c, skip(value, buffer->end), buffer);
+    if (!end)
+    {
+        /* parse failure. buffer->error is set. */
+        delete_item(c, buffer->hooks);
+        STATS_END("parse");
+        return NULL;
+    }
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        end = skip(end, buffer->end);
+        if (before_end(end, buffer->end) && *end)
+        {
+            delete_item(c, buffer->hooks);
+            parse_error(buffer, end, cJSON_Error_TrailingGarbage);
+            STATS_END("parse");
+            return NULL;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = end;
+    }
+    STATS_ADD(bytes_parsed, end - value);
+    STATS_END("parse");
+
+    return c;
+}
+
+/* parse with the legacy error reporting through return_parse_end or global_ep */
+static cJSON *parse_with_error_pointer(const char *value, const char **return_parse_end, cjbool require_null_terminated, const internal_hooks * const hooks)
+{
+    parse_buffer buffer;
+    cJSON *c = NULL;
+
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.hooks = hooks;
+    c = parse_root(value, NULL, return_parse_end, require_null_terminated, &buffer);
+    if (!c)
+    {
+        /* use global error pointer if no specific one was given */
+        if (return_parse_end)
+        {
+            *return_parse_end = buffer.error;
+        }
+        else
+        {
+            global_ep = buffer.error;
+        }
+    }
+    else if (!return_parse_end)
+    {
+        global_ep = NULL;
+    }
+
+    return c;
+}
+
+cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+{
+    return parse_with_error_pointer(value, return_parse_end, require_null_terminated, &global_hooks);
+}
+
+/* Default options for cJSON_Parse */
+cJSON *cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+cJSON *cJSON_ParseWithAllocator(const char *value, const char **return_parse_end, cjbool require_null_terminated, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    if (!hooks_from_allocator(&hooks, allocator))
+    {
+        return NULL;
+    }
+
+    return parse_with_error_pointer(value, return_parse_end, require_null_terminated, &hooks);
+}
+
+/* fill in a caller supplied error struct, position is where parsing failed or ended */
+static void report_parse_error(const parse_buffer * const buffer, const char *position, cJSON_ParseError * const error)
+{
+    const char *line_start = NULL;
+    const char *ptr = NULL;
+
+    error->code = buffer->error_code;
+    error->position = 0;
+    error->line = 1;
+    error->column = 1;
+    if (!buffer->content || !position)
+    {
+        return;
+    }
+
+    error->position = (size_t)(position - buffer->content);
+    line_start = buffer->content;
+    for (ptr = buffer->content; ptr < position; ptr++)
+    {
+        if (*ptr == '\n')
+        {
+            error->line++;
+            line_start = ptr + 1;
+        }
+    }
+    error->column = (int)(position - line_start) + 1;
+}
+
+/* cJSON_ParseWithLength, cJSON_ParseWithOptions and cJSON_ParseInSitu, value_end is NULL for zero terminated input */
+static cJSON *parse_with_options(const char *value, const char *value_end, const cjbool in_place, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    internal_hooks hooks;
+    parse_buffer buffer;
+    const char *end = NULL;
+    cJSON *c = NULL;
+
+    if (!hooks_from_allocator(&hooks, options ? options->allocator : NULL))
+    {
+        if (error)
+        {
+            memset(error, '\0', sizeof(cJSON_ParseError));
+            error->code = cJSON_Error_InvalidArgument;
+        }
+        return NULL;
+    }
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.hooks = &hooks;
+    if (options && (options->index_threshold > 0))
+    {
+        buffer.index_threshold = (size_t)options->index_threshold;
+    }
+    buffer.lazy = (options && options->lazy) ? true : false;
+    if (options && options->string_table)
+    {
+        buffer.strings = options->string_table;
+        buffer.intern_value_length = (options->intern_value_length > 0) ? (size_t)options->intern_value_length : 0;
+    }
+    buffer.in_place = in_place;
+
+    c = parse_root(value, value_end, &end, options ? options->require_null_terminated : false, &buffer);
+    if (error)
+    {
+        report_parse_error(&buffer, c ? end : buffer.error, error);
+    }
+
+    return c;
+}
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    return parse_with_options(value, value ? (value + length) : NULL, false, options, error);
+}
+
+cJSON *cJSON_ParseWithOptions(const char *value, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    return parse_with_options(value, NULL, false, options, error);
+}
+
+cJSON *cJSON_ParseInSitu(char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    return parse_with_options(value, value ? (value + length) : NULL, true, options, error);
+}
+
+cJSON *cJSON_ParseWithArena(const char *value, cJSON_Arena *arena)
+{
+    cJSON_Allocator allocator;
+    if (!arena)
+    {
+        return NULL;
+    }
+    cJSON_GetArenaAllocator(arena, &allocator);
+
+    return cJSON_ParseWithAllocator(value, 0, 0, &allocator);
+}
+
+size_t cJSON_ParseRecords(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_Arena *arena, cJSON_RecordCallback callback, void *context)
+{
+    internal_hooks hooks;
+    cJSON_Allocator allocator;
+    parse_buffer buffer;
+    cJSON_ParseError error;
+    const char *ptr = value;
+    const char *end = NULL;
+    const char *record_end = NULL;
+    cJSON *c = NULL;
+    size_t index = 0;
+    int keep_going = 1;
+
+    if (!value || !callback)
+    {
+        return 0;
+    }
+    if (arena)
+    {
+        cJSON_GetArenaAllocator(arena, &allocator);
+    }
+    if (!hooks_from_allocator(&hooks, arena ? &allocator : (options ? options->allocator : NULL)))
+    {
+        return 0;
+    }
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.hooks = &hooks;
+    if (options && (options->index_threshold > 0))
+    {
+        buffer.index_threshold = (size_t)options->index_threshold;
+    }
+    buffer.lazy = (options && options->lazy) ? true : false;
+    if (options && options->string_table)
+    {
+        buffer.strings = options->string_table;
+        buffer.intern_value_length = (options->intern_value_length > 0) ? (size_t)options->intern_value_length : 0;
+    }
+
+    end = value + length;
+    while (keep_going)
+    {
+        ptr = skip(ptr, end);
+        if ((ptr == end) || !*ptr)
+        {
+            break;
+        }
+
+        c = parse_root(ptr, end, &record_end, false, &buffer);
+        if (c)
+        {
+            keep_going = callback(context, index, c, NULL);
+            ptr = record_end;
+        }
+        else
+        {
+            report_parse_error(&buffer, buffer.error, &error);
+            keep_going = callback(context, index, NULL, &error);
+            /* an invalid record is skipped up to the end of its line */
+            ptr = cJSON_RecordBoundary(value, length, (size_t)(ptr - value)) + value;
+        }
+        index++;
+
+        /* the tree only lives as long as the callback */
+        if (arena)
+        {
+            cJSON_ArenaReset(arena);
+        }
+        else
+        {
+            delete_item(c, &hooks);
+        }
+    }
+
+    return (size_t)(ptr - value);
+}
+
+size_t cJSON_RecordBoundary(const char *value, size_t length, size_t offset)
+{
+    const char *newline = NULL;
+    if (!value || (offset >= length))
+    {
+        return length;
+    }
+
+    newline = (const char*)memchr(value + offset, '\n', length - offset);
+    return newline ? (size_t)(newline + 1 - value) : length;
+}
+
+/* Parallel array parsing: a structural scan finds commas between elements of the root array, the pieces between them
+ * are parsed by independent tasks into arenas of their own, and the element lists are linked in order at the end. */
+typedef struct
+{
+    /* the elements, without the commas before and after them */
+    const char *start;
+    const char *end;
+    size_t index_threshold;
+    cjbool lazy;
+    cJSON_Arena *arena;
+    cJSON *first;
+    cJSON *last;
+    size_t count;
+    cjbool failed;
+#ifdef CJSON_STATS
+    /* the task's own counters, the global ones aren't synchronized */
+    cJSON_Stats stats;
+#endif
+} array_part;
+
+/* The closing quote of the string at ptr (which points at the opening one), NULL if there is none. */
+static const char *closing_quote(const char *ptr, const char * const end)
+{
+    for (;;)
+    {
+        ptr = scan_string_run(ptr + 1, end);
+        if (!before_end(ptr, end) || !*ptr)
+        {
+            return NULL;
+        }
+        if (*ptr == '\"')
+        {
+            return ptr;
+        }
+        /* skip the escaped character, control characters are accepted as they are */
+        if ((*ptr == '\\') && !before_end(++ptr, end))
+        {
+            return NULL;
+        }
+    }
+}
+
+/* Find the closing bracket of the array at value (which points at the '['), and up to splits_size commas between its
+ * elements, at least size / (splits_size + 1) bytes apart. Returns the number of commas, or fails with NULL in *close
+ * if the structure is broken (the sequential parser then reports exactly what is wrong). */
+static size_t split_array(const char *value, const char * const end, const char **splits, size_t splits_size, const char **close)
+{
+    const char *ptr = value + 1;
+    const char *next_split = NULL;
+    size_t step = (size_t)(end - value) / (splits_size + 1);
+    size_t depth = 0;
+    size_t found = 0;
+
+    *close = NULL;
+    next_split = ptr + step;
+    while (ptr < end)
+    {
+        switch (*ptr)
+        {
+            case '\"':
+                /* strings may contain any structural character */
+                if (!(ptr = closing_quote(ptr, end)))
+                {
+                    return 0;
+                }
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (depth == 0)
+                {
+                    *close = (*ptr == ']') ? ptr : NULL;
+                    return found;
+                }
+                depth--;
+                break;
+            case ',':
+                if ((depth == 0) && (ptr >= next_split) && (found < splits_size))
+                {
+                    splits[found++] = ptr;
+                    next_split = ptr + step;
+                }
+                break;
+            case '\0':
+                return 0;
+            default:
+                break;
+        }
+        ptr++;
+    }
+
+    return 0;
+}
+
+/* a task: parse the elements of one part */
+static void parse_array_part(void *argument, size_t part_index)
+{
+    array_part * const part = ((array_part*)argument) + part_index;
+    internal_hooks hooks;
+    cJSON_Allocator allocator;
+    parse_buffer buffer;
+    const char *ptr = NULL;
+    cJSON *item = NULL;
+
+    cJSON_GetArenaAllocator(part->arena, &allocator);
+    hooks_from_allocator(&hooks, &allocator);
+#ifdef CJSON_STATS
+    hooks.stats = &part->stats;
+#endif
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.content = part->start;
+    buffer.end = part->end;
+    buffer.hooks = &hooks;
+    buffer.index_threshold = part->index_threshold;
+    buffer.lazy = part->lazy;
+
+    part->failed = true;
+    ptr = skip(part->start, part->end);
+    for (;;)
+    {
+        if (!(item = cJSON_New_Item(&hooks)))
+        {
+            return;
+        }
+        if (part->last)
+        {
+            part->last->next = item;
+            item->prev = part->last;
+        }
+        else
+        {
+            part->first = item;
+        }
+        part->last = item;
+        part->count++;
+
+        ptr = skip(parse_value(item, ptr, &buffer), part->end);
+        if (!ptr)
+        {
+            return;
+        }
+        if (ptr == part->end)
+        {
+            break;
+        }
+        if (*ptr != ',')
+        {
+            return;
+        }
+        ptr = skip(ptr + 1, part->end);
+    }
+    part->failed = false;
+}
+
+cJSON *cJSON_ParseArrayParallel(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_Arena *arena, cJSON_ParseError *error)
+{
+    cJSON_ParseOptions sequential;
+    cJSON_Allocator allocator;
+    internal_hooks hooks;
+    parse_buffer buffer;
+    array_part *parts = NULL;
+    const char **splits = NULL;
+    const char *start = NULL;
+    const char *close = NULL;
+    const char *end = NULL;
+    cJSON *root = NULL;
+    size_t tasks = 1;
+    size_t found = 0;
+    size_t count = 0;
+    size_t i = 0;
+    cjbool failed = false;
+
+    if (!arena)
+    {
+        if (error)
+        {
+            memset(error, '\0', sizeof(cJSON_ParseError));
+            error->code = cJSON_Error_InvalidArgument;
+        }
+        return NULL;
+    }
+    cJSON_GetArenaAllocator(arena, &allocator);
+    hooks_from_allocator(&hooks, &allocator);
+    memset(&sequential, '\0', sizeof(sequential));
+    if (options)
+    {
+        sequential = *options;
+    }
+    if (sequential.parallel_tasks > 1)
+    {
+        tasks = (size_t)sequential.parallel_tasks;
+    }
+    sequential.allocator = &allocator;
+    /* the pieces are parsed concurrently, a table can't be shared between them */
+    sequential.string_table = NULL;
+
+    start = value ? skip(value, value + length) : NULL;
+    if (!start || (start == (value + length)) || (*start != '[') || (tasks < 2))
+    {
+        return cJSON_ParseWithLength(value, length, &sequential, error);
+    }
+
+    STATS_BEGIN("parse");
+    parts = (array_part*)global_hooks.allocate(global_hooks.context, tasks * sizeof(array_part));
+    splits = (const char**)global_hooks.allocate(global_hooks.context, tasks * sizeof(const char*));
+    failed = !parts || !splits;
+    if (!failed)
+    {
+        memset(parts, '\0', tasks * sizeof(array_part));
+        found = split_array(start, value + length, splits, tasks - 1, &close);
+        /* broken, or empty */
+        failed = !close || (skip(start + 1, close) == close);
+    }
+    for (i = 0; !failed && (i <= found); i++)
+    {
+        parts[i].start = (i == 0) ? (start + 1) : (splits[i - 1] + 1);
+        parts[i].end = (i == found) ? close : splits[i];
+        parts[i].index_threshold = (sequential.index_threshold > 0) ? (size_t)sequential.index_threshold : 0;
+        parts[i].lazy = sequential.lazy ? true : false;
+        parts[i].arena = cJSON_CreateArena(arena->chunk_size);
+        failed = !parts[i].arena;
+    }
+
+    if (!failed)
+    {
+        if (sequential.executor)
+        {
+            sequential.executor(sequential.executor_context, parse_array_part, parts, found + 1);
+        }
+        else
+        {
+            for (i = 0; i <= found; i++)
+            {
+                parse_array_part(parts, i);
+            }
+        }
+        for (i = 0; i <= found; i++)
+        {
+            failed = failed || parts[i].failed;
+            count += parts[i].count;
+            /* the tasks are done, their counters can be merged (their elements are inside the root array) */
+            STATS_ADD(node_allocations, parts[i].stats.node_allocations);
+            STATS_ADD(string_allocations, parts[i].stats.string_allocations);
+            STATS_MAX(NULL, max_depth, parts[i].stats.max_depth + 1);
+        }
+    }
+    if (!failed)
+    {
+        end = close + 1;
+        if (sequential.require_null_terminated)
+        {
+            end = skip(end, value + length);
+            failed = (end < (value + length)) && *end;
+        }
+    }
+    if (!failed && !(root = cJSON_New_Item(&hooks)))
+    {
+        failed = true;
+    }
+    if (!failed)
+    {
+        /* link the parts */
+        root->type = cJSON_Array;
+        root->child = parts[0].first;
+        for (i = 1; i <= found; i++)
+        {
+            parts[i - 1].last->next = parts[i].first;
+            parts[i].first->prev = parts[i - 1].last;
+        }
+        if ((sequential.index_threshold > 0) || sequential.lazy)
+        {
+            /* the part arenas go away once they are merged into arena */
+            index_rehook(root->child, &hooks);
+        }
+        if ((sequential.index_threshold > 0) && (count >= (size_t)sequential.index_threshold))
+        {
+            /* the index is optional, parsing doesn't fail without it */
+            root->index = create_index(&hooks);
+            if (root->index)
+            {
+                index_build(root);
+            }
+        }
+        if (error)
+        {
+            memset(&buffer, '\0', sizeof(buffer));
+            buffer.content = value;
+            report_parse_error(&buffer, end, error);
+        }
+        STATS_ADD(bytes_parsed, end - value);
+    }
+    STATS_END("parse");
+
+    if (parts)
+    {
+        for (i = 0; (i <= found) && parts[i].arena; i++)
+        {
+            if (!failed)
+            {
+                arena_adopt(arena, parts[i].arena);
+            }
+            cJSON_DeleteArena(parts[i].arena);
+        }
+        global_hooks.deallocate(global_hooks.context, parts);
+    }
+    if (splits)
+    {
+        global_hooks.deallocate(global_hooks.context, splits);
+    }
+    if (failed)
+    {
+        /* parse again in one piece for the exact error, or the result if the split was the problem */
+        return cJSON_ParseWithLength(value, length, &sequential, error);
+    }
+
+    return root;
+}
+
+/* Push parser: the same grammar as parse_value, but driven by a state machine with an explicit stack of open
+ * containers, so input can arrive in chunks. Scalars are still parsed by parse_string and parse_number, either
+ * straight out of the chunk or out of a scratch buffer when they are split across chunks. */
+
+/* what the parser expects next */
+#define PUSH_VALUE 0        /* a value, after ',' in an array, ':' or at the start */
+#define PUSH_VALUE_OR_END 1 /* a value or ']', after '[' */
+#define PUSH_KEY 2          /* a key, after ',' in an object */
+#define PUSH_KEY_OR_END 3   /* a key or '}', after '{' */
+#define PUSH_COLON 4        /* ':' after a key */
+#define PUSH_NEXT 5         /* ',' or the end of the container, after a value */
+#define PUSH_STRING 6       /* the rest of a string or key */
+#define PUSH_NUMBER 7       /* the rest of a number */
+#define PUSH_LITERAL 8      /* the rest of null, true or false */
+#define PUSH_DONE 9         /* the root value is complete */
+#define PUSH_ERROR 10
+
+/* an array or object that hasn't been closed yet */
+typedef struct
+{
+    cJSON *container;
+    /* new children are linked in after this one */
+    cJSON *last;
+    size_t count;
+} push_frame;
+
+struct cJSON_Parser
+{
+    internal_hooks hooks;
+    cjbool require_null_terminated;
+    size_t index_threshold;
+    int state;
+    /* no more input is accepted, either Feed was called with length 0 or a zero byte was seen */
+    cjbool ended;
+    cJSON *root;
+    /* open containers, the innermost last */
+    push_frame *stack;
+    size_t depth;
+    size_t stack_size;
+    /* the item the current token is parsed into */
+    cJSON *item;
+    /* the current string is a key */
+    cjbool is_key;
+    /* the last chunk ended right after a backslash */
+    cjbool escaped;
+    /* the literal being matched and how much of it has been seen */
+    const char *literal;
+    size_t literal_length;
+    size_t literal_matched;
+    /* the beginning of a token that didn't end in its chunk */
+    char *scratch;
+    size_t scratch_length;
+    size_t scratch_size;
+    /* stream offset of the current token */
+    size_t token_start;
+    /* the chunk being processed and its stream offset */
+    const char *chunk;
+    size_t position;
+    /* for line and column in error reports */
+    int line;
+    size_t line_start;
+    cJSON_ParseError error;
+#ifdef CJSON_STATS
+    /* the parse has been reported to the stats callbacks as started, as ended */
+    cjbool stats_begun;
+    cjbool stats_ended;
+#endif
+};
+
+/* stream offset of a pointer into the current chunk */
+static size_t push_offset(const cJSON_Parser * const parser, const char * const ptr)
+{
+    return parser->position + (size_t)(ptr - parser->chunk);
+}
+
+/* Fail at a stream offset. The partial tree is deleted right away. Returns NULL. */
+static const char *push_error(cJSON_Parser * const parser, size_t position, int code)
+{
+    parser->state = PUSH_ERROR;
+    parser->error.code = code;
+    parser->error.position = position;
+    parser->error.line = parser->line;
+    parser->error.column = (position >= parser->line_start) ? (int)(position - parser->line_start) + 1 : 1;
+    delete_item(parser->root, &parser->hooks);
+    parser->root = NULL;
+    parser->item = NULL;
+    parser->depth = 0;
+
+    return NULL;
+}
+
+/* keep the part of a token that is in this chunk for the next one */
+static cjbool push_keep(cJSON_Parser * const parser, const char * const data, size_t length)
+{
+    char *scratch = NULL;
+    size_t size = 0;
+    if ((parser->scratch_length + length) > parser->scratch_size)
+    {
+        size = (parser->scratch_size > 0) ? parser->scratch_size : 64;
+        while (size < (parser->scratch_length + length))
+        {
+            size *= 2;
+        }
+        if (parser->hooks.reallocate)
+        {
+            scratch = (char*)parser->hooks.reallocate(parser->hooks.context, parser->scratch, size);
+        }
+        else if ((scratch = (char*)parser->hooks.allocate(parser->hooks.context, size)))
+        {
+            if (parser->scratch)
+            {
+                memcpy(scratch, parser->scratch, parser->scratch_length);
+                parser->hooks.deallocate(parser->hooks.context, parser->scratch);
+            }
+        }
+        if (!scratch)
+        {
+            return false;
+        }
+        parser->scratch = scratch;
+        parser->scratch_size = size;
+    }
+    memcpy(parser->scratch + parser->scratch_length, data, length);
+    parser->scratch_length += length;
+
+    return true;
+}
+
+/* link a new member (array element or object key) into the innermost container */
+static void push_link(cJSON_Parser * const parser, cJSON * const item)
+{
+    push_frame *frame = &parser->stack[parser->depth - 1];
+    if (frame->last)
+    {
+        frame->last->next = item;
+        item->prev = frame->last;
+    }
+    else
+    {
+        frame->container->child = item;
+    }
+    frame->last = item;
+    frame->count++;
+}
+
+/* Make the item the next value goes into: a new root, a new array element, or the object member whose key was just read. */
+static cjbool push_new_value(cJSON_Parser * const parser)
+{
+    push_frame *frame = NULL;
+    cJSON *item = NULL;
+    if (parser->depth == 0)
+    {
+        parser->item = parser->root = cJSON_New_Item(&parser->hooks);
+        return parser->item != NULL;
+    }
+
+    frame = &parser->stack[parser->depth - 1];
+    if (frame->container->type == cJSON_Object)
+    {
+        parser->item = frame->last;
+        return true;
+    }
+    if (!(item = cJSON_New_Item(&parser->hooks)))
+    {
+        return false;
+    }
+    push_link(parser, item);
+    parser->item = item;
+
+    return true;
+}
+
+/* a value is complete, what comes next depends on where it is */
+static void push_value_done(cJSON_Parser * const parser)
+{
+    parser->item = NULL;
+    parser->state = (parser->depth == 0) ? PUSH_DONE : PUSH_NEXT;
+}
+
+/* Parse a complete string or number token with the recursive parser's functions. Returns the end of what was parsed. */
+static const char *push_parse_token(cJSON_Parser * const parser, const char * const token, size_t length, cjbool number)
+{
+    parse_buffer buffer;
+    const char *end = NULL;
+
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.content = token;
+    buffer.end = token + length;
+    buffer.hooks = &parser->hooks;
+    end = number ? parse_number(parser->item, token, &buffer) : parse_string(parser->item, token, parser->is_key, &buffer);
+    if (!end)
+    {
+        push_error(parser, parser->token_start + (size_t)(buffer.error - token), buffer.error_code);
+    }
+
+    return end;
+}
+
+/* Continue a string at ptr, scanning starts at scan (after the opening quote for a new string). Returns where processing continues. */
+static const char *push_string(cJSON_Parser * const parser, const char *ptr, const char *scan, const char * const end)
+{
+    const char *token = NULL;
+    size_t length = 0;
+
+    if (parser->escaped)
+    {
+        if (!*scan)
+        {
+            return push_error(parser, parser->token_start, cJSON_Error_InvalidString);
+        }
+        parser->escaped = false;
+        scan++;
+    }
+    for (;;)
+    {
+        scan = scan_string_run(scan, end);
+        if (scan == end)
+        {
+            /* the string goes on in the next chunk */
+            if (!push_keep(parser, ptr, (size_t)(end - ptr)))
+            {
+                return push_error(parser, parser->token_start, cJSON_Error_Memory);
+            }
+            return end;
+        }
+        if (*scan == '\"')
+        {
+            break;
+        }
+        if (*scan == '\\')
+        {
+            if ((scan + 1) == end)
+            {
+                parser->escaped = true;
+                scan++;
+                continue;
+            }
+            if (!scan[1])
+            {
+                return push_error(parser, parser->token_start, cJSON_Error_InvalidString);
+            }
+            scan += 2;
+            continue;
+        }
+        if (!*scan)
+        {
+            /* no closing quote */
+            return push_error(parser, parser->token_start, cJSON_Error_InvalidString);
+        }
+        if (*scan == '\n')
+        {
+            parser->line++;
+            parser->line_start = push_offset(parser, scan) + 1;
+        }
+        scan++;
+    }
+
+    /* the closing quote is at scan */
+    scan++;
+    if (parser->scratch_length > 0)
+    {
+        if (!push_keep(parser, ptr, (size_t)(scan - ptr)))
+        {
+            return push_error(parser, parser->token_start, cJSON_Error_Memory);
+        }
+        token = parser->scratch;
+        length = parser->scratch_length;
+    }
+    else
+    {
+        token = ptr;
+        length = (size_t)(scan - ptr);
+    }
+    parser->scratch_length = 0;
+    if (!push_parse_token(parser, token, length, false))
+    {
+        return NULL;
+    }
+
+    if (parser->is_key)
+    {
+        parser->state = PUSH_COLON;
+    }
+    else
+    {
+        push_value_done(parser);
+    }
+
+    return scan;
+}
+
+static cjbool is_number_character(const char c)
+{
+    return ((c >= '0') && (c <= '9')) || (c == '-') || (c == '+') || (c == '.') || (c == 'e') || (c == 'E');
+}
+
+/* A number token is complete. Whatever parse_number doesn't take is an error, except after a root value. */
+static cjbool push_finish_number(cJSON_Parser * const parser, const char * const token, size_t length)
+{
+    const char *end = push_parse_token(parser, token, length, true);
+    size_t rest = 0;
+    if (!end)
+    {
+        return false;
+    }
+    parser->scratch_length = 0;
+    push_value_done(parser);
+
+    if (end < (token + length))
+    {
+        /* none of the characters a number can be made of may follow a value */
+        rest = parser->token_start + (size_t)(end - token);
+        if (parser->depth > 0)
+        {
+            push_error(parser, rest, (parser->stack[parser->depth - 1].container->type == cJSON_Array) ? cJSON_Error_UnterminatedArray : cJSON_Error_UnterminatedObject);
+            return false;
+        }
+        if (parser->require_null_terminated)
+        {
+            push_error(parser, rest, cJSON_Error_TrailingGarbage);
+            return false;
+        }
+        /* the legacy parser ignores what follows the root value as well */
+        parser->ended = true;
+    }
+
+    return true;
+}
+
+/* Continue a number at ptr, scanning starts at scan. */
+static const char *push_number(cJSON_Parser * const parser, const char *ptr, const char *scan, const char * const end)
+{
+    while ((scan < end) && is_number_character(*scan))
+    {
+        scan++;
+    }
+    if (scan == end)
+    {
+        /* only the next character after the number can end it */
+        if (!push_keep(parser, ptr, (size_t)(end - ptr)))
+        {
+            return push_error(parser, parser->token_start, cJSON_Error_Memory);
+        }
+        return end;
+    }
+
+    if (parser->scratch_length > 0)
+    {
+        if (!push_keep(parser, ptr, (size_t)(scan - ptr)))
+        {
+            return push_error(parser, parser->token_start, cJSON_Error_Memory);
+        }
+        if (!push_finish_number(parser, parser->scratch, parser->scratch_length))
+        {
+            return NULL;
+        }
+    }
+    else if (!push_finish_number(parser, ptr, (size_t)(scan - ptr)))
+    {
+        return NULL;
+    }
+
+    return parser->ended ? end : scan;
+}
+
+/* Continue matching null, true or false at ptr. */
+static const char *push_literal(cJSON_Parser * const parser, const char *ptr, const char * const end)
+{
+    while ((ptr < end) && (parser->literal_matched < parser->literal_length))
+    {
+        if (*ptr != parser->literal[parser->literal_matched])
+        {
+            return push_error(parser, parser->token_start, cJSON_Error_InvalidValue);
+        }
+        ptr++;
+        parser->literal_matched++;
+    }
+    if (parser->literal_matched == parser->literal_length)
+    {
+        switch (parser->literal[0])
+        {
+            case 'n':
+                parser->item->type = cJSON_NULL;
+                break;
+            case 'f':
+                parser->item->type = cJSON_False;
+                break;
+            default:
+                parser->item->type = cJSON_True;
+                parser->item->valueint = 1;
+                break;
+        }
+        push_value_done(parser);
+    }
+
+    return ptr;
+}
+
+/* Start a value at ptr, the item it goes into is parser->item. */
+static const char *push_start_value(cJSON_Parser * const parser, const char *ptr, const char * const end)
+{
+    push_frame *stack = NULL;
+    size_t size = 0;
+
+    parser->token_start = push_offset(parser, ptr);
+    switch (*ptr)
+    {
+        case 'n':
+            parser->literal = "null";
+            parser->literal_length = 4;
+            break;
+        case 'f':
+            parser->literal = "false";
+            parser->literal_length = 5;
+            break;
+        case 't':
+            parser->literal = "true";
+            parser->literal_length = 4;
+            break;
+        case '\"':
+            parser->is_key = false;
+            parser->state = PUSH_STRING;
+            return push_string(parser, ptr, ptr + 1, end);
+        case '[':
+        case '{':
+            if (parser->depth == parser->stack_size)
+            {
+                size = (parser->stack_size > 0) ? (parser->stack_size * 2) : 16;
+                stack = (push_frame*)parser->hooks.allocate(parser->hooks.context, size * sizeof(push_frame));
+                if (!stack)
+                {
+                    return push_error(parser, parser->token_start, cJSON_Error_Memory);
+                }
+                if (parser->stack)
+                {
+                    memcpy(stack, parser->stack, parser->depth * sizeof(push_frame));
+                    parser->hooks.deallocate(parser->hooks.context, parser->stack);
+                }
+                parser->stack = stack;
+                parser->stack_size = size;
+            }
+            parser->item->type = (*ptr == '[') ? cJSON_Array : cJSON_Object;
+            parser->stack[parser->depth].container = parser->item;
+            parser->stack[parser->depth].last = NULL;
+            parser->stack[parser->depth].count = 0;
+            parser->depth++;
+            STATS_MAX(&parser->hooks, max_depth, parser->depth);
+            parser->item = NULL;
+            parser->state = (*ptr == '[') ? PUSH_VALUE_OR_END : PUSH_KEY_OR_END;
+            return ptr + 1;
+        default:
+            if ((*ptr == '-') || ((*ptr >= '0') && (*ptr <= '9')))
+            {
+                parser->state = PUSH_NUMBER;
+                return push_number(parser, ptr, ptr + 1, end);
+            }
+            return push_error(parser, parser->token_start, cJSON_Error_InvalidValue);
+    }
+
+    parser->literal_matched = 0;
+    parser->state = PUSH_LITERAL;
+    return push_literal(parser, ptr, end);
+}
+
+/* Close the innermost container at ptr. */
+static const char *push_close(cJSON_Parser * const parser, const char *ptr)
+{
+    push_frame *frame = &parser->stack[--parser->depth];
+    if (parser->index_threshold && (frame->count >= parser->index_threshold))
+    {
+        /* the index is optional, parsing doesn't fail without it */
+        frame->container->index = create_index(&parser->hooks);
+        if (frame->container->index)
+        {
+            index_build(frame->container);
+        }
+    }
+    push_value_done(parser);
+
+    return ptr + 1;
+}
+
+/* the error for input that doesn't fit the current state */
+static int push_unexpected(const cJSON_Parser * const parser)
+{
+    switch (parser->state)
+    {
+        case PUSH_KEY:
+        case PUSH_KEY_OR_END:
+        case PUSH_STRING:
+            return cJSON_Error_InvalidString;
+        case PUSH_COLON:
+            return cJSON_Error_ExpectedColon;
+        case PUSH_NEXT:
+            return (parser->stack[parser->depth - 1].container->type == cJSON_Array) ? cJSON_Error_UnterminatedArray : cJSON_Error_UnterminatedObject;
+        case PUSH_DONE:
+            return cJSON_Error_TrailingGarbage;
+        default:
+            return cJSON_Error_InvalidValue;
+    }
+}
+
+/* there is no more input (Feed with length 0, or a zero byte) at stream offset position */
+static int push_end(cJSON_Parser * const parser, size_t position)
+{
+    parser->ended = true;
+    if (parser->state == PUSH_NUMBER)
+    {
+        push_finish_number(parser, parser->scratch, parser->scratch_length);
+    }
+    switch (parser->state)
+    {
+        case PUSH_DONE:
+            return cJSON_ParserDone;
+        case PUSH_ERROR:
+            return cJSON_ParserError;
+        case PUSH_STRING:
+        case PUSH_LITERAL:
+            position = parser->token_start;
+            break;
+        default:
+            break;
+    }
+    push_error(parser, position, push_unexpected(parser));
+
+    return cJSON_ParserError;
+}
+
+/* process one chunk, returns false on error */
+static cjbool push_chunk(cJSON_Parser * const parser, const char *ptr, const char * const end)
+{
+    cJSON *item = NULL;
+    cjbool array = false;
+    while (ptr && (ptr < end) && !parser->ended)
+    {
+        switch (parser->state)
+        {
+            case PUSH_STRING:
+                ptr = push_string(parser, ptr, ptr, end);
+                continue;
+            case PUSH_NUMBER:
+                ptr = push_number(parser, ptr, ptr, end);
+                continue;
+            case PUSH_LITERAL:
+                ptr = push_literal(parser, ptr, end);
+                continue;
+            default:
+                break;
+        }
+
+        /* whitespace is every byte up to 32 but the zero */
+        while ((ptr < end) && *ptr && ((unsigned char)*ptr <= 32))
+        {
+            if (*ptr == '\n')
+            {
+                parser->line++;
+                parser->line_start = push_offset(parser, ptr) + 1;
+            }
+            ptr++;
+        }
+        if (ptr == end)
+        {
+            break;
+        }
+        if (!*ptr)
+        {
+            /* a zero byte ends the input */
+            return push_end(parser, push_offset(parser, ptr)) != cJSON_ParserError;
+        }
+
+        array = (parser->depth > 0) && (parser->stack[parser->depth - 1].container->type == cJSON_Array);
+        switch (parser->state)
+        {
+            case PUSH_DONE:
+                if (parser->require_null_terminated)
+                {
+                    break;
+                }
+                /* the legacy parser ignores anything after the root value */
+                parser->ended = true;
+                return true;
+            case PUSH_VALUE_OR_END:
+                if (*ptr == ']')
+                {
+                    ptr = push_close(parser, ptr);
+                    continue;
+                }
+                /* fall through */
+            case PUSH_VALUE:
+                if (!push_new_value(parser))
+                {
+                    push_error(parser, push_offset(parser, ptr), cJSON_Error_Memory);
+                    return false;
+                }
+                ptr = push_start_value(parser, ptr, end);
+                continue;
+            case PUSH_KEY_OR_END:
+                if (*ptr == '}')
+                {
+                    ptr = push_close(parser, ptr);
+                    continue;
+                }
+                /* fall through */
+            case PUSH_KEY:
+                if (*ptr != '\"')
+                {
+                    break;
+                }
+                if (!(item = cJSON_New_Item(&parser->hooks)))
+                {
+                    push_error(parser, push_offset(parser, ptr), cJSON_Error_Memory);
+                    return false;
+                }
+                push_link(parser, item);
+                parser->item = item;
+                parser->is_key = true;
+                parser->token_start = push_offset(parser, ptr);
+                parser->state = PUSH_STRING;
+                ptr = push_string(parser, ptr, ptr + 1, end);
+                continue;
+            case PUSH_COLON:
+                if (*ptr != ':')
+                {
+                    break;
+                }
+                parser->state = PUSH_VALUE;
+                ptr++;
+                continue;
+            case PUSH_NEXT:
+                if (*ptr == ',')
+                {
+                    parser->state = array ? PUSH_VALUE : PUSH_KEY;
+                    ptr++;
+                    continue;
+                }
+                if (*ptr == (array ? ']' : '}'))
+                {
+                    ptr = push_close(parser, ptr);
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+
+        /* a character the current state doesn't accept */
+        push_error(parser, push_offset(parser, ptr), push_unexpected(parser));
+        return false;
+    }
+
+    return ptr != NULL;
+}
+
+cJSON_Parser *cJSON_CreateParser(const cJSON_ParseOptions *options)
+{
+    internal_hooks hooks;
+    cJSON_Parser *parser = NULL;
+
+    if (!hooks_from_allocator(&hooks, options ? options->allocator : NULL))
+    {
+        return NULL;
+    }
+    parser = (cJSON_Parser*)hooks.allocate(hooks.context, sizeof(cJSON_Parser));
+    if (!parser)
+    {
+        return NULL;
+    }
+    memset(parser, '\0', sizeof(cJSON_Parser));
+    parser->hooks = hooks;
+    parser->state = PUSH_VALUE;
+    parser->line = 1;
+    parser->error.line = 1;
+    parser->error.column = 1;
+    if (options)
+    {
+        parser->require_null_terminated = options->require_null_terminated ? true : false;
+        if (options->index_threshold > 0)
+        {
+            parser->index_threshold = (size_t)options->index_threshold;
+        }
+    }
+
+    return parser;
+}
+
+/* what Feed returns; the parse counts as ended once it is done or has failed, with the input fed up to then */
+static int push_result(cJSON_Parser * const parser, const int result)
+{
+#ifdef CJSON_STATS
+    if ((result != cJSON_ParserNeedMore) && !parser->stats_ended)
+    {
+        parser->stats_ended = true;
+        if (result == cJSON_ParserDone)
+        {
+            STATS_ADD(bytes_parsed, parser->position);
+        }
+        STATS_END("parse");
+    }
+#else
+    (void)parser;
+#endif
+
+    return result;
+}
+
+int cJSON_ParserFeed(cJSON_Parser *parser, const char *chunk, size_t length)
+{
+    cjbool ok = false;
+    if (!parser || (parser->state == PUSH_ERROR))
+    {
+        return cJSON_ParserError;
+    }
+    if (parser->ended)
+    {
+        /* whatever comes after the end is ignored */
+        return cJSON_ParserDone;
+    }
+#ifdef CJSON_STATS
+    if (!parser->stats_begun)
+    {
+        parser->stats_begun = true;
+        STATS_BEGIN("parse");
+    }
+#endif
+    if (!chunk || (length == 0))
+    {
+        return push_result(parser, push_end(parser, parser->position));
+    }
+
+    parser->chunk = chunk;
+    ok = push_chunk(parser, chunk, chunk + length);
+    parser->position += length;
+    parser->chunk = NULL;
+    if (!ok)
+    {
+        return push_result(parser, cJSON_ParserError);
+    }
+
+    return push_result(parser, (parser->state == PUSH_DONE) ? cJSON_ParserDone : cJSON_ParserNeedMore);
+}
+
+cJSON *cJSON_ParserTakeResult(cJSON_Parser *parser)
+{
+    cJSON *root = NULL;
+    if (!parser || (parser->state != PUSH_DONE))
+    {
+        return NULL;
+    }
+    root = parser->root;
+    parser->root = NULL;
+
+    return root;
+}
+
+void cJSON_ParserGetError(const cJSON_Parser *parser, cJSON_ParseError *error)
+{
+    if (parser && error)
+    {
+        *error = parser->error;
+    }
+}
+
+void cJSON_DeleteParser(cJSON_Parser *parser)
+{
+    internal_hooks hooks;
+    if (!parser)
+    {
+        return;
+    }
+#ifdef CJSON_STATS
+    if (parser->stats_begun && !parser->stats_ended)
+    {
+        /* abandoned before it was done */
+        STATS_END("parse");
+    }
+#endif
+    hooks = parser->hooks;
+    delete_item(parser->root, &hooks);
+    if (parser->stack)
+    {
+        hooks.deallocate(hooks.context, parser->stack);
+    }
+    if (parser->scratch)
+    {
+        hooks.deallocate(hooks.context, parser->scratch);
+    }
+    hooks.deallocate(hooks.context, parser);
+}
+
+/* SAX parsing: the grammar of parse_value, but values are reported to callbacks instead of becoming nodes */
+typedef struct
+{
+    parse_buffer buffer;
+    const cJSON_SAXHandler *handler;
+    void *context;
+} sax_parser;
+
+/* check the escape sequences in string contents that string_end has delimited, returns an error code */
+static int check_escapes(const char *ptr, const char * const end_ptr)
+{
+    unsigned uc = 0;
+    while ((ptr = (const char*)memchr(ptr, '\\', (size_t)(end_ptr - ptr))))
+    {
+        /* string_end makes sure something follows the backslash */
+        ptr++;
+        switch (*ptr)
+        {
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+            case '\"':
+            case '\\':
+            case '/':
+                break;
+            case 'u':
+                ptr = parse_unicode_escape(ptr, end_ptr, &uc);
+                if (!ptr)
+                {
+                    return cJSON_Error_InvalidUnicode;
+                }
+                break;
+            default:
+                return cJSON_Error_InvalidEscape;
+        }
+        ptr++;
+    }
+
+    return cJSON_Error_None;
+}
+
+static const char *sax_value(sax_parser * const sax, const char *value);
+
+/* a string or key, reported as the slice between the quotes */
+static const char *sax_string(sax_parser * const sax, const char *str, cjbool key)
+{
+    int (*callback)(void *context, const char *string, size_t length, int escaped) = key ? sax->handler->key : sax->handler->string;
+    const char *end_ptr = NULL;
+    size_t len = 0;
+    size_t span = 0;
+    int error_code = cJSON_Error_None;
+
+    end_ptr = string_end(str, &sax->buffer, &len);
+    if (!end_ptr)
+    {
+        return NULL;
+    }
+    /* every escape is shorter unescaped */
+    span = (size_t)(end_ptr - (str + 1));
+    if ((len != span) && ((error_code = check_escapes(str + 1, end_ptr)) != cJSON_Error_None))
+    {
+        return parse_error(&sax->buffer, str, error_code);
+    }
+    if (callback && !callback(sax->context, str + 1, span, len != span))
+    {
+        return parse_error(&sax->buffer, str, cJSON_Error_Aborted);
+    }
+
+    return end_ptr + 1;
+}
+
+static const char *sax_number(sax_parser * const sax, const char *num)
+{
+    cJSON number;
+    const char *end = NULL;
+
+    /* parse_number only writes the number fields, the text of very long numbers is copied with the buffer's hooks */
+    memset(&number, '\0', sizeof(number));
+    end = parse_number(&number, num, &sax->buffer);
+    if (end && sax->handler->number && !sax->handler->number(sax->context, number.valuedouble, num, (size_t)(end - num)))
+    {
+        return parse_error(&sax->buffer, num, cJSON_Error_Aborted);
+    }
+
+    return end;
+}
+
+static const char *sax_array(sax_parser * const sax, const char *value)
+{
+    parse_buffer * const buffer = &sax->buffer;
+    if (sax->handler->start_array && !sax->handler->start_array(sax->context))
+    {
+        return parse_error(buffer, value, cJSON_Error_Aborted);
+    }
+
+    value = skip(value + 1, buffer->end);
+    if (!is_char(buffer, value, ']'))
+    {
+        /* loop through the comma separated array elements */
+        for (;;)
+        {
+            value = skip(sax_value(sax, value), buffer->end);
+            if (!value)
+            {
+                return NULL;
+            }
+            if (!is_char(buffer, value, ','))
+            {
+                break;
+            }
+            value = skip(value + 1, buffer->end);
+        }
+        if (!is_char(buffer, value, ']'))
+        {
+            /* malformed. */
+            return parse_error(buffer, value, cJSON_Error_UnterminatedArray);
+        }
+    }
+
+    if (sax->handler->end_array && !sax->handler->end_array(sax->context))
+    {
+        return parse_error(buffer, value, cJSON_Error_Aborted);
+    }
+
+    return value + 1;
+}
+
+static const char *sax_object(sax_parser * const sax, const char *value)
+{
+    parse_buffer * const buffer = &sax->buffer;
+    if (sax->handler->start_object && !sax->handler->start_object(sax->context))
+    {
+        return parse_error(buffer, value, cJSON_Error_Aborted);
+    }
+
+    value = skip(value + 1, buffer->end);
+    if (!is_char(buffer, value, '}'))
+    {
+        for (;;)
+        {
+            value = skip(sax_string(sax, value, true), buffer->end);
+            if (!value)
+            {
+                return NULL;
+            }
+            if (!is_char(buffer, value, ':'))
+            {
+                /* invalid object. */
+                return parse_error(buffer, value, cJSON_Error_ExpectedColon);
+            }
+            value = skip(sax_value(sax, skip(value + 1, buffer->end)), buffer->end);
+            if (!value)
+            {
+                return NULL;
+            }
+            if (!is_char(buffer, value, ','))
+            {
+                break;
+            }
+            value = skip(value + 1, buffer->end);
+        }
+        if (!is_char(buffer, value, '}'))
+        {
+            /* malformed */
+            return parse_error(buffer, value, cJSON_Error_UnterminatedObject);
+        }
+    }
+
+    if (sax->handler->end_object && !sax->handler->end_object(sax->context))
+    {
+        return parse_error(buffer, value, cJSON_Error_Aborted);
+    }
+
+    return value + 1;
+}
+
+/* same dispatch as parse_value */
+static const char *sax_value(sax_parser * const sax, const char *value)
+{
+    parse_buffer * const buffer = &sax->buffer;
+    const cJSON_SAXHandler * const handler = sax->handler;
+    if (!value)
+    {
+        /* Fail on null. */
+        return NULL;
+    }
+    if (!before_end(value, buffer->end))
+    {
+        return parse_error(buffer, value, cJSON_Error_InvalidValue);
+    }
+
+    if (starts_with(buffer, value, "null", 4))
+    {
+        if (handler->null && !handler->null(sax->context))
+        {
+            return parse_error(buffer, value, cJSON_Error_Aborted);
+        }
+        return value + 4;
+    }
+    if (starts_with(buffer, value, "false", 5))
+    {
+        if (handler->boolean && !handler->boolean(sax->context, false))
+        {
+            return parse_error(buffer, value, cJSON_Error_Aborted);
+        }
+        return value + 5;
+    }
+    if (starts_with(buffer, value, "true", 4))
+    {
+        if (handler->boolean && !handler->boolean(sax->context, true))
+        {
+            return parse_error(buffer, value, cJSON_Error_Aborted);
+        }
+        return value + 4;
+    }
+    if (*value == '\"')
+    {
+        return sax_string(sax, value, false);
+    }
+    if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
+    {
+        return sax_number(sax, value);
+    }
+    if ((*value == '[') || (*value == '{'))
+    {
+        STATS_ENTER(buffer);
+        value = (*value == '[') ? sax_array(sax, value) : sax_object(sax, value);
+        STATS_LEAVE(buffer);
+        return value;
+    }
+
+    /* failure. */
+    return parse_error(buffer, value, cJSON_Error_InvalidValue);
+}
+
+int cJSON_ParseSAX(const char *value, size_t length, const cJSON_SAXHandler *handler, void *context, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    sax_parser sax;
+    internal_hooks hooks;
+    const char *end = NULL;
+
+    memset(&sax, '\0', sizeof(sax));
+    sax.handler = handler;
+    sax.context = context;
+    sax.buffer.content = value;
+    /* numbers too long for the stack copy that strtod gets are copied to the heap */
+    sax.buffer.hooks = &hooks;
+    if (!value || !handler || !hooks_from_allocator(&hooks, options ? options->allocator : NULL))
+    {
+        parse_error(&sax.buffer, NULL, cJSON_Error_InvalidArgument);
+    }
+    else
+    {
+        sax.buffer.end = value + length;
+        STATS_BEGIN("parse");
+        end = sax_value(&sax, skip(value, sax.buffer.end));
+        if (end && options && options->require_null_terminated)
+        {
+            end = skip(end, sax.buffer.end);
+            if ((end < sax.buffer.end) && *end)
+            {
+                parse_error(&sax.buffer, end, cJSON_Error_TrailingGarbage);
+                end = NULL;
+            }
+        }
+        if (end)
+        {
+            STATS_ADD(bytes_parsed, end - value);
+        }
+        STATS_END("parse");
+    }
+    if (error)
+    {
+        report_parse_error(&sax.buffer, end ? end : sax.buffer.error, error);
+    }
+
+    return end != NULL;
+}
+
+size_t cJSON_UnescapeString(const char *string, size_t length, char *out)
+{
+    int error_code = cJSON_Error_None;
+    char *end = NULL;
+    if (!string || !out)
+    {
+        return 0;
+    }
+
+    end = unescape_string(string, string + length, out, &error_code);
+    if (!end)
+    {
+        *out = '\0';
+        return 0;
+    }
+    *end = '\0';
+
+    return (size_t)(end - out);
+}
+
+/* Render item into p and terminate the text (the terminating zero isn't counted in p->offset) */
+static cjbool print_root(const cJSON *item, cjbool fmt, printbuffer * const p)
+{
+    char *end = NULL;
+    STATS_BEGIN("print");
+    end = print_value(item, 0, fmt, p) ? ensure(p, 1) : NULL;
+    STATS_END("print");
+    if (!end)
+    {
+        return false;
+    }
+    *end = '\0';
+
+    return true;
+}
+
+static char *print_buffered(const cJSON *item, int prebuffer, cjbool fmt, const internal_hooks * const hooks)
+{
+    printbuffer p;
+    char *shrunk = NULL;
+
+    memset(&p, '\0', sizeof(p));
+    if (prebuffer < 1)
+    {
+        prebuffer = 1;
+    }
+    p.buffer = (char*)hooks->allocate(hooks->context, prebuffer);
+    if (!p.buffer)
+    {
+        return NULL;
+    }
+    p.length = prebuffer;
+    p.hooks = hooks;
+
+    if (!print_root(item, fmt, &p))
+    {
+        if (p.buffer)
+        {
+            hooks->deallocate(hooks->context, p.buffer);
+        }
+        return NULL;
+    }
+
+    /* give the unused rest of the buffer back */
+    if (hooks->reallocate && ((p.offset + 1) < p.length))
+    {
+        shrunk = (char*)hooks->reallocate(hooks->context, p.buffer, p.offset + 1);
+        if (shrunk)
+        {
+            p.buffer = shrunk;
+        }
+    }
+
+    return p.buffer;
+}
+
+/* Render a cJSON item/entity/structure to text. */
+char *cJSON_Print(const cJSON *item)
+{
+    return print_buffered(item, 256, true, &global_hooks);
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    return print_buffered(item, 256, false, &global_hooks);
+}
+
+char *cJSON_PrintBuffered(const cJSON *item, int prebuffer, cjbool fmt)
+{
+    return print_buffered(item, prebuffer, fmt, &global_hooks);
+}
+
+char *cJSON_PrintWithAllocator(const cJSON *item, cjbool fmt, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    if (!hooks_from_allocator(&hooks, allocator))
+    {
+        return NULL;
+    }
+
+    return print_buffered(item, 256, fmt, &hooks);
+}
+
+int cJSON_PrintPreallocated(cJSON *item,char *buf, const int len, const cjbool fmt)
+{
+    printbuffer p;
+    memset(&p, '\0', sizeof(p));
+    p.buffer = buf;
+    p.length = len;
+    p.noalloc = true;
+    p.hooks = &global_hooks;
+    return print_root(item, fmt, &p);
+}
+
+/* number of characters print_string_ptr writes for str */
+static size_t string_length(const char *str)
+{
+    const unsigned char *ptr = (const unsigned char*)str;
+    size_t length = 2;
+    if (!str)
+    {
+        return length;
+    }
+    for (; *ptr; ptr++)
+    {
+        if ((*ptr == '\"') || (*ptr == '\\'))
+        {
+            length += 2;
+        }
+        else if (*ptr < 32)
+        {
+            /* \b \f \n \r \t or \uXXXX */
+            length += ((*ptr == '\b') || (*ptr == '\f') || (*ptr == '\n') || (*ptr == '\r') || (*ptr == '\t')) ? 2 : 6;
+        }
+        else
+        {
+            length++;
+        }
+    }
+
+    return length;
+}
+
+/* The number of characters print_value writes for item at depth, 0 if it can't be printed.
+ * length_fn (if set) is told the length of every array and object. */
+static size_t value_length(const cJSON *item, int depth, cjbool fmt, cJSON_LengthFunction length_fn, void *context)
+{
+    const cJSON *child = NULL;
+    size_t length = 0;
+    size_t child_length = 0;
+    char number[26];
+    printbuffer p;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_NULL:
+        case cJSON_True:
+            return 4;
+        case cJSON_False:
+            return 5;
+        case cJSON_Number:
+            /* print it, the digits of a double can't be counted without */
+            memset(&p, '\0', sizeof(p));
+            p.buffer = number;
+            p.length = (int)sizeof(number);
+            p.noalloc = true;
+            return print_number(item, &p) ? (size_t)p.offset : 0;
+        case cJSON_String:
+            return string_length(item->valuestring);
+        case cJSON_Array:
+        case cJSON_Object:
+            break;
+        default:
+            return 0;
+    }
+
+    if (!materialize(item))
+    {
+        return 0;
+    }
+    if ((item->type & 0xFF) == cJSON_Array)
+    {
+        /* [] and ", " (or ",") between the elements */
+        length = 2;
+        for (child = item->child; child; child = child->next)
+        {
+            child_length = value_length(child, depth + 1, fmt, length_fn, context);
+            if (child_length == 0)
+            {
+                return 0;
+            }
+            length += child_length + (child->next ? (fmt ? 2 : 1) : 0);
+        }
+    }
+    else
+    {
+        /* {} and with fmt "{\n" and the closing indentation */
+        length = fmt ? (3 + (size_t)depth) : 2;
+        for (child = item->child; child; child = child->next)
+        {
+            child_length = value_length(child, depth + 1, fmt, length_fn, context);
+            if (child_length == 0)
+            {
+                return 0;
+            }
+            /* key, ":" and ",", with fmt the indentation, "\t" and "\n" */
+            length += string_length(child->string) + child_length + 1 + (child->next ? 1 : 0);
+            if (fmt)
+            {
+                length += (size_t)depth + 3;
+            }
+        }
+    }
+    if (length_fn)
+    {
+        length_fn(context, item, length);
+    }
+
+    return length;
+}
+
+size_t cJSON_PrintLength(const cJSON *item, int fmt)
+{
+    return cJSON_PrintLengths(item, fmt, NULL, NULL);
+}
+
+size_t cJSON_PrintLengths(const cJSON *item, int fmt, cJSON_LengthFunction length_fn, void *context)
+{
+    if (!item)
+    {
+        return 0;
+    }
+
+    return value_length(item, 0, fmt ? true : false, length_fn, context);
+}
+
+/* size of the buffer cJSON_PrintToWriter collects output in */
+#define WRITER_BUFFER_SIZE 4096
+
+int cJSON_PrintToWriter(const cJSON *item, cJSON_WriteFunction write_fn, void *context, int fmt)
+{
+    printbuffer p;
+    cjbool success = false;
+    if (!write_fn)
+    {
+        return false;
+    }
+
+    memset(&p, '\0', sizeof(p));
+    p.buffer = (char*)global_hooks.allocate(global_hooks.context, WRITER_BUFFER_SIZE);
+    if (!p.buffer)
+    {
+        return false;
+    }
+    p.length = WRITER_BUFFER_SIZE;
+    p.hooks = &global_hooks;
+    p.write_fn = write_fn;
+    p.write_context = context;
+
+    STATS_BEGIN("print");
+    success = print_value(item, 0, fmt, &p) && flush_printbuffer(&p);
+    STATS_END("print");
+    if (p.buffer)
+    {
+        global_hooks.deallocate(global_hooks.context, p.buffer);
+    }
+
+    return success;
+}
+
+/* Parser core - when encountering text, process appropriately. */
+static const char *parse_value(cJSON *item, const char *value, parse_buffer * const buffer)
+{
+    if (!value)
+    {
+        /* Fail on null. */
+        return NULL;
+    }
+    if (!before_end(value, buffer->end))
+    {
+        return parse_error(buffer, value, cJSON_Error_InvalidValue);
+    }
+
+    /* parse the different types of values */
+    if (starts_with(buffer, value, "null", 4))
+    {
+        item->type = cJSON_NULL;
+        return value + 4;
+    }
+    if (starts_with(buffer, value, "false", 5))
+    {
+        item->type = cJSON_False;
+        return value + 5;
+    }
+    if (starts_with(buffer, value, "true", 4))
+    {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        return value + 4;
+    }
+    if (*value == '\"')
+    {
+        return parse_string(item, value, false, buffer);
+    }
+    if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
+    {
+        return parse_number(item, value, buffer);
+    }
+    if ((*value == '[') || (*value == '{'))
+    {
+        if (buffer->lazy)
+        {
+            return parse_lazy(item, value, buffer);
+        }
+        STATS_ENTER(buffer);
+        value = (*value == '[') ? parse_array(item, value, buffer) : parse_object(item, value, buffer);
+        STATS_LEAVE(buffer);
+        return value;
+    }
+
+    /* failure. */
+    return parse_error(buffer, value, cJSON_Error_InvalidValue);
+}
+
+/* Render a value to text. */
+static cjbool print_value(const cJSON *item, int depth, cjbool fmt, printbuffer * const p)
+{
+    if (!item)
+    {
+        return false;
+    }
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            return print_raw(p, "null", 4);
+        case cJSON_False:
+            return print_raw(p, "false", 5);
+        case cJSON_True:
+            return print_raw(p, "true", 4);
+        case cJSON_Number:
+            return print_number(item, p);
+        case cJSON_String:
+            return print_string(item, p);
+        case cJSON_Array:
+            return print_array(item, depth, fmt, p);
+        case cJSON_Object:
+            return print_object(item, depth, fmt, p);
+        default:
+            return false;
+    }
+}
+
+/* Build an array from input text. */
+static const char *parse_array(cJSON *item, const char *value, parse_buffer * const buffer)
+{
+    cJSON *child = NULL;
+    size_t count = 1;
+    if (!is_char(buffer, value, '['))
+    {
+        /* not an array! */
+        return parse_error(buffer, value, cJSON_Error_InvalidValue);
+    }
+
+    item->type = cJSON_Array;
+    value = skip(value + 1, buffer->end);
+    if (is_char(buffer, value, ']'))
+    {
+        /* empty array. */
+        return value + 1;
+    }
+
+    item->child = child = cJSON_New_Item(buffer->hooks);
+    if (!item->child)
+    {
+        /* memory fail */
+        return parse_error(buffer, value, cJSON_Error_Memory);
+    }
+    /* skip any spacing, get the value. */
+    value = skip(parse_value(child, skip(value, buffer->end), buffer), buffer->end);
+    if (!value)
+    {
+        return NULL;
+    }
+
+    /* loop through the comma separated array elements */
+    while (is_char(buffer, value, ','))
+    {
+        cJSON *new_item = NULL;
+        if (!(new_item = cJSON_New_Item(buffer->hooks)))
+        {
+            /* memory fail */
+            return parse_error(buffer, value, cJSON_Error_Memory);
+        }
+        /* add new item to end of the linked list */
+        child->next = new_item;
+        new_item->prev = child;
+        child = new_item;
+        count++;
+
+        /* go to the next comma */
+        value = skip(parse_value(child, skip(value + 1, buffer->end), buffer), buffer->end);
+        if (!value)
+        {
+            /* memory fail */
+            return NULL;
+        }
+    }
+
+    if (is_char(buffer, value, ']'))
+    {
+        /* end of array */
+        if (buffer->index_threshold && (count >= buffer->index_threshold))
+        {
+            /* the index is optional, parsing doesn't fail without it */
+            item->index = create_index(buffer->hooks);
+            if (item->index)
+            {
+                index_build(item);
+            }
+        }
+        return value + 1;
+    }
+
+    /* malformed. */
+    return parse_error(buffer, value, cJSON_Error_UnterminatedArray);
+}
+
+/* Render an array to text */
+static cjbool print_array(const cJSON *item, int depth, cjbool fmt, printbuffer * const p)
+{
+    cJSON *child = NULL;
+    if (!materialize(item))
+    {
+        return false;
+    }
+    child = item->child;
+
+    /* opening square bracket */
+    if (!print_raw(p, "[", 1))
+    {
+        return false;
+    }
+    while (child)
+    {
+        if (!print_value(child, depth + 1, fmt, p))
+        {
+            return false;
+        }
+        if (child->next && !print_raw(p, fmt ? ", " : ",", fmt ? 2 : 1))
+        {
+            return false;
+        }
+        child = child->next;
+    }
+
+    return print_raw(p, "]", 1);
+}
+
+/* Build an object from the text. */
+static const char *parse_object(cJSON *item, const char *value, parse_buffer * const buffer)
+{
+    cJSON *child = NULL;
+    size_t count = 1;
+    if (!is_char(buffer, value, '{'))
+    {
+        /* not an object! */
+        return parse_error(buffer, value, cJSON_Error_InvalidValue);
+    }
+
+    item->type = cJSON_Object;
+    value = skip(value + 1, buffer->end);
+    if (is_char(buffer, value, '}'))
+    {
+        /* empty object. */
+        return value + 1;
+    }
+
+    child = cJSON_New_Item(buffer->hooks);
+    item->child = child;
+    if (!item->child)
+    {
+        return parse_error(buffer, value, cJSON_Error_Memory);
+    }
+    /* parse first key */
+    value = skip(parse_string(child, skip(value, buffer->end), true, buffer), buffer->end);
+    if (!value)
+    {
+        return NULL;
+    }
+
+    if (!is_char(buffer, value, ':'))
+    {
+        /* invalid object. */
+        return parse_error(buffer, value, cJSON_Error_ExpectedColon);
+    }
+    /* skip any spacing, get the value. */
+    value = skip(parse_value(child, skip(value + 1, buffer->end), buffer), buffer->end);
+    if (buffer->strings || buffer->in_place)
+    {
+        /* the key isn't owned by child, parse_value has overwritten the flag */
+        child->type |= cJSON_StringIsConst | (buffer->in_place ? cJSON_StringIsInBuffer : 0);
+    }
+    if (!value)
+    {
+        return NULL;
+    }
+
+    while (is_char(buffer, value, ','))
+    {
+        cJSON *new_item = NULL;
+        if (!(new_item = cJSON_New_Item(buffer->hooks)))
+        {
+            /* memory fail */
+            return parse_error(buffer, value, cJSON_Error_Memory);
+        }
+        /* add to linked list */
+        child->next = new_item;
+        new_item->prev = child;
+
+        child = new_item;
+        count++;
+        value = skip(parse_string(child, skip(value + 1, buffer->end), true, buffer), buffer->end);
+        if (!value)
+        {
+            return NULL;
+        }
+
+        if (!is_char(buffer, value, ':'))
+        {
+            /* invalid object. */
+            return parse_error(buffer, value, cJSON_Error_ExpectedColon);
+        }
+        /* skip any spacing, get the value. */
+        value = skip(parse_value(child, skip(value + 1, buffer->end), buffer), buffer->end);
+        if (buffer->strings || buffer->in_place)
+        {
+            child->type |= cJSON_StringIsConst | (buffer->in_place ? cJSON_StringIsInBuffer : 0);
+        }
+        if (!value)
+        {
+            return NULL;
+        }
+    }
+    /* end of object */
+    if (is_char(buffer, value, '}'))
+    {
+        if (buffer->index_threshold && (count >= buffer->index_threshold))
+        {
+            /* the index is optional, parsing doesn't fail without it */
+            item->index = create_index(buffer->hooks);
+            if (item->index)
+            {
+                index_build(item);
+            }
+        }
+        return value + 1;
+    }
+
+    /* malformed */
+    return parse_error(buffer, value, cJSON_Error_UnterminatedObject);
+}
+
+/* Render an object to text. */
+static cjbool print_object(const cJSON *item, int depth, cjbool fmt, printbuffer * const p)
+{
+    cJSON *child = NULL;
+    if (!materialize(item))
+    {
+        return false;
+    }
+    child = item->child;
+
+    /* fmt: {\n */
+    if (!print_raw(p, fmt ? "{\n" : "{", fmt ? 2 : 1))
+    {
+        return false;
+    }
+    depth++;
+    while (child)
+    {
+        if (fmt && !print_indentation(p, depth))
+        {
+            return false;
+        }
+
+        /* print key */
+        if (!print_string_ptr(child->string, p) || !print_raw(p, fmt ? ":\t" : ":", fmt ? 2 : 1))
+        {
+            return false;
+        }
+
+        /* print value */
+        if (!print_value(child, depth, fmt, p))
+        {
+            return false;
+        }
+
+        /* print comma if not last */
+        if (child->next && !print_raw(p, ",", 1))
+        {
+            return false;
+        }
+        if (fmt && !print_raw(p, "\n", 1))
+        {
+            return false;
+        }
+
+        child = child->next;
+    }
+    if (fmt && !print_indentation(p, depth - 1))
+    {
+        return false;
+    }
+
+    return print_raw(p, "}", 1);
+}
+
+/* Lookup index of arrays and objects, see cJSON_EnableIndex. */
+typedef struct
+{
+    cJSON *item;
+    unsigned long hash;
+} index_entry;
+
+struct cJSON_Index
+{
+    /* number of children, valid whenever the index isn't stale */
+    size_t child_count;
+    /* the children in list order, NULL if there is no memory for it */
+    cJSON **items;
+    size_t items_size;
+    /* open addressing hash table (linear probing) of the object members, keyed by their case folded name.
+     * Arrays and objects with duplicate (or missing) keys have no table, lookups walk the list. */
+    index_entry *table;
+    size_t table_size; /* 0 or a power of 2 */
+    size_t count;
+    /* the index has to be rebuilt before it can be used */
+    cjbool stale;
+    /* memory for the index comes from here */
+    internal_hooks hooks;
+    /* Lazy containers have nothing but this: their text (from the opening bracket), the end of the input and the
+     * index threshold, string table and in place mode to parse it with. Set only until the container is materialized. */
+    const char *lazy;
+    const char *lazy_end;
+    size_t lazy_index_threshold;
+    cJSON_StringTable *lazy_strings;
+    size_t lazy_intern_value_length;
+    cjbool lazy_in_place;
+};
+
+#define INDEX_MIN_TABLE_SIZE 8
+/* position of an item in its parent is not known */
+#define INDEX_UNKNOWN_POSITION ((size_t)-1)
+
+/* FNV-1a over the case folded key, so case sensitive and insensitive lookups can share the table */
+static unsigned long index_hash(const char *key)
+{
+    const unsigned char *ptr = (const unsigned char*)key;
+    unsigned long hash = 2166136261UL;
+    for (; *ptr; ptr++)
+    {
+        hash ^= (unsigned long)tolower(*ptr);
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+static struct cJSON_Index *create_index(const internal_hooks * const hooks)
+{
+    struct cJSON_Index *index = (struct cJSON_Index*)hooks->allocate(hooks->context, sizeof(struct cJSON_Index));
+    if (!index)
+    {
+        return NULL;
+    }
+    memset(index, '\0', sizeof(struct cJSON_Index));
+    index->stale = true;
+    index->hooks = *hooks;
+
+    return index;
+}
+
+static void index_drop_table(struct cJSON_Index * const index)
+{
+    if (index->table)
+    {
+        index->hooks.deallocate(index->hooks.context, index->table);
+        index->table = NULL;
+    }
+    index->table_size = 0;
+    index->count = 0;
+}
+
+static void index_drop_items(struct cJSON_Index * const index)
+{
+    if (index->items)
+    {
+        index->hooks.deallocate(index->hooks.context, index->items);
+        index->items = NULL;
+    }
+    index->items_size = 0;
+}
+
+static void delete_index(struct cJSON_Index *index)
+{
+    internal_hooks hooks = index->hooks;
+    index_drop_table(index);
+    index_drop_items(index);
+    hooks.deallocate(hooks.context, index);
+}
+
+/* make room for at least needed children in the vector, drops it if there is no memory */
+static cjbool index_reserve(struct cJSON_Index * const index, const size_t needed)
+{
+    cJSON **items = NULL;
+    size_t size = index->items_size ? index->items_size : INDEX_MIN_TABLE_SIZE;
+
+    if (index->items && (needed <= index->items_size))
+    {
+        return true;
+    }
+    while (size < needed)
+    {
+        size *= 2;
+    }
+
+    if (index->hooks.reallocate)
+    {
+        items = (cJSON**)index->hooks.reallocate(index->hooks.context, index->items, size * sizeof(cJSON*));
+    }
+    else
+    {
+        items = (cJSON**)index->hooks.allocate(index->hooks.context, size * sizeof(cJSON*));
+        if (items && index->items)
+        {
+            memcpy(items, index->items, index->child_count * sizeof(cJSON*));
+            index_drop_items(index);
+        }
+    }
+    if (!items)
+    {
+        index_drop_items(index);
+        return false;
+    }
+    index->items = items;
+    index->items_size = size;
+
+    return true;
+}
+
+/* put an item into the table, fails if an item with the same case folded key is already in it */
+static cjbool index_insert(struct cJSON_Index * const index, cJSON * const item, const unsigned long hash)
+{
+    const size_t mask = index->table_size - 1;
+    size_t slot = (size_t)hash & mask;
+    while (index->table[slot].item)
+    {
+        if ((index->table[slot].hash == hash) && !cJSON_strcasecmp(index->table[slot].item->string, item->string))
+        {
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+    index->table[slot].item = item;
+    index->table[slot].hash = hash;
+    index->count++;
+
+    return true;
+}
+
+/* build the hash table of an object, leaves it without one if that isn't possible */
+static void index_build_table(const cJSON * const object)
+{
+    struct cJSON_Index *index = object->index;
+    cJSON *child = NULL;
+    size_t size = INDEX_MIN_TABLE_SIZE;
+
+    for (child = object->child; child; child = child->next)
+    {
+        if (!child->string)
+        {
+            /* can't be hashed, walk the list instead */
+            return;
+        }
+    }
+    while (size < (index->child_count * 2))
+    {
+        size *= 2;
+    }
+
+    index->table = (index_entry*)index->hooks.allocate(index->hooks.context, size * sizeof(index_entry));
+    if (!index->table)
+    {
+        /* lookups fall back to walking the list */
+        return;
+    }
+    memset(index->table, '\0', size * sizeof(index_entry));
+    index->table_size = size;
+
+    for (child = object->child; child; child = child->next)
+    {
+        if (!index_insert(index, child, index_hash(child->string)))
+        {
+            /* duplicate keys, the table can't tell which of them comes first in the list */
+            index_drop_table(index);
+            return;
+        }
+    }
+}
+
+/* (re)build the index of an array or object */
+static void index_build(const cJSON * const item)
+{
+    struct cJSON_Index *index = item->index;
+    cJSON *child = NULL;
+    size_t count = 0;
+
+    index_drop_table(index);
+    index->stale = false;
+    index->child_count = 0;
+
+    for (child = item->child; child; child = child->next)
+    {
+        count++;
+    }
+    if (index_reserve(index, count))
+    {
+        for (child = item->child; child; child = child->next)
+        {
+            index->items[index->child_count++] = child;
+        }
+    }
+    index->child_count = count;
+
+    if ((item->type & 0xFF) == cJSON_Object)
+    {
+        index_build_table(item);
+    }
+}
+
+/* get the index of item, rebuilding it if necessary. NULL if it has none. */
+static struct cJSON_Index *index_ready(const cJSON * const item)
+{
+    if (!item->index || !materialize(item) || !item->index)
+    {
+        return NULL;
+    }
+    if (item->index->stale)
+    {
+        index_build(item);
+    }
+
+    return item->index;
+}
+
+/* Look up a member through the index of object. Returns false if there is no usable index and the list has to be walked. */
+static cjbool index_find(const cJSON * const object, const char * const string, const cjbool case_sensitive, cJSON ** const found)
+{
+    struct cJSON_Index *index = index_ready(object);
+    unsigned long hash = 0;
+    size_t mask = 0;
+    size_t slot = 0;
+
+    if (!index || !index->table || !string)
+    {
+        return false;
+    }
+
+    hash = index_hash(string);
+    mask = index->table_size - 1;
+    for (slot = (size_t)hash & mask; index->table[slot].item; slot = (slot + 1) & mask)
+    {
+        cJSON *candidate = index->table[slot].item;
+        STATS_ADD(key_comparisons, 1);
+        if ((candidate->string == string) || ((index->table[slot].hash == hash) && !cJSON_strcasecmp(candidate->string, string)))
+        {
+            /* keys are unique case insensitively, so if this one doesn't match exactly, no other one will */
+            *found = (!case_sensitive || !strcmp(candidate->string, string)) ? candidate : NULL;
+            return true;
+        }
+    }
+    *found = NULL;
+
+    return true;
+}
+
+/* Find the n-th child of a container, position is set to where it was found (NULL if there aren't that many).
+ * Like the list walk it replaces, everything below 0 means the first child. */
+static cJSON *get_item_at(const cJSON * const container, int which, size_t * const position)
+{
+    struct cJSON_Index *index = index_ready(container);
+    cJSON *c = NULL;
+
+    if (which < 0)
+    {
+        which = 0;
+    }
+    *position = (size_t)which;
+
+    if (index && index->items)
+    {
+        return ((size_t)which < index->child_count) ? index->items[which] : NULL;
+    }
+
+    c = container->child;
+    while (c && (which > 0))
+    {
+        c = c->next;
+        which--;
+    }
+
+    return c;
+}
+
+/* keep the hash table of parent up to date after item has been linked into it */
+static void table_add(const cJSON * const parent, cJSON * const item)
+{
+    struct cJSON_Index *index = parent->index;
+    if (!index->table)
+    {
+        return;
+    }
+    if (!item->string || (((index->count + 1) * 4) > (index->table_size * 3)))
+    {
+        /* rebuild (and grow) on the next lookup */
+        index->stale = true;
+        return;
+    }
+    if (!index_insert(index, item, index_hash(item->string)))
+    {
+        index_drop_table(index);
+    }
+}
+
+/* keep the hash table of parent up to date after item has been unlinked from it */
+static void table_remove(const cJSON * const parent, const cJSON * const item)
+{
+    struct cJSON_Index *index = parent->index;
+    size_t mask = 0;
+    size_t slot = 0;
+    size_t next = 0;
+    size_t home = 0;
+
+    if ((parent->type & 0xFF) != cJSON_Object)
+    {
+        return;
+    }
+    if (!index->table || !item->string)
+    {
+        /* the reason there was no table might be gone now */
+        index->stale = true;
+        return;
+    }
+
+    mask = index->table_size - 1;
+    for (slot = (size_t)index_hash(item->string) & mask; index->table[slot].item != item; slot = (slot + 1) & mask)
+    {
+        if (!index->table[slot].item)
+        {
+            /* not in the table, somebody modified the list behind our back */
+            index->stale = true;
+            return;
+        }
+    }
+
+    /* remove the entry and move the following ones of the cluster back where they belong */
+    index->table[slot].item = NULL;
+    index->count--;
+    for (next = (slot + 1) & mask; index->table[next].item; next = (next + 1) & mask)
+    {
+        home = (size_t)index->table[next].hash & mask;
+        /* can the entry at next be moved to the empty slot without getting in front of its home slot? */
+        if (((next > slot) && ((home <= slot) || (home > next))) || ((next < slot) && (home <= slot) && (home > next)))
+        {
+            index->table[slot] = index->table[next];
+            index->table[next].item = NULL;
+            slot = next;
+        }
+    }
+}
+
+/* find where item is in the vector, given a guess. Marks the index stale if it isn't there. */
+static cjbool index_locate(struct cJSON_Index * const index, const cJSON * const item, size_t * const position)
+{
+    size_t i = 0;
+    if ((*position < index->child_count) && (index->items[*position] == item))
+    {
+        return true;
+    }
+    for (i = 0; i < index->child_count; i++)
+    {
+        if (index->items[i] == item)
+        {
+            *position = i;
+            return true;
+        }
+    }
+    /* somebody modified the list behind our back */
+    index->stale = true;
+
+    return false;
+}
+
+/* keep the index of parent up to date after item has been linked into it at position */
+static void index_add(const cJSON * const parent, cJSON * const item, const size_t position)
+{
+    struct cJSON_Index *index = parent->index;
+    if (!index || index->stale)
+    {
+        return;
+    }
+
+    if (index->items && index_reserve(index, index->child_count + 1))
+    {
+        memmove(index->items + position + 1, index->items + position, (index->child_count - position) * sizeof(cJSON*));
+        index->items[position] = item;
+    }
+    index->child_count++;
+    table_add(parent, item);
+}
+
+/* keep the index of parent up to date after item has been unlinked from it, position is a guess */
+static void index_remove(const cJSON * const parent, const cJSON * const item, size_t position)
+{
+    struct cJSON_Index *index = parent->index;
+    if (!index || index->stale)
+    {
+        return;
+    }
+
+    if (index->items)
+    {
+        if (!index_locate(index, item, &position))
+        {
+            return;
+        }
+        memmove(index->items + position, index->items + position + 1, (index->child_count - position - 1) * sizeof(cJSON*));
+    }
+    index->child_count--;
+    table_remove(parent, item);
+}
+
+/* keep the index of parent up to date after item has taken the place of old, position is a guess */
+static void index_replace(const cJSON * const parent, const cJSON * const old, cJSON * const item, size_t position)
+{
+    struct cJSON_Index *index = parent->index;
+    if (!index || index->stale)
+    {
+        return;
+    }
+
+    if (index->items)
+    {
+        if (!index_locate(index, old, &position))
+        {
+            return;
+        }
+        index->items[position] = item;
+    }
+    table_remove(parent, old);
+    if (!index->stale)
+    {
+        table_add(parent, item);
+    }
+}
+
+/* Lazy parsing: containers are validated right away, but their children are only parsed when something needs them. */
+
+/* one past the closing bracket of the valid array or object at value */
+static const char *container_end(const char *value, const char * const end)
+{
+    size_t depth = 0;
+    for (; before_end(value, end) && *value; value++)
+    {
+        switch (*value)
+        {
+            case '\"':
+                if (!(value = closing_quote(value, end)))
+                {
+                    return NULL;
+                }
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0)
+                {
+                    return value + 1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+/* Make item a lazy array or object for the text at value. */
+static const char *parse_lazy(cJSON *item, const char *value, parse_buffer * const buffer)
+{
+    cJSON_SAXHandler handler;
+    sax_parser sax;
+    struct cJSON_Index *index = NULL;
+    const char *end = NULL;
+
+    if (buffer->validated)
+    {
+        end = container_end(value, buffer->end);
+    }
+    else
+    {
+        /* check the whole container now, so materializing it can only fail for lack of memory */
+        memset(&handler, '\0', sizeof(handler));
+        memset(&sax, '\0', sizeof(sax));
+        sax.buffer = *buffer;
+        sax.handler = &handler;
+        end = sax_value(&sax, value);
+        if (!end)
+        {
+            return parse_error(buffer, sax.buffer.error, sax.buffer.error_code);
+        }
+    }
+
+    index = create_index(buffer->hooks);
+    if (!index)
+    {
+        return parse_error(buffer, value, cJSON_Error_Memory);
+    }
+    index->lazy = value;
+    index->lazy_end = buffer->end;
+    index->lazy_index_threshold = buffer->index_threshold;
+    index->lazy_strings = buffer->strings;
+    index->lazy_intern_value_length = buffer->intern_value_length;
+    index->lazy_in_place = buffer->in_place;
+    item->type = (*value == '[') ? cJSON_Array : cJSON_Object;
+    item->index = index;
+
+    return end;
+}
+
+/* Parse the children of a lazy container, leaving its grandchildren lazy. Anything that reads child has to call this
+ * first. Returns false if there is no memory, the container then stays lazy and looks empty. */
+static cjbool materialize(const cJSON * const item)
+{
+    struct cJSON_Index *index = item->index;
+    parse_buffer buffer;
+    cJSON *container = NULL;
+    const char *end = NULL;
+    int flags = 0;
+
+    if (!index || !index->lazy)
+    {
+        return true;
+    }
+
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.content = index->lazy;
+    buffer.end = index->lazy_end;
+    buffer.hooks = &index->hooks;
+    buffer.index_threshold = index->lazy_index_threshold;
+    buffer.strings = index->lazy_strings;
+    buffer.intern_value_length = index->lazy_intern_value_length;
+    buffer.in_place = index->lazy_in_place;
+    buffer.lazy = true;
+    buffer.validated = true;
+
+    /* like rebuilding a stale index, this doesn't change the value of item */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    container = (cJSON*)item;
+#pragma GCC diagnostic pop
+    flags = container->type & ~0xFF;
+    container->index = NULL;
+    end = (*index->lazy == '[') ? parse_array(container, index->lazy, &buffer) : parse_object(container, index->lazy, &buffer);
+    container->type |= flags;
+    if (!end)
+    {
+        delete_item(container->child, &index->hooks);
+        container->child = NULL;
+        container->index = index;
+        return false;
+    }
+    delete_index(index);
+
+    return true;
+}
+
+/* Point the indexes (and with them the lazy containers) in a list of items at other hooks, for trees that were
+ * parsed into an arena that has since been merged into another one. */
+static void index_rehook(cJSON *item, const internal_hooks * const hooks)
+{
+    for (; item; item = item->next)
+    {
+        if (item->index)
+        {
+            item->index->hooks = *hooks;
+        }
+        if (!(item->type & cJSON_IsReference))
+        {
+            index_rehook(item->child, hooks);
+        }
+    }
+}
+
+cjbool cJSON_Materialize(const cJSON *item)
+{
+    return item ? materialize(item) : false;
+}
+
+cjbool cJSON_EnableIndex(cJSON *item)
+{
+    if (!item || (item->type & (cJSON_IsReference | cJSON_IsImmutable)) || !(item->type & (cJSON_Array | cJSON_Object)) || !materialize(item))
+    {
+        return false;
+    }
+    if (!item->index)
+    {
+        item->index = create_index(&global_hooks);
+    }
+
+    return item->index != NULL;
+}
+
+void cJSON_DisableIndex(cJSON *item)
+{
+    if (item && item->index && !(item->type & cJSON_IsImmutable) && materialize(item) && item->index)
+    {
+        delete_index(item->index);
+        item->index = NULL;
+    }
+}
+
+void cJSON_InvalidateIndex(cJSON *item)
+{
+    if (item && item->index && !(item->type & cJSON_IsImmutable))
+    {
+        item->index->stale = true;
+    }
+}
+
+/* Get Array size/item / object item. */
+int    cJSON_GetArraySize(const cJSON *array)
+{
+    struct cJSON_Index *index = index_ready(array);
+    cJSON *c = NULL;
+    int i = 0;
+    if (index)
+    {
+        return (int)index->child_count;
+    }
+    c = array->child;
+    while(c)
+    {
+        i++;
+        c = c->next;
+    }
+    return i;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int item)
+{
+    size_t position = 0;
+    return array ? get_item_at(array, item, &position) : NULL;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    cJSON *c = NULL;
+    if (object && index_find(object, string, false, &c))
+    {
+        return c;
+    }
+
+    c = object ? object->child : NULL;
+    while (c && (STATS_ADD(key_comparisons, 1), cJSON_strcasecmp(c->string, string)))
+    {
+        c = c->next;
+    }
+    return c;
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    cJSON *c = NULL;
+    if (object && index_find(object, string, true, &c))
+    {
+        return c;
+    }
+
+    c = object ? object->child : NULL;
+    while (c && (STATS_ADD(key_comparisons, 1), (c->string != string)) && (!c->string || !string || strcmp(c->string, string)))
+    {
+        c = c->next;
+    }
+    return c;
+}
+
+cjbool cJSON_HasObjectItem(const cJSON *object,const char *string)
+{
+    return cJSON_GetObjectItem(object, string) ? 1 : 0;
+}
+
+/* Utility for array list handling. */
+static void suffix_object(cJSON *prev, cJSON *item)
+{
+    prev->next = item;
+    item->prev = prev;
+}
+
+/* Utility for handling references. */
+static cJSON *create_reference(const cJSON *item)
+{
+    cJSON *ref = NULL;
+    /* the reference shares the children, so there have to be some */
+    if (!materialize(item) || !(ref = cJSON_New_Item(&global_hooks)))
+    {
+        return NULL;
+    }
+    memcpy(ref, item, sizeof(cJSON));
+    ref->string = NULL;
+    /* a plain reference, even to a frozen item: unshare keeps frozen children read only through it (and the
+     * reference doesn't keep them alive) */
+    ref->type = (ref->type & ~(cJSON_IsShared | cJSON_IsImmutable)) | cJSON_IsReference;
+    ref->next = ref->prev = NULL;
+    /* the index belongs to the original */
+    ref->index = NULL;
+    return ref;
+}
+
+/* An item handed over to a container that can't be modified (frozen, or out of memory unsharing it) is freed, unless
+ * it belongs to a shared subtree itself. */
+static void reject_item(cJSON *item, const internal_hooks * const hooks)
+{
+    if (!(item->type & cJSON_IsImmutable))
+    {
+        delete_item(item, hooks);
+    }
+}
+
+/* Add item to array/object. */
+void   cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    struct cJSON_Index *index = NULL;
+    cJSON *c = NULL;
+    if (!item || !array)
+    {
+        return;
+    }
+    if ((item->type & cJSON_IsImmutable) || !unshare(array))
+    {
+        reject_item(item, &global_hooks);
+        return;
+    }
+    index = index_ready(array);
+    c = array->child;
+    if (!c)
+    {
+        /* list is empty, start new one */
+        array->child = item;
+    }
+    else
+    {
+        if (index && index->items && index->child_count)
+        {
+            /* the last item is known */
+            c = index->items[index->child_count - 1];
+        }
+        else
+        {
+            /* append to the end */
+            while (c->next)
+            {
+                c = c->next;
+            }
+        }
+        suffix_object(c, item);
+    }
+    if (index)
+    {
+        index_add(array, item, index->child_count);
+    }
+}
+
+static void add_item_to_object(cJSON *object, const char *string, cJSON *item, const internal_hooks * const hooks)
+{
+    if (!item || !object)
+    {
+        return;
+    }
+    if ((item->type & cJSON_IsImmutable) || !unshare(object))
+    {
+        reject_item(item, hooks);
+        return;
+    }
+
+    /* free old key and set new one */
+    if (!(item->type & cJSON_StringIsConst) && item->string)
+    {
+        hooks->deallocate(hooks->context, item->string);
+    }
+    item->string = cJSON_strdup(string, hooks);
+    item->type &= ~cJSON_StringIsConst;
+
+    cJSON_AddItemToArray(object,item);
+}
+
+void   cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    add_item_to_object(object, string, item, &global_hooks);
+}
+
+void cJSON_AddItemToObjectWithAllocator(cJSON *object, const char *string, cJSON *item, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    if (hooks_from_allocator(&hooks, allocator))
+    {
+        add_item_to_object(object, string, item, &hooks);
+    }
+}
+
+/* Add an item to an object with constant string as key */
+void   cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
+{
+    if (!item || !object)
+    {
+        return;
+    }
+    if ((item->type & cJSON_IsImmutable) || !unshare(object))
+    {
+        reject_item(item, &global_hooks);
+        return;
+    }
+    if (!(item->type & cJSON_StringIsConst) && item->string)
+    {
+        cJSON_free(item->string);
+    }
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+    item->string = (char*)string;
+#pragma GCC diagnostic pop
+    item->type |= cJSON_StringIsConst;
+    cJSON_AddItemToArray(object, item);
+}
+
+void cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
+{
+    cJSON_AddItemToArray(array, create_reference(item));
+}
+
+void cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
+{
+    cJSON_AddItemToObject(object, string, create_reference(item));
+}
+
+/* unlink item from the list of parent, position is where it is in the list (if known) */
+static cJSON *detach_item(cJSON *parent, cJSON *c, const size_t position)
+{
+    if (c->prev)
+    {
+        /* not the first element */
+        c->prev->next = c->next;
+    }
+    if (c->next)
+    {
+        c->next->prev = c->prev;
+    }
+    if (c==parent->child)
+    {
+        parent->child = c->next;
+    }
+    /* make sure the detached item doesn't point anywhere anymore */
+    c->prev = c->next = NULL;
+    index_remove(parent, c, position);
+
+    return c;
+}
+
+cJSON *cJSON_DetachItemFromArray(cJSON *array, int which)
+{
+    size_t position = 0;
+    cJSON *c = unshare(array) ? get_item_at(array, which, &position) : NULL;
+    if (!c)
+    {
+        /* item doesn't exist */
+        return NULL;
+    }
+
+    return detach_item(array, c, position);
+}
+
+void cJSON_DeleteItemFromArray(cJSON *array, int which)
+{
+    cJSON_Delete(cJSON_DetachItemFromArray(array, which));
+}
+
+cJSON *cJSON_DetachItemFromObject(cJSON *object, const char *string)
+{
+    cJSON *c = unshare(object) ? cJSON_GetObjectItem(object, string) : NULL;
+    if (c)
+    {
+        return detach_item(object, c, INDEX_UNKNOWN_POSITION);
+    }
+
+    return NULL;
+}
+
+void cJSON_DeleteItemFromObject(cJSON *object, const char *string)
+{
+    cJSON_Delete(cJSON_DetachItemFromObject(object, string));
+}
+
+/* Replace array/object items with new ones. */
+void cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
+{
+    size_t position = 0;
+    cJSON *c = NULL;
+    if (!newitem || !array)
+    {
+        return;
+    }
+    if ((newitem->type & cJSON_IsImmutable) || !unshare(array))
+    {
+        reject_item(newitem, &global_hooks);
+        return;
+    }
+    c = get_item_at(array, which, &position);
+    if (!c)
+    {
+        cJSON_AddItemToArray(array, newitem);
+        return;
+    }
+    newitem->next = c;
+    newitem->prev = c->prev;
+    c->prev = newitem;
+    if (c == array->child)
+    {
+        array->child = newitem;
+    }
+    else
+    {
+        newitem->prev->next = newitem;
+    }
+    index_add(array, newitem, position);
+}
+
+/* put newitem into the place of c in the list of parent and delete c */
+static void replace_item(cJSON *parent, cJSON *c, cJSON *newitem, const size_t position)
+{
+    newitem->next = c->next;
+    newitem->prev = c->prev;
+    if (newitem->next)
+    {
+        newitem->next->prev = newitem;
+    }
+    if (c == parent->child)
+    {
+        parent->child = newitem;
+    }
+    else
+    {
+        newitem->prev->next = newitem;
+    }
+    index_replace(parent, c, newitem, position);
+    c->next = c->prev = NULL;
+    cJSON_Delete(c);
+}
+
+void cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
+{
+    size_t position = 0;
+    cJSON *c = NULL;
+    if (!newitem || !array)
+    {
+        return;
+    }
+    if ((newitem->type & cJSON_IsImmutable) || !unshare(array))
+    {
+        reject_item(newitem, &global_hooks);
+        return;
+    }
+    c = get_item_at(array, which, &position);
+    if (!c)
+    {
+        return;
+    }
+    replace_item(array, c, newitem, position);
+}
+
+void cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
+{
+    cJSON *c = NULL;
+    if (!newitem || !object)
+    {
+        return;
+    }
+    if ((newitem->type & cJSON_IsImmutable) || !unshare(object))
+    {
+        reject_item(newitem, &global_hooks);
+        return;
+    }
+    c = cJSON_GetObjectItem(object, string);
+    if(c)
+    {
+        /* free the old string if not const */
+        if (!(newitem->type & cJSON_StringIsConst) && newitem->string)
+        {
+             cJSON_free(newitem->string);
+        }
+
+        newitem->string = cJSON_strdup(string, &global_hooks);
+        newitem->type &= ~cJSON_StringIsConst;
+        replace_item(object, c, newitem, INDEX_UNKNOWN_POSITION);
+    }
+}
+
+/* Create basic types: */
+cJSON *cJSON_CreateNull(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_NULL;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_CreateTrue(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_True;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_CreateFalse(void)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_False;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_CreateBool(cjbool b)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = b ? cJSON_True : cJSON_False;
+    }
+
+    return item;
+}
+
+static cJSON *create_number(double num, const internal_hooks * const hooks)
+{
+    cJSON *item = cJSON_New_Item(hooks);
+    if(item)
+    {
+        item->type = cJSON_Number;
+        item->valuedouble = num;
+        item->valueint = (int)num;
+    }
+
+    return item;
+}
+
+static cJSON *create_string(const char *string, const internal_hooks * const hooks)
+{
+    cJSON *item = cJSON_New_Item(hooks);
+    if(item)
+    {
+        item->type = cJSON_String;
+        item->valuestring = cJSON_strdup(string, hooks);
+        if(!item->valuestring)
+        {
+            delete_item(item, hooks);
+            return NULL;
+        }
+    }
+
+    return item;
+}
+
+static cJSON *create_container(int type, const internal_hooks * const hooks)
+{
+    cJSON *item = cJSON_New_Item(hooks);
+    if (item)
+    {
+        item->type = type;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_CreateNumber(double num)
+{
+    return create_number(num, &global_hooks);
+}
+
+cJSON *cJSON_CreateInt64(cJSON_int64 num)
+{
+    cJSON *item = cJSON_New_Item(&global_hooks);
+    if(item)
+    {
+        item->type = cJSON_Number | cJSON_NumberIsInt64;
+        item->valuedouble = (double)num;
+        item->valueint = clamp_to_int(item->valuedouble);
+        item->valueint64 = num;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_CreateString(const char *string)
+{
+    return create_string(string, &global_hooks);
+}
+
+cJSON *cJSON_CreateArray(void)
+{
+    return create_container(cJSON_Array, &global_hooks);
+}
+
+cJSON *cJSON_CreateObject(void)
+{
+    return create_container(cJSON_Object, &global_hooks);
+}
+
+cJSON *cJSON_CreateNumberWithAllocator(double num, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    return hooks_from_allocator(&hooks, allocator) ? create_number(num, &hooks) : NULL;
+}
+
+cJSON *cJSON_CreateStringWithAllocator(const char *string, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    return hooks_from_allocator(&hooks, allocator) ? create_string(string, &hooks) : NULL;
+}
+
+cJSON *cJSON_CreateArrayWithAllocator(const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    return hooks_from_allocator(&hooks, allocator) ? create_container(cJSON_Array, &hooks) : NULL;
+}
+
+cJSON *cJSON_CreateObjectWithAllocator(const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    return hooks_from_allocator(&hooks, allocator) ? create_container(cJSON_Object, &hooks) : NULL;
+}
+
+/* Create Arrays: */
+cJSON *cJSON_CreateIntArray(const int *numbers, int count)
+{
+    int i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = cJSON_CreateArray();
+    for(i = 0; a && (i < count); i++)
+    {
+        n = cJSON_CreateNumber(numbers[i]);
+        if (!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
+        }
+        p = n;
+    }
+
+    return a;
+}
+
+cJSON *cJSON_CreateFloatArray(const float *numbers, int count)
+{
+    int i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = cJSON_CreateArray();
+    for(i = 0; a && (i < count); i++)
+    {
+        n = cJSON_CreateNumber(numbers[i]);
+        if(!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
+        }
+        p = n;
+    }
+
+    return a;
+}
+
+cJSON *cJSON_CreateDoubleArray(const double *numbers, int count)
+{
+    int i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = cJSON_CreateArray();
+    for(i = 0;a && (i < count); i++)
+    {
+        n = cJSON_CreateNumber(numbers[i]);
+        if(!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p, n);
+        }
+        p = n;
+    }
+
+    return a;
+}
+
+cJSON *cJSON_CreateStringArray(const char **strings, int count)
+{
+    int i = 0;
+    cJSON *n = NULL;
+    cJSON *p = NULL;
+    cJSON *a = cJSON_CreateArray();
+    for (i = 0; a && (i < count); i++)
+    {
+        n = cJSON_CreateString(strings[i]);
+        if(!n)
+        {
+            cJSON_Delete(a);
+            return NULL;
+        }
+        if(!i)
+        {
+            a->child = n;
+        }
+        else
+        {
+            suffix_object(p,n);
         }
+        p = n;
     }
-    *ptr2++ = '\"';
-    *ptr2++ = '\0';
 
-    return out;
+    return a;
 }
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static char *print_string(const cJSON *item, printbuffer *p)
-{
-    return print_string_ptr(item->valuestring, p);
-}
+/* Shared subtrees */
 
-/* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep);
-static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value, const char **ep);
-static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value, const char **ep);
-static char *print_object(const cJSON *item, int depth, cjbool fmt, printbuffer *p);
+/* reference counts are atomic where the compiler has a way to do that */
+#if defined(__GNUC__)
+    #define shared_retain(count) ((void)__sync_add_and_fetch((count), 1))
+    #define shared_release(count) (__sync_sub_and_fetch((count), 1) == 0)
+#elif defined(_MSC_VER)
+    #include <intrin.h>
+    #define shared_retain(count) ((void)_InterlockedIncrement(count))
+    #define shared_release(count) (_InterlockedDecrement(count) == 0)
+#else
+    #define shared_retain(count) ((void)++*(count))
+    #define shared_release(count) (--*(count) == 0)
+#endif
 
-/* Utility to jump whitespace and cr/lf */
-static const char *skip(const char *in)
+static void shared_unref(cJSON_Shared *shared)
 {
-    while (in && *in && ((unsigned char)*in<=32))
+    if (shared_release(&shared->references))
     {
-        in++;
+        delete_item(shared->root, &global_hooks);
+        global_hooks.deallocate(global_hooks.context, shared);
     }
-
-    return in;
 }
 
-/* Parse an object - create a new root, and populate. */
-cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cjbool require_null_terminated)
+/* A new item with the content of item, an item of the subtree frozen in shared (or a shared item itself). The caller
+ * sets its key. */
+static cJSON *create_shared_item(const cJSON *item, cJSON_Shared *shared)
 {
-    const char *end = NULL;
-    /* use global error pointer if no specific one was given */
-    const char **ep = return_parse_end ? return_parse_end : &global_ep;
-    cJSON *c = cJSON_New_Item();
-    *ep = NULL;
-    if (!c) /* memory fail */
+    shared_item *copy = (shared_item*)global_hooks.allocate(global_hooks.context, sizeof(shared_item));
+    if (!copy)
     {
         return NULL;
     }
-
-    end = parse_value(c, skip(value), ep);
-    if (!end)
+    memset(copy, '\0', sizeof(shared_item));
+    if (item->type & cJSON_IsShared)
     {
-        /* parse failure. ep is set. */
-        cJSON_Delete(c);
-        return NULL;
+        /* the content belongs to the subtree item has a reference to */
+        shared = ((const shared_item*)item)->shared;
     }
+    copy->item.type = (item->type & ~(cJSON_IsImmutable | cJSON_StringIsConst)) | cJSON_IsShared;
+    copy->item.child = item->child;
+    copy->item.valuestring = item->valuestring;
+    copy->item.valueint = item->valueint;
+    copy->item.valuedouble = item->valuedouble;
+    copy->item.valueint64 = item->valueint64;
+    copy->shared = shared;
+    shared_retain(&shared->references);
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    return &copy->item;
+}
+
+/* a shared item with the content and key of item, see create_shared_item */
+static cJSON *duplicate_shared(const cJSON *item, cJSON_Shared *shared)
+{
+    cJSON *copy = create_shared_item(item, shared);
+    if (copy && item->string)
     {
-        end = skip(end);
-        if (*end)
+        copy->string = cJSON_strdup(item->string, &global_hooks);
+        if (!copy->string)
         {
-            cJSON_Delete(c);
-            *ep = end;
+            delete_item(copy, &global_hooks);
             return NULL;
         }
     }
-    if (return_parse_end)
-    {
-        *return_parse_end = end;
-    }
-
-    return c;
-}
-
-/* Default options for cJSON_Parse */
-cJSON *cJSON_Parse(const char *value)
-{
-    return cJSON_ParseWithOpts(value, 0, 0);
-}
-
-/* Render a cJSON item/entity/structure to text. */
-char *cJSON_Print(const cJSON *item)
-{
-    return print_value(item, 0, 1, 0);
-}
 
-char *cJSON_PrintUnformatted(const cJSON *item)
-{
-    return print_value(item, 0, 0, 0);
+    return copy;
 }
 
-char *cJSON_PrintBuffered(const cJSON *item, int prebuffer, cjbool fmt)
+/* materialize a subtree and build its indices, so that reading it doesn't write to it any more */
+static cjbool prepare_frozen(const cJSON *item)
 {
-    printbuffer p;
-    p.buffer = (char*)cJSON_malloc(prebuffer);
-    if (!p.buffer)
+    for (; item; item = item->next)
     {
-        return NULL;
+        if (item->type & cJSON_IsShared)
+        {
+            /* frozen already */
+            continue;
+        }
+        if (!materialize(item) || (item->index && !index_ready(item)) || !prepare_frozen(item->child))
+        {
+            return false;
+        }
     }
-    p.length = prebuffer;
-    p.offset = 0;
-    p.noalloc = false;
 
-    return print_value(item, 0, fmt, &p);
+    return true;
 }
 
-int cJSON_PrintPreallocated(cJSON *item,char *buf, const int len, const cjbool fmt)
+static void freeze(cJSON *item)
 {
-    printbuffer p;
-    p.buffer = buf;
-    p.length = len;
-    p.offset = 0;
-    p.noalloc = true;
-    return print_value(item,0,fmt,&p) != NULL;
+    for (; item; item = item->next)
+    {
+        item->type |= cJSON_IsImmutable;
+        if (!(item->type & cJSON_IsShared))
+        {
+            freeze(item->child);
+        }
+    }
 }
 
-/* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value, const char **ep)
+cJSON *cJSON_Share(cJSON *item)
 {
-    if (!value)
+    cJSON_Shared *shared = NULL;
+    cJSON *handle = NULL;
+    if (!item || item->next || item->prev || (item->type & cJSON_IsImmutable))
     {
-        /* Fail on null. */
         return NULL;
     }
-
-    /* parse the different types of values */
-    if (!strncmp(value, "null", 4))
-    {
-        item->type = cJSON_NULL;
-        return value + 4;
-    }
-    if (!strncmp(value, "false", 5))
-    {
-        item->type = cJSON_False;
-        return value + 5;
-    }
-    if (!strncmp(value, "true", 4))
-    {
-        item->type = cJSON_True;
-        item->valueint = 1;
-        return value + 4;
-    }
-    if (*value == '\"')
-    {
-        return parse_string(item, value, ep);
-    }
-    if ((*value == '-') || ((*value >= '0') && (*value <= '9')))
-    {
-        return parse_number(item, value);
-    }
-    if (*value == '[')
+    if (item->type & cJSON_IsShared)
     {
-        return parse_array(item, value, ep);
+        return item;
     }
-    if (*value == '{')
+    if (!prepare_frozen(item))
     {
-        return parse_object(item, value, ep);
+        return NULL;
     }
 
-    /* failure. */
-    *ep = value;
-    return NULL;
-}
-
-/* Render a value to text. */
-static char *print_value(const cJSON *item, int depth, cjbool fmt, printbuffer *p)
-{
-    char *out = NULL;
-
-    if (!item)
+    shared = (cJSON_Shared*)global_hooks.allocate(global_hooks.context, sizeof(cJSON_Shared));
+    if (!shared)
     {
         return NULL;
     }
-    if (p)
-    {
-        switch ((item->type) & 0xFF)
-        {
-            case cJSON_NULL:
-                out = ensure(p, 5);
-                if (out)
-                {
-                    strcpy(out, "null");
-                }
-                break;
-            case cJSON_False:
-                out = ensure(p, 6);
-                if (out)
-                {
-                    strcpy(out, "false");
-                }
-                break;
-            case cJSON_True:
-                out = ensure(p, 5);
-                if (out)
-                {
-                    strcpy(out, "true");
-                }
-                break;
-            case cJSON_Number:
-                out = print_number(item, p);
-                break;
-            case cJSON_String:
-                out = print_string(item, p);
-                break;
-            case cJSON_Array:
-                out = print_array(item, depth, fmt, p);
-                break;
-            case cJSON_Object:
-                out = print_object(item, depth, fmt, p);
-                break;
-        }
-    }
-    else
+    shared->references = 0;
+    shared->root = item;
+    handle = create_shared_item(item, shared);
+    if (!handle)
     {
-        switch ((item->type) & 0xFF)
-        {
-            case cJSON_NULL:
-                out = cJSON_strdup("null");
-                break;
-            case cJSON_False:
-                out = cJSON_strdup("false");
-                break;
-            case cJSON_True:
-                out = cJSON_strdup("true");
-                break;
-            case cJSON_Number:
-                out = print_number(item, 0);
-                break;
-            case cJSON_String:
-                out = print_string(item, 0);
-                break;
-            case cJSON_Array:
-                out = print_array(item, depth, fmt, 0);
-                break;
-            case cJSON_Object:
-                out = print_object(item, depth, fmt, 0);
-                break;
-        }
+        global_hooks.deallocate(global_hooks.context, shared);
+        return NULL;
     }
+    freeze(item);
 
-    return out;
+    return handle;
 }
 
-/* Build an array from input text. */
-static const char *parse_array(cJSON *item,const char *value,const char **ep)
+/* Give a shared item its own copy of its level: the children become shared items of their own (with copies of their
+ * keys), a string gets its own valuestring. False if the item can't be modified. */
+static cjbool unshare(cJSON *item)
 {
     cJSON *child = NULL;
-    if (*value != '[')
-    {
-        /* not an array! */
-        *ep = value;
-        return NULL;
-    }
+    cJSON *copy = NULL;
+    cJSON *first = NULL;
+    cJSON *last = NULL;
+    char *valuestring = NULL;
 
-    item->type = cJSON_Array;
-    value = skip(value + 1);
-    if (*value == ']')
+    if (!item || (item->type & cJSON_IsImmutable))
     {
-        /* empty array. */
-        return value + 1;
+        return false;
     }
-
-    item->child = child = cJSON_New_Item();
-    if (!item->child)
+    if ((item->type & cJSON_IsReference) && item->child && (item->child->type & cJSON_IsImmutable))
     {
-        /* memory fail */
-        return NULL;
+        /* a reference to a frozen container */
+        return false;
     }
-    /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value), ep));
-    if (!value)
+    if (!(item->type & cJSON_IsShared))
     {
-        return NULL;
+        return true;
     }
 
-    /* loop through the comma separated array elements */
-    while (*value == ',')
+    for (child = item->child; child; child = child->next)
     {
-        cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
-        {
-            /* memory fail */
-            return NULL;
-        }
-        /* add new item to end of the linked list */
-        child->next = new_item;
-        new_item->prev = child;
-        child = new_item;
-
-        /* go to the next comma */
-        value = skip(parse_value(child, skip(value + 1), ep));
-        if (!value)
+        copy = duplicate_shared(child, ((shared_item*)item)->shared);
+        if (!copy)
         {
-            /* memory fail */
-            return NULL;
+            delete_item(first, &global_hooks);
+            return false;
         }
-    }
-
-    if (*value == ']')
-    {
-        /* end of array */
-        return value + 1;
-    }
-
-    /* malformed. */
-    *ep = value;
-
-    return NULL;
-}
-
-/* Render an array to text */
-static char *print_array(const cJSON *item, int depth, cjbool fmt, printbuffer *p)
-{
-    char **entries;
-    char *out = NULL;
-    char *ptr = NULL;
-    char *ret = NULL;
-    int len = 5;
-    cJSON *child = item->child;
-    int numentries = 0;
-    int i = 0;
-    cjbool fail = false;
-    size_t tmplen = 0;
-
-    /* How many entries in the array? */
-    while (child)
-    {
-        numentries++;
-        child = child->next;
-    }
-
-    /* Explicitly handle numentries == 0 */
-    if (!numentries)
-    {
-        if (p)
+        if (last)
         {
-            out = ensure(p, 3);
+            suffix_object(last, copy);
         }
         else
         {
-            out = (char*)cJSON_malloc(3);
+            first = copy;
         }
-        if (out)
-        {
-            strcpy(out,"[]");
-        }
-
-        return out;
+        last = copy;
     }
-
-    if (p)
+    if (item->valuestring && !(item->type & cJSON_ValueStringIsConst))
     {
-        /* Compose the output array. */
-        /* opening square bracket */
-        i = p->offset;
-        ptr = ensure(p, 1);
-        if (!ptr)
-        {
-            return NULL;
-        }
-        *ptr = '[';
-        p->offset++;
-
-        child = item->child;
-        while (child && !fail)
-        {
-            if (!print_value(child, depth + 1, fmt, p))
-            {
-                return NULL;
-            }
-            p->offset = update(p);
-            if (child->next)
-            {
-                len = fmt ? 2 : 1;
-                ptr = ensure(p, len + 1);
-                if (!ptr)
-                {
-                    return NULL;
-                }
-                *ptr++ = ',';
-                if(fmt)
-                {
-                    *ptr++ = ' ';
-                }
-                *ptr = '\0';
-                p->offset += len;
-            }
-            child = child->next;
-        }
-        ptr = ensure(p, 2);
-        if (!ptr)
+        valuestring = cJSON_strdup(item->valuestring, &global_hooks);
+        if (!valuestring)
         {
-            return NULL;
+            delete_item(first, &global_hooks);
+            return false;
         }
-        *ptr++ = ']';
-        *ptr = '\0';
-        out = (p->buffer) + i;
+        item->valuestring = valuestring;
     }
-    else
+    if (item->index)
     {
-        /* Allocate an array to hold the pointers to all printed values */
-        entries = (char**)cJSON_malloc(numentries * sizeof(char*));
-        if (!entries)
-        {
-            return NULL;
-        }
-        memset(entries, '\0', numentries * sizeof(char*));
-
-        /* Retrieve all the results: */
-        child = item->child;
-        while (child && !fail)
-        {
-            ret = print_value(child, depth + 1, fmt, 0);
-            entries[i++] = ret;
-            if (ret)
-            {
-                len += strlen(ret) + 2 + (fmt ? 1 : 0);
-            }
-            else
-            {
-                fail = true;
-            }
-            child = child->next;
-        }
-
-        /* If we didn't fail, try to malloc the output string */
-        if (!fail)
-        {
-            out = (char*)cJSON_malloc(len);
-        }
-        /* If that fails, we fail. */
-        if (!out)
-        {
-            fail = true;
-        }
-
-        /* Handle failure. */
-        if (fail)
-        {
-            /* free all the entries in the array */
-            for (i = 0; i < numentries; i++)
-            {
-                if (entries[i])
-                {
-                    cJSON_free(entries[i]);
-                }
-            }
-            cJSON_free(entries);
-            return NULL;
-        }
-
-        /* Compose the output array. */
-        *out='[';
-        ptr = out + 1;
-        *ptr = '\0';
-        for (i = 0; i < numentries; i++)
-        {
-            tmplen = strlen(entries[i]);
-            memcpy(ptr, entries[i], tmplen);
-            ptr += tmplen;
-            if (i != (numentries - 1))
-            {
-                *ptr++ = ',';
-                if(fmt)
-                {
-                    *ptr++ = ' ';
-                }
-                *ptr = '\0';
-            }
-            cJSON_free(entries[i]);
-        }
-        cJSON_free(entries);
-        *ptr++ = ']';
-        *ptr++ = '\0';
+        /* it indexes the shared children */
+        delete_index(item->index);
+        item->index = NULL;
     }
+    item->child = first;
+    item->type &= ~cJSON_IsShared;
+    shared_unref(((shared_item*)item)->shared);
 
-    return out;
+    return true;
 }
 
-/* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value, const char **ep)
+cJSON *cJSON_Unshare(cJSON *item)
 {
-    cJSON *child = NULL;
-    if (*value != '{')
-    {
-        /* not an object! */
-        *ep = value;
-        return NULL;
-    }
+    return unshare(item) ? item : NULL;
+}
 
-    item->type = cJSON_Object;
-    value = skip(value + 1);
-    if (*value == '}')
-    {
-        /* empty object. */
-        return value + 1;
-    }
+/* Duplication */
+static cJSON *duplicate_item(const cJSON *item, cjbool recurse, const internal_hooks * const hooks)
+{
+    cJSON *newitem = NULL;
+    cJSON *cptr = NULL;
+    cJSON *nptr = NULL;
+    cJSON *newchild = NULL;
 
-    child = cJSON_New_Item();
-    item->child = child;
-    if (!item->child)
+    /* Bail on bad ptr */
+    if (!item)
     {
         return NULL;
     }
-    /* parse first key */
-    value = skip(parse_string(child, skip(value), ep));
-    if (!value)
+    if (recurse && (item->type & cJSON_IsShared) && (hooks == &global_hooks))
     {
-        return NULL;
+        /* copy on write: share the content too */
+        return duplicate_shared(item, NULL);
     }
-    /* use string as key, not value */
-    child->string = child->valuestring;
-    child->valuestring = NULL;
-
-    if (*value != ':')
+    /* Create new item */
+    newitem = cJSON_New_Item(hooks);
+    if (!newitem)
     {
-        /* invalid object. */
-        *ep = value;
         return NULL;
     }
-    /* skip any spacing, get the value. */
-    value = skip(parse_value(child, skip(value + 1), ep));
-    if (!value)
+    /* Copy over all vars */
+    newitem->type = item->type & ~(cJSON_IsReference | cJSON_IsShared | cJSON_IsImmutable | cJSON_StringIsInBuffer);
+    if (item->type & cJSON_StringIsInBuffer)
     {
-        return NULL;
+        /* the input of an in situ parse doesn't live as long as the copy */
+        newitem->type &= ~(cJSON_StringIsConst | cJSON_ValueStringIsConst);
     }
-
-    while (*value == ',')
+    newitem->valueint = item->valueint;
+    newitem->valuedouble = item->valuedouble;
+    newitem->valueint64 = item->valueint64;
+    if (item->valuestring)
     {
-        cJSON *new_item = NULL;
-        if (!(new_item = cJSON_New_Item()))
+        newitem->valuestring = (newitem->type & cJSON_ValueStringIsConst) ? item->valuestring : cJSON_strdup(item->valuestring, hooks);
+        if (!newitem->valuestring)
         {
-            /* memory fail */
+            delete_item(newitem, hooks);
             return NULL;
         }
-        /* add to linked list */
-        child->next = new_item;
-        new_item->prev = child;
-
-        child = new_item;
-        value = skip(parse_string(child, skip(value + 1), ep));
-        if (!value)
+    }
+    if (item->string)
+    {
+        newitem->string = (newitem->type & cJSON_StringIsConst) ? item->string : cJSON_strdup(item->string, hooks);
+        if (!newitem->string)
         {
+            delete_item(newitem, hooks);
             return NULL;
         }
-
-        /* use string as key, not value */
-        child->string = child->valuestring;
-        child->valuestring = NULL;
-
-        if (*value != ':')
+    }
+    /* If non-recursive, then we're done! */
+    if (!recurse)
+    {
+        return newitem;
+    }
+    if (!materialize(item))
+    {
+        delete_item(newitem, hooks);
+        return NULL;
+    }
+    /* Walk the ->next chain for the child. */
+    cptr = item->child;
+    while (cptr)
+    {
+        newchild = duplicate_item(cptr, 1, hooks); /* Duplicate (with recurse) each item in the ->next chain */
+        if (!newchild)
         {
-            /* invalid object. */
-            *ep = value;
+            delete_item(newitem, hooks);
             return NULL;
         }
-        /* skip any spacing, get the value. */
-        value = skip(parse_value(child, skip(value + 1), ep));
-        if (!value)
+        if (nptr)
         {
-            return NULL;
+            /* If newitem->child already set, then crosswire ->prev and ->next and move on */
+            nptr->next = newchild;
+            newchild->prev = nptr;
+            nptr = newchild;
+        }
+        else
+        {
+            /* Set newitem->child and move to it */
+            newitem->child = newchild; nptr = newchild;
         }
+        cptr = cptr->next;
     }
-    /* end of object */
-    if (*value == '}')
+
+    return newitem;
+}
+
+cJSON *cJSON_Duplicate(const cJSON *item, cjbool recurse)
+{
+    return duplicate_item(item, recurse, &global_hooks);
+}
+
+cJSON *cJSON_DuplicateWithAllocator(const cJSON *item, cjbool recurse, const cJSON_Allocator *allocator)
+{
+    internal_hooks hooks;
+    if (!hooks_from_allocator(&hooks, allocator))
     {
-        return value + 1;
+        return NULL;
     }
 
-    /* malformed */
-    *ep = value;
-    return NULL;
+    return duplicate_item(item, recurse, &hooks);
 }
 
-/* Render an object to text. */
-static char *print_object(const cJSON *item, int depth, cjbool fmt, printbuffer *p)
+/* the whitespace cJSON_Minify removes */
+#define is_minify_space(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\r') || ((c) == '\n'))
+
+#ifdef SCAN_BLOCKS
+/* minify looks at this many bytes at once, made up of SCAN_BLOCK_SIZE blocks */
+#define MINIFY_BLOCK_SIZE 64
+
+#ifdef SCAN_SSE2
+/* bit i is set if the byte i of these is in a string, for the bits of the quotes in them (none of which is escaped) */
+static cjuint64 prefix_xor(cjuint64 bits)
 {
-    char **entries = NULL;
-    char **names = NULL;
-    char *out = NULL;
-    char *ptr = NULL;
-    char *ret = NULL;
-    char *str = NULL;
-    int len = 7;
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+#endif
+
+/* Minify the MINIFY_BLOCK_SIZE bytes at ptr (aligned, and in front of the end of the input if it has one) into *into,
+ * in_string tells if they start inside a string literal and is updated. Blocks that hold anything but whitespace,
+ * quotes and plain characters (escapes, comments, control characters, the terminating zero) are left to the bytewise
+ * loop, false is returned for them. The blocks are read one after the other, none after the one with the zero. */
+static SCAN_NO_SANITIZE cjbool minify_block(const char *ptr, char ** const into, cjbool * const in_string)
+{
+#if defined(SCAN_SSE2)
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i blocks[MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE];
+    cjuint64 quotes = 0;
+    cjuint64 slashes = 0;
+    cjuint64 spaces = 0;
+    cjuint64 keep = 0;
+    cjuint64 strings = 0;
+    char *out = *into;
+    int space = 0;
     int i = 0;
     int j = 0;
-    cJSON *child = item->child;
-    int numentries = 0;
-    cjbool fail = false;
-    size_t tmplen = 0;
 
-    /* Count the number of entries. */
-    while (child)
+    for (i = 0; i < (MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE); i++)
     {
-        numentries++;
-        child = child->next;
+        blocks[i] = _mm_load_si128((const __m128i*)(const void*)(ptr + (i * SCAN_BLOCK_SIZE)));
+        space = _mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(blocks[i], _mm_set1_epi8(' ')), _mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('\t'))),
+                    _mm_or_si128(_mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('\r')), _mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('\n')))));
+        /* unsigned block <= 0x1F is max(block, 0x1F) == 0x1F */
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(blocks[i], control), control)) & ~space)
+            || _mm_movemask_epi8(_mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('\\'))))
+        {
+            return false;
+        }
+        spaces |= ((cjuint64)(unsigned int)space) << (i * SCAN_BLOCK_SIZE);
+        quotes |= ((cjuint64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('\"')))) << (i * SCAN_BLOCK_SIZE);
+        slashes |= ((cjuint64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(blocks[i], _mm_set1_epi8('/')))) << (i * SCAN_BLOCK_SIZE);
+    }
+
+    /* without escapes every quote opens or closes a string */
+    strings = prefix_xor(quotes) ^ (*in_string ? ~(cjuint64)0 : 0);
+    if (slashes & ~strings)
+    {
+        /* a comment maybe */
+        return false;
     }
+    *in_string = (strings >> (MINIFY_BLOCK_SIZE - 1)) ? true : false;
 
-    /* Explicitly handle empty object case */
-    if (!numentries)
+    keep = ~(spaces & ~strings);
+    if (!~keep)
     {
-        if (p)
+        /* the output is never ahead of the input, and the input is already loaded */
+        for (i = 0; i < (MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE); i++)
         {
-            out = ensure(p, fmt ? depth + 4 : 3);
+            _mm_storeu_si128((__m128i*)(void*)(out + (i * SCAN_BLOCK_SIZE)), blocks[i]);
         }
-        else
+        *into = out + MINIFY_BLOCK_SIZE;
+        return true;
+    }
+    /* eight bytes at a time, most of them are all kept or all whitespace (indentation) */
+    for (i = 0; i < MINIFY_BLOCK_SIZE; i += 8)
+    {
+        space = (int)((keep >> i) & 0xFF);
+        if (space == 0xFF)
         {
-            out = (char*)cJSON_malloc(fmt ? depth + 4 : 3);
+            /* the two overlap when minifying in place */
+            memmove(out, ptr + i, 8);
+            out += 8;
         }
-        if (!out)
+        else if (space)
         {
-            return NULL;
-        }
-        ptr = out;
-        *ptr++ = '{';
-        if (fmt) {
-            *ptr++ = '\n';
-            for (i = 0; i < depth; i++)
+            /* compact without branching: every byte is written, only the ones to keep move the output on */
+            for (j = i; j < (i + 8); j++)
             {
-                *ptr++ = '\t';
+                *out = ptr[j];
+                out += (size_t)((keep >> j) & 1);
             }
         }
-        *ptr++ = '}';
-        *ptr++ = '\0';
-
-        return out;
     }
+    *into = out;
+
+    return true;
+#elif defined(SCAN_NEON)
+    uint8x16_t blocks[MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE];
+    uint8x16_t special;
+    uint32x2_t folded;
+    int i = 0;
 
-    if (p)
+    (void)in_string;
+    /* only blocks of plain characters are copied here (so in_string doesn't change), anything else goes bytewise */
+    for (i = 0; i < (MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE); i++)
     {
-        /* Compose the output: */
-        i = p->offset;
-        len = fmt ? 2 : 1; /* fmt: {\n */
-        ptr = ensure(p, len + 1);
-        if (!ptr)
+        blocks[i] = vld1q_u8((const uint8_t*)(const void*)(ptr + (i * SCAN_BLOCK_SIZE)));
+        special = vorrq_u8(vorrq_u8(vceqq_u8(blocks[i], vdupq_n_u8('\"')), vceqq_u8(blocks[i], vdupq_n_u8('/'))),
+                    vorrq_u8(vceqq_u8(blocks[i], vdupq_n_u8('\\')), vcltq_u8(blocks[i], vdupq_n_u8(0x21))));
+        folded = vreinterpret_u32_u8(vorr_u8(vget_low_u8(special), vget_high_u8(special)));
+        if (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1))
         {
-            return NULL;
+            return false;
         }
+    }
+    for (i = 0; i < (MINIFY_BLOCK_SIZE / SCAN_BLOCK_SIZE); i++)
+    {
+        vst1q_u8((uint8_t*)(void*)(*into + (i * SCAN_BLOCK_SIZE)), blocks[i]);
+    }
+    *into += MINIFY_BLOCK_SIZE;
+
+    return true;
+#endif
+}
+#endif
 
-        *ptr++ = '{';
-        if (fmt)
+/* Minify [json, end) (end is NULL for zero terminated input) into into, which may be json itself, since the output
+ * never gets ahead of the input. A zero byte ends the input as well. Returns the end of the output. */
+static char *minify(const char *json, const char * const end, char *into)
+{
+    cjbool in_string = false;
+    while (before_end(json, end) && *json)
+    {
+#ifdef SCAN_BLOCKS
+        /* whole blocks at a time from block boundaries on, bytewise up to the next boundary where that doesn't work */
+        if (scan_aligned(json) && (!end || ((size_t)(end - json) >= MINIFY_BLOCK_SIZE)) && minify_block(json, &into, &in_string))
         {
-            *ptr++ = '\n';
+            json += MINIFY_BLOCK_SIZE;
+            continue;
         }
-        *ptr = '\0';
-        p->offset += len;
-
-        child = item->child;
-        depth++;
-        while (child)
+#endif
+        if (in_string)
         {
-            if (fmt)
-            {
-                ptr = ensure(p, depth);
-                if (!ptr)
-                {
-                    return NULL;
-                }
-                for (j = 0; j < depth; j++)
-                {
-                    *ptr++ = '\t';
-                }
-                p->offset += depth;
-            }
-
-            /* print key */
-            if (!print_string_ptr(child->string, p))
-            {
-                return NULL;
-            }
-            p->offset = update(p);
-
-            len = fmt ? 2 : 1;
-            ptr = ensure(p, len);
-            if (!ptr)
-            {
-                return NULL;
-            }
-            *ptr++ = ':';
-            if (fmt)
-            {
-                *ptr++ = '\t';
-            }
-            p->offset+=len;
-
-            /* print value */
-            if (!print_value(child, depth, fmt, p))
-            {
-                return NULL;
-            };
-            p->offset = update(p);
-
-            /* print comma if not last */
-            len = (fmt ? 1 : 0) + (child->next ? 1 : 0);
-            ptr = ensure(p, len + 1);
-            if (!ptr)
-            {
-                return NULL;
-            }
-            if (child->next)
+            /* string literals, which are \" sensitive. */
+            if (*json == '\"')
             {
-                *ptr++ = ',';
+                in_string = false;
             }
-
-            if (fmt)
+            else if ((*json == '\\') && before_end(json + 1, end) && json[1])
             {
-                *ptr++ = '\n';
+                *into++ = *json++;
             }
-            *ptr = '\0';
-            p->offset += len;
-
-            child = child->next;
+            *into++ = *json++;
         }
-
-        ptr = ensure(p, fmt ? (depth + 1) : 2);
-        if (!ptr)
+        else if (is_minify_space(*json))
         {
-            return NULL;
+            /* Whitespace characters. */
+            json++;
         }
-        if (fmt)
+        else if ((*json == '/') && before_end(json + 1, end) && (json[1] == '/'))
         {
-            for (i = 0; i < (depth - 1); i++)
+            /* double-slash comments, to end of line. */
+            while (before_end(json, end) && *json && (*json != '\n'))
             {
-                *ptr++ = '\t';
+                json++;
             }
         }
-        *ptr++ = '}';
-        *ptr = '\0';
-        out = (p->buffer) + i;
-    }
-    else
-    {
-        /* Allocate space for the names and the objects */
-        entries = (char**)cJSON_malloc(numentries * sizeof(char*));
-        if (!entries)
-        {
-            return NULL;
-        }
-        names = (char**)cJSON_malloc(numentries * sizeof(char*));
-        if (!names)
-        {
-            cJSON_free(entries);
-            return NULL;
-        }
-        memset(entries, '\0', sizeof(char*) * numentries);
-        memset(names, '\0', sizeof(char*) * numentries);
-
-        /* Collect all the results into our arrays: */
-        child = item->child;
-        depth++;
-        if (fmt)
-        {
-            len += depth;
-        }
-        while (child && !fail)
+        else if ((*json == '/') && before_end(json + 1, end) && (json[1] == '*'))
         {
-            names[i] = str = print_string_ptr(child->string, 0); /* print key */
-            entries[i++] = ret = print_value(child, depth, fmt, 0);
-            if (str && ret)
+            /* multiline comments. */
+            json++;
+            while (before_end(json, end) && *json && !((*json == '*') && before_end(json + 1, end) && (json[1] == '/')))
             {
-                len += strlen(ret) + strlen(str) + 2 + (fmt ? 2 + depth : 0);
+                json++;
             }
-            else
+            if (before_end(json, end) && *json)
             {
-                fail = true;
+                json += 2;
             }
-            child = child->next;
-        }
-
-        /* Try to allocate the output string */
-        if (!fail)
-        {
-            out = (char*)cJSON_malloc(len);
         }
-        if (!out)
+        else
         {
-            fail = true;
+            /* All other characters. */
+            in_string = (*json == '\"');
+            *into++ = *json++;
         }
+    }
 
-        /* Handle failure */
-        if (fail)
-        {
-            /* free all the printed keys and values */
-            for (i = 0; i < numentries; i++)
-            {
-                if (names[i])
-                {
-                    cJSON_free(names[i]);
-                }
-                if (entries[i])
-                {
-                    cJSON_free(entries[i]);
-                }
-            }
-            cJSON_free(names);
-            cJSON_free(entries);
-            return NULL;
-        }
+    return into;
+}
 
-        /* Compose the output: */
-        *out = '{';
-        ptr = out + 1;
-        if (fmt)
-        {
-            *ptr++ = '\n';
-        }
-        *ptr = '\0';
-        for (i = 0; i < numentries; i++)
-        {
-            if (fmt)
-            {
-                for (j = 0; j < depth; j++)
-                {
-                    *ptr++='\t';
-                }
-            }
-            tmplen = strlen(names[i]);
-            memcpy(ptr, names[i], tmplen);
-            ptr += tmplen;
-            *ptr++ = ':';
-            if (fmt)
-            {
-                *ptr++ = '\t';
-            }
-            strcpy(ptr, entries[i]);
-            ptr += strlen(entries[i]);
-            if (i != (numentries - 1))
-            {
-                *ptr++ = ',';
-            }
-            if (fmt)
-            {
-                *ptr++ = '\n';
-            }
-            *ptr = '\0';
-            cJSON_free(names[i]);
-            cJSON_free(entries[i]);
-        }
+void cJSON_Minify(char *json)
+{
+    if (!json)
+    {
+        return;
+    }
+    /* and null-terminate. */
+    *minify(json, NULL, json) = '\0';
+}
+
+size_t cJSON_MinifyInto(const char *json, size_t length, char *out)
+{
+    char *end = NULL;
+    if (!json || !out)
+    {
+        return 0;
+    }
+    end = minify(json, json + length, out);
+    *end = '\0';
+
+    return (size_t)(end - out);
+}
+
+/* One value of a tape. Nodes are stored in document order, so the children of a container directly follow it. */
+typedef struct
+{
+    unsigned int type;
+    /* offset + 1 of the (interned) key in the string pool, 0 if the value isn't an object member */
+    unsigned int key;
+    /* node number of the next sibling, 0 for the last one (the root is nobody's sibling) */
+    unsigned int next;
+    /* number of children of a container, length of a string */
+    unsigned int size;
+    union
+    {
+        double number;
+        /* offset of a string in the pool */
+        size_t string;
+    } value;
+} tape_node;
+
+/* a container the tape builder hasn't seen the end of yet */
+typedef struct
+{
+    size_t node;
+    /* its last child so far, 0 if there is none */
+    size_t last;
+} tape_frame;
+
+struct cJSON_Tape
+{
+    tape_node *nodes;
+    size_t count;
+    size_t nodes_size;
+    /* all strings and keys, zero terminated and back to back */
+    char *strings;
+    size_t strings_length;
+    size_t strings_size;
+    /* open addressing hash table of the keys (pool offset + 1, 0 for free slots), so every key is stored only once */
+    unsigned int *keys;
+    size_t keys_size; /* 0 or a power of 2 */
+    size_t keys_count;
+    /* only used while building: the open containers and the key of the next value */
+    tape_frame *open;
+    size_t open_count;
+    size_t open_size;
+    unsigned int key;
+    internal_hooks hooks;
+};
+
+/* Make room for needed elements in memory (used of them in use), doubling its size. Returns the new memory, or NULL
+ * (memory is left as it was) if there is none. */
+static void *tape_grow(const internal_hooks * const hooks, void *memory, size_t * const size, const size_t used, const size_t needed, const size_t element)
+{
+    void *grown = NULL;
+    size_t new_size = (*size > 0) ? *size : 16;
+    if (memory && (needed <= *size))
+    {
+        return memory;
+    }
+    while (new_size < needed)
+    {
+        new_size *= 2;
+    }
+    if (new_size > (((size_t)-1) / element))
+    {
+        return NULL;
+    }
 
-        cJSON_free(names);
-        cJSON_free(entries);
-        if (fmt)
+    if (hooks->reallocate)
+    {
+        grown = hooks->reallocate(hooks->context, memory, new_size * element);
+    }
+    else if ((grown = hooks->allocate(hooks->context, new_size * element)) && memory)
+    {
+        memcpy(grown, memory, used * element);
+        hooks->deallocate(hooks->context, memory);
+    }
+    if (grown)
+    {
+        *size = new_size;
+    }
+
+    return grown;
+}
+
+/* append a node and link it into the innermost open container */
+static tape_node *tape_add(cJSON_Tape * const tape, const int type)
+{
+    tape_frame *parent = NULL;
+    tape_node *node = NULL;
+    void *nodes = NULL;
+
+    if ((tape->count >= UINT_MAX) || !(nodes = tape_grow(&tape->hooks, tape->nodes, &tape->nodes_size, tape->count, tape->count + 1, sizeof(tape_node))))
+    {
+        return NULL;
+    }
+    tape->nodes = (tape_node*)nodes;
+    node = tape->nodes + tape->count;
+    memset(node, '\0', sizeof(tape_node));
+    node->type = (unsigned int)type;
+    node->key = tape->key;
+    tape->key = 0;
+
+    if (tape->open_count > 0)
+    {
+        parent = tape->open + (tape->open_count - 1);
+        if (parent->last)
         {
-            for (i = 0; i < (depth - 1); i++)
-            {
-                *ptr++ = '\t';
-            }
+            tape->nodes[parent->last].next = (unsigned int)tape->count;
         }
-        *ptr++ = '}';
-        *ptr++ = '\0';
+        parent->last = tape->count;
+        tape->nodes[parent->node].size++;
     }
+    tape->count++;
 
-    return out;
+    return node;
 }
 
-/* Get Array size/item / object item. */
-int    cJSON_GetArraySize(const cJSON *array)
+/* Decode a string into the free space at the end of the pool, without taking it yet. Returns its length. */
+static cjbool tape_store(cJSON_Tape * const tape, const char * const string, const size_t length, const int escaped, size_t * const stored)
 {
-    cJSON *c = array->child;
-    int i = 0;
-    while(c)
+    char *out = NULL;
+    /* unescaping never makes a string longer */
+    void *strings = tape_grow(&tape->hooks, tape->strings, &tape->strings_size, tape->strings_length, tape->strings_length + length + 1, 1);
+    if (!strings || ((tape->strings_length + length + 1) > UINT_MAX))
     {
-        i++;
-        c = c->next;
+        return false;
     }
-    return i;
-}
+    tape->strings = (char*)strings;
 
-cJSON *cJSON_GetArrayItem(const cJSON *array, int item)
-{
-    cJSON *c = array ? array->child : NULL;
-    while (c && item > 0)
+    out = tape->strings + tape->strings_length;
+    if (escaped)
     {
-        item--;
-        c = c->next;
+        *stored = cJSON_UnescapeString(string, length, out);
+    }
+    else
+    {
+        memcpy(out, string, length);
+        out[length] = '\0';
+        *stored = length;
     }
 
-    return c;
+    return true;
 }
 
-cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+static cjbool tape_rehash(cJSON_Tape * const tape, const size_t size)
 {
-    cJSON *c = object ? object->child : NULL;
-    while (c && cJSON_strcasecmp(c->string, string))
+    unsigned int *keys = (unsigned int*)tape->hooks.allocate(tape->hooks.context, size * sizeof(unsigned int));
+    size_t slot = 0;
+    size_t i = 0;
+    if (!keys)
     {
-        c = c->next;
+        return false;
     }
-    return c;
+    memset(keys, '\0', size * sizeof(unsigned int));
+
+    for (i = 0; i < tape->keys_size; i++)
+    {
+        if (tape->keys[i])
+        {
+            slot = (size_t)index_hash(tape->strings + (tape->keys[i] - 1)) & (size - 1);
+            while (keys[slot])
+            {
+                slot = (slot + 1) & (size - 1);
+            }
+            keys[slot] = tape->keys[i];
+        }
+    }
+    if (tape->keys)
+    {
+        tape->hooks.deallocate(tape->hooks.context, tape->keys);
+    }
+    tape->keys = keys;
+    tape->keys_size = size;
+
+    return true;
 }
 
-cjbool cJSON_HasObjectItem(const cJSON *object,const char *string)
+static int tape_null(void *context)
 {
-    return cJSON_GetObjectItem(object, string) ? 1 : 0;
+    return tape_add((cJSON_Tape*)context, cJSON_NULL) != NULL;
 }
 
-/* Utility for array list handling. */
-static void suffix_object(cJSON *prev, cJSON *item)
+static int tape_boolean(void *context, int value)
 {
-    prev->next = item;
-    item->prev = prev;
+    return tape_add((cJSON_Tape*)context, value ? cJSON_True : cJSON_False) != NULL;
 }
 
-/* Utility for handling references. */
-static cJSON *create_reference(const cJSON *item)
+static int tape_number(void *context, double value, const char *text, size_t length)
 {
-    cJSON *ref = cJSON_New_Item();
-    if (!ref)
+    tape_node * const node = tape_add((cJSON_Tape*)context, cJSON_Number);
+    (void)text;
+    (void)length;
+    if (!node)
     {
-        return NULL;
+        return false;
     }
-    memcpy(ref, item, sizeof(cJSON));
-    ref->string = NULL;
-    ref->type |= cJSON_IsReference;
-    ref->next = ref->prev = NULL;
-    return ref;
+    node->value.number = value;
+
+    return true;
 }
 
-/* Add item to array/object. */
-void   cJSON_AddItemToArray(cJSON *array, cJSON *item)
+static int tape_string(void *context, const char *string, size_t length, int escaped)
 {
-    cJSON *c = array->child;
-    if (!item)
+    cJSON_Tape * const tape = (cJSON_Tape*)context;
+    tape_node *node = NULL;
+    size_t stored = 0;
+    if (!tape_store(tape, string, length, escaped, &stored) || !(node = tape_add(tape, cJSON_String)))
     {
-        return;
+        return false;
     }
-    if (!c)
+    node->value.string = tape->strings_length;
+    node->size = (unsigned int)stored;
+    tape->strings_length += stored + 1;
+
+    return true;
+}
+
+static int tape_key(void *context, const char *string, size_t length, int escaped)
+{
+    cJSON_Tape * const tape = (cJSON_Tape*)context;
+    const char *key = NULL;
+    size_t stored = 0;
+    size_t slot = 0;
+
+    if (!tape_store(tape, string, length, escaped, &stored))
     {
-        /* list is empty, start new one */
-        array->child = item;
+        return false;
     }
-    else
+    /* keep the table at most half full */
+    if (((tape->keys_count + 1) * 2 > tape->keys_size) && !tape_rehash(tape, (tape->keys_size > 0) ? (tape->keys_size * 2) : 64))
     {
-        /* append to the end */
-        while (c->next)
-        {
-            c = c->next;
-        }
-        suffix_object(c, item);
+        return false;
     }
-}
 
-void   cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
-{
-    if (!item)
+    /* keys are C strings in the tree, they are here too */
+    key = tape->strings + tape->strings_length;
+    slot = (size_t)index_hash(key) & (tape->keys_size - 1);
+    while (tape->keys[slot] && strcmp(tape->strings + (tape->keys[slot] - 1), key))
     {
-        return;
+        slot = (slot + 1) & (tape->keys_size - 1);
     }
-
-    /* free old key and set new one */
-    if (item->string)
+    if (!tape->keys[slot])
     {
-        cJSON_free(item->string);
+        /* a new key, take it into the pool */
+        tape->keys[slot] = (unsigned int)(tape->strings_length + 1);
+        tape->keys_count++;
+        tape->strings_length += stored + 1;
     }
-    item->string = cJSON_strdup(string);
+    tape->key = tape->keys[slot];
 
-    cJSON_AddItemToArray(object,item);
+    return true;
 }
 
-/* Add an item to an object with constant string as key */
-void   cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
+static int tape_start(cJSON_Tape * const tape, const int type)
 {
-    if (!item)
-    {
-        return;
-    }
-    if (!(item->type & cJSON_StringIsConst) && item->string)
+    void *open = NULL;
+    if (!tape_add(tape, type) || !(open = tape_grow(&tape->hooks, tape->open, &tape->open_size, tape->open_count, tape->open_count + 1, sizeof(tape_frame))))
     {
-        cJSON_free(item->string);
+        return false;
     }
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-    item->string = (char*)string;
-#pragma GCC diagnostic pop
-    item->type |= cJSON_StringIsConst;
-    cJSON_AddItemToArray(object, item);
+    tape->open = (tape_frame*)open;
+    tape->open[tape->open_count].node = tape->count - 1;
+    tape->open[tape->open_count].last = 0;
+    tape->open_count++;
+
+    return true;
 }
 
-void cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
+static int tape_start_array(void *context)
 {
-    cJSON_AddItemToArray(array, create_reference(item));
+    return tape_start((cJSON_Tape*)context, cJSON_Array);
 }
 
-void cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item)
+static int tape_start_object(void *context)
 {
-    cJSON_AddItemToObject(object, string, create_reference(item));
+    return tape_start((cJSON_Tape*)context, cJSON_Object);
 }
 
-cJSON *cJSON_DetachItemFromArray(cJSON *array, int which)
+static int tape_end(void *context)
 {
-    cJSON *c = array->child;
-    while (c && (which > 0))
+    ((cJSON_Tape*)context)->open_count--;
+    return true;
+}
+
+cJSON_Tape *cJSON_ParseTape(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    cJSON_SAXHandler handler;
+    internal_hooks hooks;
+    cJSON_Tape *tape = NULL;
+    int error_code = cJSON_Error_InvalidArgument;
+
+    if (hooks_from_allocator(&hooks, options ? options->allocator : NULL))
     {
-        c = c->next;
-        which--;
+        error_code = cJSON_Error_Memory;
+        tape = (cJSON_Tape*)hooks.allocate(hooks.context, sizeof(cJSON_Tape));
     }
-    if (!c)
+    if (!tape)
     {
-        /* item doesn't exist */
+        if (error)
+        {
+            memset(error, '\0', sizeof(cJSON_ParseError));
+            error->code = error_code;
+        }
         return NULL;
     }
-    if (c->prev)
+    memset(tape, '\0', sizeof(cJSON_Tape));
+    tape->hooks = hooks;
+
+    memset(&handler, '\0', sizeof(handler));
+    handler.null = tape_null;
+    handler.boolean = tape_boolean;
+    handler.number = tape_number;
+    handler.string = tape_string;
+    handler.key = tape_key;
+    handler.start_object = tape_start_object;
+    handler.end_object = tape_end;
+    handler.start_array = tape_start_array;
+    handler.end_array = tape_end;
+    if (!cJSON_ParseSAX(value, length, &handler, tape, options, error))
+    {
+        /* the callbacks only stop for lack of memory */
+        if (error && (error->code == cJSON_Error_Aborted))
+        {
+            error->code = cJSON_Error_Memory;
+        }
+        cJSON_DeleteTape(tape);
+        return NULL;
+    }
+    if (tape->open)
     {
-        /* not the first element */
-        c->prev->next = c->next;
+        hooks.deallocate(hooks.context, tape->open);
+        tape->open = NULL;
     }
-    if (c->next)
+
+    return tape;
+}
+
+void cJSON_DeleteTape(cJSON_Tape *tape)
+{
+    internal_hooks hooks;
+    if (!tape)
     {
-        c->next->prev = c->prev;
+        return;
     }
-    if (c==array->child)
+    hooks = tape->hooks;
+    if (tape->nodes)
     {
-        array->child = c->next;
+        hooks.deallocate(hooks.context, tape->nodes);
     }
-    /* make sure the detached item doesn't point anywhere anymore */
-    c->prev = c->next = NULL;
+    if (tape->strings)
+    {
+        hooks.deallocate(hooks.context, tape->strings);
+    }
+    if (tape->keys)
+    {
+        hooks.deallocate(hooks.context, tape->keys);
+    }
+    if (tape->open)
+    {
+        hooks.deallocate(hooks.context, tape->open);
+    }
+    hooks.deallocate(hooks.context, tape);
+}
 
-    return c;
+size_t cJSON_TapeNodeCount(const cJSON_Tape *tape)
+{
+    return tape ? tape->count : 0;
 }
 
-void cJSON_DeleteItemFromArray(cJSON *array, int which)
+int cJSON_TapeType(const cJSON_Tape *tape, size_t node)
 {
-    cJSON_Delete(cJSON_DetachItemFromArray(array, which));
+    return (tape && (node < tape->count)) ? (int)tape->nodes[node].type : 0;
 }
 
-cJSON *cJSON_DetachItemFromObject(cJSON *object, const char *string)
+size_t cJSON_TapeChild(const cJSON_Tape *tape, size_t node)
 {
-    int i = 0;
-    cJSON *c = object->child;
-    while (c && cJSON_strcasecmp(c->string,string))
-    {
-        i++;
-        c = c->next;
-    }
-    if (c)
+    if (!tape || (node >= tape->count) || !(tape->nodes[node].type & (cJSON_Array | cJSON_Object)) || !tape->nodes[node].size)
     {
-        return cJSON_DetachItemFromArray(object, i);
+        return 0;
     }
 
-    return NULL;
+    return node + 1;
 }
 
-void cJSON_DeleteItemFromObject(cJSON *object, const char *string)
+size_t cJSON_TapeNext(const cJSON_Tape *tape, size_t node)
 {
-    cJSON_Delete(cJSON_DetachItemFromObject(object, string));
+    return (tape && (node < tape->count)) ? tape->nodes[node].next : 0;
 }
 
-/* Replace array/object items with new ones. */
-void cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem)
+int cJSON_TapeGetArraySize(const cJSON_Tape *tape, size_t node)
 {
-    cJSON *c = array->child;
-    while (c && (which > 0))
-    {
-        c = c->next;
-        which--;
-    }
-    if (!c)
-    {
-        cJSON_AddItemToArray(array, newitem);
-        return;
-    }
-    newitem->next = c;
-    newitem->prev = c->prev;
-    c->prev = newitem;
-    if (c == array->child)
-    {
-        array->child = newitem;
-    }
-    else
+    if (!tape || (node >= tape->count) || !(tape->nodes[node].type & (cJSON_Array | cJSON_Object)))
     {
-        newitem->prev->next = newitem;
+        return 0;
     }
+
+    return (int)tape->nodes[node].size;
 }
 
-void cJSON_ReplaceItemInArray(cJSON *array, int which, cJSON *newitem)
+size_t cJSON_TapeGetArrayItem(const cJSON_Tape *tape, size_t node, int which)
 {
-    cJSON *c = array->child;
-    while (c && (which > 0))
-    {
-        c = c->next;
-        which--;
-    }
-    if (!c)
-    {
-        return;
-    }
-    newitem->next = c->next;
-    newitem->prev = c->prev;
-    if (newitem->next)
-    {
-        newitem->next->prev = newitem;
-    }
-    if (c == array->child)
+    size_t child = 0;
+    if ((which < 0) || (which >= cJSON_TapeGetArraySize(tape, node)))
     {
-        array->child = newitem;
+        return 0;
     }
-    else
+    for (child = node + 1; which > 0; which--)
     {
-        newitem->prev->next = newitem;
+        child = tape->nodes[child].next;
     }
-    c->next = c->prev = NULL;
-    cJSON_Delete(c);
+
+    return child;
 }
 
-void cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newitem)
+size_t cJSON_TapeGetObjectItem(const cJSON_Tape *tape, size_t node, const char *string)
 {
-    int i = 0;
-    cJSON *c = object->child;
-    while(c && cJSON_strcasecmp(c->string, string))
+    size_t child = 0;
+    if (!string || (cJSON_TapeType(tape, node) != cJSON_Object))
     {
-        i++;
-        c = c->next;
+        return 0;
     }
-    if(c)
+    for (child = cJSON_TapeChild(tape, node); child; child = tape->nodes[child].next)
     {
-        /* free the old string if not const */
-        if (!(newitem->type & cJSON_StringIsConst) && newitem->string)
+        if (!cJSON_strcasecmp(tape->strings + (tape->nodes[child].key - 1), string))
         {
-             cJSON_free(newitem->string);
+            return child;
         }
-
-        newitem->string = cJSON_strdup(string);
-        cJSON_ReplaceItemInArray(object, i, newitem);
     }
+
+    return 0;
 }
 
-/* Create basic types: */
-cJSON *cJSON_CreateNull(void)
+double cJSON_TapeNumber(const cJSON_Tape *tape, size_t node)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
-    {
-        item->type = cJSON_NULL;
-    }
-
-    return item;
+    return (cJSON_TapeType(tape, node) == cJSON_Number) ? tape->nodes[node].value.number : 0;
 }
 
-cJSON *cJSON_CreateTrue(void)
+const char *cJSON_TapeString(const cJSON_Tape *tape, size_t node, size_t *length)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    if (cJSON_TapeType(tape, node) != cJSON_String)
     {
-        item->type = cJSON_True;
+        return NULL;
+    }
+    if (length)
+    {
+        *length = tape->nodes[node].size;
     }
 
-    return item;
+    return tape->strings + tape->nodes[node].value.string;
 }
 
-cJSON *cJSON_CreateFalse(void)
+const char *cJSON_TapeKey(const cJSON_Tape *tape, size_t node)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    if (!tape || (node >= tape->count) || !tape->nodes[node].key)
     {
-        item->type = cJSON_False;
+        return NULL;
     }
 
-    return item;
+    return tape->strings + (tape->nodes[node].key - 1);
 }
 
-cJSON *cJSON_CreateBool(cjbool b)
+/* Binary encoding: a 4 byte header, then the root value. Every value starts with a tag byte. Integers are little
+ * endian and take the fewest of 1, 2, 4 or 8 bytes, doubles are their 8 IEEE 754 bytes. Strings and keys are a 32 bit
+ * length, the bytes and a zero (so a decoder can point into the input), arrays and objects a 32 bit count followed
+ * by the children, key before value for objects. */
+#define BINARY_NULL 0x00
+#define BINARY_FALSE 0x01
+#define BINARY_TRUE 0x02
+#define BINARY_INT8 0x03
+#define BINARY_INT16 0x04
+#define BINARY_INT32 0x05
+#define BINARY_INT64 0x06
+#define BINARY_DOUBLE 0x07
+#define BINARY_STRING 0x08
+#define BINARY_ARRAY 0x09
+#define BINARY_OBJECT 0x0A
+
+static const unsigned char binary_header[4] = {'c', 'J', 'B', 1};
+
+/* bytes of the smallest integer tag that holds number */
+static size_t binary_int_size(const cJSON_int64 number)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    if ((number >= -128) && (number <= 127))
     {
-        item->type = b ? cJSON_True : cJSON_False;
+        return 1;
+    }
+    if ((number >= -32768) && (number <= 32767))
+    {
+        return 2;
+    }
+    if ((number >= (-2147483647L - 1)) && (number <= 2147483647L))
+    {
+        return 4;
     }
 
-    return item;
+    return 8;
 }
 
-cJSON *cJSON_CreateNumber(double num)
+/* add the encoded size of a string (or key) to size, false if its length doesn't fit in 32 bits */
+static cjbool binary_string_size(const char *string, size_t *size)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    size_t length = string ? strlen(string) : 0;
+    if (length > 0xFFFFFFFFUL)
     {
-        item->type = cJSON_Number;
-        item->valuedouble = num;
-        item->valueint = (int)num;
+        return false;
     }
+    *size += 4 + length + 1;
 
-    return item;
+    return true;
 }
 
-cJSON *cJSON_CreateString(const char *string)
+static cjbool binary_size(const cJSON *item, size_t *size)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    const cJSON *child = NULL;
+    size_t count = 0;
+
+    *size += 1;
+    switch (item->type & 0xFF)
     {
-        item->type = cJSON_String;
-        item->valuestring = cJSON_strdup(string);
-        if(!item->valuestring)
-        {
-            cJSON_Delete(item);
-            return NULL;
-        }
-    }
+        case cJSON_NULL:
+        case cJSON_False:
+        case cJSON_True:
+            return true;
 
-    return item;
+        case cJSON_Number:
+            *size += number_is_int64(item) ? binary_int_size(item->valueint64) : 8;
+            return true;
+
+        case cJSON_String:
+            return binary_string_size(item->valuestring, size);
+
+        case cJSON_Array:
+        case cJSON_Object:
+            if (!materialize(item))
+            {
+                return false;
+            }
+            *size += 4;
+            for (child = item->child; child; child = child->next, count++)
+            {
+                if ((((item->type & 0xFF) == cJSON_Object) && !binary_string_size(child->string, size)) || !binary_size(child, size))
+                {
+                    return false;
+                }
+            }
+            return count <= 0xFFFFFFFFUL;
+
+        default:
+            return false;
+    }
 }
 
-cJSON *cJSON_CreateArray(void)
+static unsigned char *binary_put_uint(unsigned char *out, cjuint64 value, size_t bytes)
 {
-    cJSON *item = cJSON_New_Item();
-    if(item)
+    for (; bytes > 0; bytes--)
     {
-        item->type=cJSON_Array;
+        *out++ = (unsigned char)(value & 0xFF);
+        value >>= 8;
     }
 
-    return item;
+    return out;
 }
 
-cJSON *cJSON_CreateObject(void)
+static unsigned char *binary_put_string(unsigned char *out, const char *string)
 {
-    cJSON *item = cJSON_New_Item();
-    if (item)
+    size_t length = string ? strlen(string) : 0;
+    out = binary_put_uint(out, (cjuint64)length, 4);
+    if (length > 0)
     {
-        item->type = cJSON_Object;
+        memcpy(out, string, length);
     }
+    out[length] = '\0';
 
-    return item;
+    return out + length + 1;
 }
 
-/* Create Arrays: */
-cJSON *cJSON_CreateIntArray(const int *numbers, int count)
+/* write item to out, which has room for it (see binary_size) */
+static unsigned char *binary_write(const cJSON *item, unsigned char *out)
 {
-    int i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = cJSON_CreateArray();
-    for(i = 0; a && (i < count); i++)
+    const cJSON *child = NULL;
+    unsigned char *count = NULL;
+    cjuint64 children = 0;
+    cjuint64 bits = 0;
+    size_t bytes = 0;
+
+    switch (item->type & 0xFF)
     {
-        n = cJSON_CreateNumber(numbers[i]);
-        if (!n)
-        {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
-        {
-            suffix_object(p, n);
-        }
-        p = n;
-    }
+        case cJSON_NULL:
+            *out++ = BINARY_NULL;
+            return out;
 
-    return a;
+        case cJSON_False:
+            *out++ = BINARY_FALSE;
+            return out;
+
+        case cJSON_True:
+            *out++ = BINARY_TRUE;
+            return out;
+
+        case cJSON_Number:
+            if (number_is_int64(item))
+            {
+                bytes = binary_int_size(item->valueint64);
+                *out++ = (bytes == 1) ? BINARY_INT8 : ((bytes == 2) ? BINARY_INT16 : ((bytes == 4) ? BINARY_INT32 : BINARY_INT64));
+                /* two's complement */
+                return binary_put_uint(out, (cjuint64)item->valueint64, bytes);
+            }
+            *out++ = BINARY_DOUBLE;
+            memcpy(&bits, &item->valuedouble, sizeof(bits));
+            return binary_put_uint(out, bits, 8);
+
+        case cJSON_String:
+            *out++ = BINARY_STRING;
+            return binary_put_string(out, item->valuestring);
+
+        default:
+            /* array or object, the count is filled in after the children */
+            *out++ = ((item->type & 0xFF) == cJSON_Array) ? BINARY_ARRAY : BINARY_OBJECT;
+            count = out;
+            out += 4;
+            for (child = item->child; child; child = child->next, children++)
+            {
+                if ((item->type & 0xFF) == cJSON_Object)
+                {
+                    out = binary_put_string(out, child->string);
+                }
+                out = binary_write(child, out);
+            }
+            binary_put_uint(count, children, 4);
+            return out;
+    }
 }
 
-cJSON *cJSON_CreateFloatArray(const float *numbers, int count)
+size_t cJSON_BinarySize(const cJSON *item)
 {
-    int i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = cJSON_CreateArray();
-    for(i = 0; a && (i < count); i++)
+    size_t size = sizeof(binary_header);
+    if (!item || !binary_size(item, &size))
     {
-        n = cJSON_CreateNumber(numbers[i]);
-        if(!n)
-        {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
-        {
-            suffix_object(p, n);
-        }
-        p = n;
+        return 0;
     }
 
-    return a;
+    return size;
 }
 
-cJSON *cJSON_CreateDoubleArray(const double *numbers, int count)
+size_t cJSON_PrintBinaryPreallocated(const cJSON *item, unsigned char *buffer, size_t size)
 {
-    int i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = cJSON_CreateArray();
-    for(i = 0;a && (i < count); i++)
+    size_t needed = cJSON_BinarySize(item);
+    if (!buffer || (needed == 0) || (needed > size))
     {
-        n = cJSON_CreateNumber(numbers[i]);
-        if(!n)
-        {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
-        {
-            suffix_object(p, n);
-        }
-        p = n;
+        return 0;
     }
+    memcpy(buffer, binary_header, sizeof(binary_header));
+    binary_write(item, buffer + sizeof(binary_header));
 
-    return a;
+    return needed;
 }
 
-cJSON *cJSON_CreateStringArray(const char **strings, int count)
+unsigned char *cJSON_PrintBinary(const cJSON *item, size_t *length)
 {
-    int i = 0;
-    cJSON *n = NULL;
-    cJSON *p = NULL;
-    cJSON *a = cJSON_CreateArray();
-    for (i = 0; a && (i < count); i++)
+    size_t size = cJSON_BinarySize(item);
+    unsigned char *buffer = NULL;
+    if (size == 0)
     {
-        n = cJSON_CreateString(strings[i]);
-        if(!n)
-        {
-            cJSON_Delete(a);
-            return NULL;
-        }
-        if(!i)
-        {
-            a->child = n;
-        }
-        else
-        {
-            suffix_object(p,n);
-        }
-        p = n;
+        return NULL;
     }
 
-    return a;
+    buffer = (unsigned char*)global_hooks.allocate(global_hooks.context, size);
+    if (!buffer)
+    {
+        return NULL;
+    }
+    memcpy(buffer, binary_header, sizeof(binary_header));
+    binary_write(item, buffer + sizeof(binary_header));
+    if (length)
+    {
+        *length = size;
+    }
+
+    return buffer;
 }
 
-/* Duplication */
-cJSON *cJSON_Duplicate(const cJSON *item, cjbool recurse)
+typedef struct
 {
-    cJSON *newitem = NULL;
-    cJSON *cptr = NULL;
-    cJSON *nptr = NULL;
-    cJSON *newchild = NULL;
+    const unsigned char *end;
+    const internal_hooks *hooks;
+    size_t index_threshold;
+    /* strings point into the input instead of being copied */
+    cjbool in_place;
+    const unsigned char *error;
+    int error_code;
+} binary_buffer;
+
+static const unsigned char *binary_error(binary_buffer * const buffer, const unsigned char *position, int code)
+{
+    buffer->error = position;
+    buffer->error_code = code;
 
-    /* Bail on bad ptr */
-    if (!item)
+    return NULL;
+}
+
+static const unsigned char *binary_get_uint(const unsigned char *in, binary_buffer * const buffer, size_t bytes, cjuint64 *value)
+{
+    size_t i = 0;
+    if ((size_t)(buffer->end - in) < bytes)
     {
-        return NULL;
+        return binary_error(buffer, in, cJSON_Error_InvalidBinary);
     }
-    /* Create new item */
-    newitem = cJSON_New_Item();
-    if (!newitem)
+    *value = 0;
+    for (i = bytes; i > 0; i--)
     {
-        return NULL;
+        *value = (*value << 8) | in[i - 1];
     }
-    /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
-    newitem->valueint = item->valueint;
-    newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+
+    return in + bytes;
+}
+
+/* a string or key: the copy (or the input itself in place) goes to string */
+static const unsigned char *binary_get_string(const unsigned char *in, binary_buffer * const buffer, char **string)
+{
+    const unsigned char *start = in;
+    cjuint64 length = 0;
+    in = binary_get_uint(in, buffer, 4, &length);
+    if (!in)
     {
-        newitem->valuestring = cJSON_strdup(item->valuestring);
-        if (!newitem->valuestring)
-        {
-            cJSON_Delete(newitem);
-            return NULL;
-        }
+        return NULL;
     }
-    if (item->string)
+    if (((size_t)(buffer->end - in) <= length) || (in[length] != '\0'))
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : cJSON_strdup(item->string);
-        if (!newitem->string)
-        {
-            cJSON_Delete(newitem);
-            return NULL;
-        }
+        return binary_error(buffer, start, cJSON_Error_InvalidBinary);
     }
-    /* If non-recursive, then we're done! */
-    if (!recurse)
+    if (buffer->in_place)
     {
-        return newitem;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+        *string = (char*)in;
+#pragma GCC diagnostic pop
     }
-    /* Walk the ->next chain for the child. */
-    cptr = item->child;
-    while (cptr)
+    else
     {
-        newchild = cJSON_Duplicate(cptr, 1); /* Duplicate (with recurse) each item in the ->next chain */
-        if (!newchild)
-        {
-            cJSON_Delete(newitem);
-            return NULL;
-        }
-        if (nptr)
-        {
-            /* If newitem->child already set, then crosswire ->prev and ->next and move on */
-            nptr->next = newchild;
-            newchild->prev = nptr;
-            nptr = newchild;
-        }
-        else
+        *string = (char*)buffer->hooks->allocate(buffer->hooks->context, (size_t)length + 1);
+        if (!*string)
         {
-            /* Set newitem->child and move to it */
-            newitem->child = newchild; nptr = newchild;
+            return binary_error(buffer, start, cJSON_Error_Memory);
         }
-        cptr = cptr->next;
+        memcpy(*string, in, (size_t)length + 1);
     }
 
-    return newitem;
+    return in + length + 1;
 }
 
-void cJSON_Minify(char *json)
+static const unsigned char *binary_read(cJSON * const item, const unsigned char *in, binary_buffer * const buffer)
 {
-    char *into = json;
-    while (*json)
-    {
-        if (*json == ' ')
-        {
-            json++;
-        }
-        else if (*json == '\t')
-        {
-            /* Whitespace characters. */
-            json++;
-        }
-        else if (*json == '\r')
-        {
-            json++;
-        }
-        else if (*json=='\n')
-        {
-            json++;
-        }
-        else if ((*json == '/') && (json[1] == '/'))
-        {
-            /* double-slash comments, to end of line. */
-            while (*json && (*json != '\n'))
+    const unsigned char *start = in;
+    cJSON *child = NULL;
+    cJSON *last = NULL;
+    cjuint64 value = 0;
+    cjuint64 count = 0;
+    cjuint64 i = 0;
+    size_t bytes = 0;
+    unsigned char tag = 0;
+
+    if (in >= buffer->end)
+    {
+        return binary_error(buffer, in, cJSON_Error_InvalidBinary);
+    }
+    tag = *in++;
+    switch (tag)
+    {
+        case BINARY_NULL:
+            item->type |= cJSON_NULL;
+            return in;
+
+        case BINARY_FALSE:
+            item->type |= cJSON_False;
+            return in;
+
+        case BINARY_TRUE:
+            item->type |= cJSON_True;
+            item->valueint = 1;
+            return in;
+
+        case BINARY_INT8:
+        case BINARY_INT16:
+        case BINARY_INT32:
+        case BINARY_INT64:
+            bytes = (size_t)1 << (tag - BINARY_INT8);
+            in = binary_get_uint(in, buffer, bytes, &value);
+            if (!in)
             {
-                json++;
+                return NULL;
             }
-        }
-        else if ((*json == '/') && (json[1] == '*'))
-        {
-            /* multiline comments. */
-            while (*json && !((*json == '*') && (json[1] == '/')))
+            if ((bytes < 8) && (value >> ((8 * bytes) - 1)))
             {
-                json++;
+                /* sign extend */
+                value |= ~(cjuint64)0 << (8 * bytes);
             }
-            json += 2;
-        }
-        else if (*json == '\"')
-        {
-            /* string literals, which are \" sensitive. */
-            *into++ = *json++;
-            while (*json && (*json != '\"'))
+            /* without relying on the conversion of out of range unsigned values */
+            item->valueint64 = (value >> 63) ? (-(cJSON_int64)(~value) - 1) : (cJSON_int64)value;
+            item->valuedouble = (double)item->valueint64;
+            item->valueint = clamp_to_int(item->valuedouble);
+            item->type |= cJSON_Number | cJSON_NumberIsInt64;
+            return in;
+
+        case BINARY_DOUBLE:
+            in = binary_get_uint(in, buffer, 8, &value);
+            if (!in)
+            {
+                return NULL;
+            }
+            memcpy(&item->valuedouble, &value, sizeof(value));
+            item->valueint = clamp_to_int(item->valuedouble);
+            item->type |= cJSON_Number;
+            return in;
+
+        case BINARY_STRING:
+            in = binary_get_string(in, buffer, &item->valuestring);
+            item->type |= cJSON_String | (buffer->in_place ? (cJSON_ValueStringIsConst | cJSON_StringIsInBuffer) : 0);
+            return in;
+
+        case BINARY_ARRAY:
+        case BINARY_OBJECT:
+            item->type |= (tag == BINARY_ARRAY) ? cJSON_Array : cJSON_Object;
+            in = binary_get_uint(in, buffer, 4, &count);
+            if (!in)
             {
-                if (*json == '\\')
+                return NULL;
+            }
+            if (count > (cjuint64)(buffer->end - in))
+            {
+                /* every child takes at least one byte */
+                return binary_error(buffer, start, cJSON_Error_InvalidBinary);
+            }
+            for (i = 0; i < count; i++)
+            {
+                child = cJSON_New_Item(buffer->hooks);
+                if (!child)
                 {
-                    *into++=*json++;
+                    return binary_error(buffer, in, cJSON_Error_Memory);
+                }
+                if (last)
+                {
+                    suffix_object(last, child);
+                }
+                else
+                {
+                    item->child = child;
+                }
+                last = child;
+                if (tag == BINARY_OBJECT)
+                {
+                    in = binary_get_string(in, buffer, &child->string);
+                    if (!in)
+                    {
+                        return NULL;
+                    }
+                    child->type |= buffer->in_place ? (cJSON_StringIsConst | cJSON_StringIsInBuffer) : 0;
+                }
+                in = binary_read(child, in, buffer);
+                if (!in)
+                {
+                    return NULL;
                 }
-                *into++ = *json++;
             }
-            *into++ = *json++;
+            if (buffer->index_threshold && (count >= buffer->index_threshold))
+            {
+                /* the index is optional, decoding doesn't fail without it */
+                item->index = create_index(buffer->hooks);
+                if (item->index)
+                {
+                    index_build(item);
+                }
+            }
+            return in;
+
+        default:
+            return binary_error(buffer, start, cJSON_Error_InvalidBinary);
+    }
+}
+
+/* cJSON_ParseBinary and cJSON_ParseBinaryInSitu */
+static cJSON *parse_binary(const unsigned char *data, size_t length, const cjbool in_place, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    internal_hooks hooks;
+    binary_buffer buffer;
+    const unsigned char *end = NULL;
+    cJSON *item = NULL;
+
+    memset(&buffer, '\0', sizeof(buffer));
+    buffer.error_code = cJSON_Error_InvalidArgument;
+    if (data && hooks_from_allocator(&hooks, options ? options->allocator : NULL))
+    {
+        buffer.end = data + length;
+        buffer.hooks = &hooks;
+        buffer.index_threshold = (options && (options->index_threshold > 0)) ? (size_t)options->index_threshold : 0;
+        buffer.in_place = in_place;
+        buffer.error = data;
+        buffer.error_code = cJSON_Error_InvalidBinary;
+        if ((length >= sizeof(binary_header)) && !memcmp(data, binary_header, sizeof(binary_header)))
+        {
+            item = cJSON_New_Item(&hooks);
+            buffer.error_code = item ? cJSON_Error_None : cJSON_Error_Memory;
         }
-        else
+    }
+    if (item)
+    {
+        end = binary_read(item, data + sizeof(binary_header), &buffer);
+        if (end && options && options->require_null_terminated && (end != buffer.end))
         {
-            /* All other characters. */
-            *into++ = *json++;
+            end = binary_error(&buffer, end, cJSON_Error_TrailingGarbage);
+        }
+        if (!end)
+        {
+            delete_item(item, &hooks);
+            item = NULL;
         }
     }
 
-    /* and null-terminate. */
-    *into = '\0';
+    if (error)
+    {
+        /* there are no lines in binary input */
+        memset(error, '\0', sizeof(cJSON_ParseError));
+        error->code = item ? cJSON_Error_None : buffer.error_code;
+        error->position = (item ? end : buffer.error) ? (size_t)((item ? end : buffer.error) - data) : 0;
+        error->line = 1;
+        error->column = (int)error->position + 1;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_ParseBinary(const unsigned char *data, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    return parse_binary(data, length, false, options, error);
+}
+
+cJSON *cJSON_ParseBinaryInSitu(const unsigned char *data, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    return parse_binary(data, length, true, options, error);
 }
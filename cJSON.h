@@ -29,6 +29,7 @@ extern "C"
 #endif
 
 #include <stddef.h>
+#include <limits.h>
 
 /* cJSON Types: */
 #define cJSON_False  (1 << 0)
@@ -41,6 +42,28 @@ extern "C"
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+/* set on numbers whose exact integer value is in valueint64 */
+#define cJSON_NumberIsInt64 1024
+/* set on strings whose valuestring belongs to a cJSON_StringTable (like cJSON_StringIsConst for the key) */
+#define cJSON_ValueStringIsConst 2048
+/* set on items that show the content of a subtree frozen by cJSON_Share (see there) */
+#define cJSON_IsShared 4096
+/* set on the items of a frozen subtree, they can't be modified or deleted */
+#define cJSON_IsImmutable 8192
+/* set on items whose const string and valuestring point into the input of cJSON_ParseInSitu or
+ * cJSON_ParseBinaryInSitu, so cJSON_Duplicate copies them instead of sharing them */
+#define cJSON_StringIsInBuffer 16384
+
+/* 64 bit signed integer, ISO C90 doesn't have one */
+#if defined(_MSC_VER)
+    typedef __int64 cJSON_int64;
+#elif LONG_MAX > 2147483647L
+    typedef long cJSON_int64;
+#elif defined(__GNUC__)
+    __extension__ typedef long long cJSON_int64;
+#else
+    typedef long long cJSON_int64;
+#endif
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -60,9 +83,16 @@ typedef struct cJSON
     int valueint;
     /* The item's number, if type==cJSON_Number */
     double valuedouble;
+    /* The item's number without loss of precision, if type==cJSON_Number and (type & cJSON_NumberIsInt64).
+     * The parser sets it for integer literals (no fraction or exponent) that fit. It's only used while
+     * (double)valueint64 == valuedouble, so assigning valuedouble directly still changes the number. */
+    cJSON_int64 valueint64;
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* Lookup index of an array or object, managed by cJSON (see cJSON_EnableIndex). NULL if there is none. */
+    struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -74,9 +104,72 @@ typedef struct cJSON_Hooks
 /* Supply malloc, realloc and free functions to cJSON */
 extern void cJSON_InitHooks(cJSON_Hooks* hooks);
 
+/* An allocator that is passed to a single call instead of being installed globally, so every thread can use its own.
+ * context is handed to every function. realloc_fn is optional (NULL makes cJSON fall back to malloc + memcpy + free). */
+typedef struct cJSON_Allocator
+{
+    void *context;
+    void *(*malloc_fn)(void *context, size_t size);
+    void *(*realloc_fn)(void *context, void *pointer, size_t size);
+    void (*free_fn)(void *context, void *pointer);
+} cJSON_Allocator;
+
+/* Counters for finding out where the time goes, only collected if cJSON is compiled with CJSON_STATS defined
+ * (cmake -DENABLE_CJSON_STATS=On). They are global and not synchronized, so use them from one thread at a time;
+ * the tasks of cJSON_ParseArrayParallel count on their own and are added up when they are done. Every text parser
+ * is counted: the cJSON_Parse* functions, the push parser (when it is done, with all the input fed to it until then),
+ * cJSON_ParseSAX and cJSON_ParseTape. Lazy parses reach their full depth, the containers are checked right away. */
+typedef struct cJSON_Stats
+{
+    unsigned long node_allocations;
+    unsigned long string_allocations;
+    /* text consumed by successful parses */
+    unsigned long bytes_parsed;
+    /* print buffers that had to grow */
+    unsigned long buffer_reallocations;
+    /* keys compared by cJSON_GetObjectItem and cJSON_GetObjectItemCaseSensitive */
+    unsigned long key_comparisons;
+    /* deepest nesting of arrays and objects a single parse has reached */
+    unsigned long max_depth;
+} cJSON_Stats;
+
+/* Copy the counters to stats. Returns 0 (and zeroes stats) if they aren't compiled in. */
+extern int cJSON_GetStats(cJSON_Stats *stats);
+extern void cJSON_ResetStats(void);
+/* Called with operation "parse" or "print" and the counters so far when one starts and when it ends. */
+typedef void (*cJSON_StatsFunction)(void *context, const char *operation, const cJSON_Stats *stats);
+/* Either function may be NULL. Does nothing if the counters aren't compiled in. */
+extern void cJSON_SetStatsCallbacks(cJSON_StatsFunction begin, cJSON_StatsFunction end, void *context);
+
+/* An arena hands out the memory for whole parse trees from a few big chunks (taken from the hooks above).
+ * Trees parsed into an arena must NOT be passed to cJSON_Delete, they are released all at once by
+ * cJSON_ArenaReset or cJSON_DeleteArena. Don't add heap allocated items to them either. */
+typedef struct cJSON_Arena cJSON_Arena;
+
+/* Create an arena that allocates chunk_size bytes at a time (0 picks a default of 64KiB). */
+extern cJSON_Arena *cJSON_CreateArena(size_t chunk_size);
+/* Release every tree that was parsed into the arena; one chunk is kept around for reuse. */
+extern void cJSON_ArenaReset(cJSON_Arena *arena);
+extern void cJSON_DeleteArena(cJSON_Arena *arena);
+/* Fill in an allocator that allocates from the arena, for use with the *WithAllocator functions. */
+extern void cJSON_GetArenaAllocator(cJSON_Arena *arena, cJSON_Allocator *allocator);
+
+/* A table of interned strings: every distinct string is stored once, so parses that use one (see cJSON_ParseOptions)
+ * share their keys instead of allocating a copy for every object. The strings live until the table is deleted,
+ * so it has to outlive every tree parsed with it. A table may only be used by one parse at a time. */
+typedef struct cJSON_StringTable cJSON_StringTable;
+
+extern cJSON_StringTable *cJSON_CreateStringTable(void);
+extern void cJSON_DeleteStringTable(cJSON_StringTable *table);
+/* The table's copy of string, added if it isn't in there yet. NULL if out of memory. Looking up keys with it
+ * is faster for trees parsed with the table, they compare by pointer first. */
+extern const char *cJSON_InternString(cJSON_StringTable *table, const char *string);
+
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
 extern cJSON *cJSON_Parse(const char *value);
+/* Like cJSON_Parse, but all nodes and strings are allocated from the arena. Release with cJSON_ArenaReset, not cJSON_Delete. */
+extern cJSON *cJSON_ParseWithArena(const char *value, cJSON_Arena *arena);
 /* Render a cJSON entity to text for transfer/storage. Free the char* when finished. */
 extern char  *cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. Free the char* when finished. */
@@ -85,16 +178,58 @@ extern char  *cJSON_PrintUnformatted(const cJSON *item);
 extern char *cJSON_PrintBuffered(const cJSON *item, int prebuffer, int fmt);
 /* Render a cJSON entity to text using a buffer already allocated in memory with length buf_len. Returns 1 on success and 0 on failure. */
 extern int cJSON_PrintPreallocated(cJSON *item, char *buf, const int len, const int fmt);
+/* The exact number of characters cJSON_Print (fmt=1) or cJSON_PrintUnformatted (fmt=0) produce for item, without the
+ * terminating zero, so printing into a buffer of cJSON_PrintLength + 1 bytes with cJSON_PrintPreallocated always
+ * succeeds. Returns 0 if item can't be printed. */
+extern size_t cJSON_PrintLength(const cJSON *item, int fmt);
+/* Called by cJSON_PrintLengths with the length of every array and object, children before their parent. With fmt=1
+ * a nested container's length includes the indentation of its closing bracket, so it's its length within item. */
+typedef void (*cJSON_LengthFunction)(void *context, const cJSON *item, size_t length);
+/* cJSON_PrintLength that reports the subtree lengths to length_fn (with context) on the way */
+extern size_t cJSON_PrintLengths(const cJSON *item, int fmt, cJSON_LengthFunction length_fn, void *context);
+/* Receives the output of cJSON_PrintToWriter piece by piece. Return 0 to stop printing. */
+typedef int (*cJSON_WriteFunction)(void *context, const char *data, size_t length);
+/* Render a cJSON entity to text and pass it to write_fn (with context) in chunks, so the whole text never has to be in memory.
+ * No terminating zero is written. Returns 1 on success, 0 if memory ran out or write_fn failed. */
+extern int cJSON_PrintToWriter(const cJSON *item, cJSON_WriteFunction write_fn, void *context, int fmt);
 /* Delete a cJSON entity and all subentities. */
 extern void   cJSON_Delete(cJSON *c);
 
+/* Variants of the above that take their memory from allocator instead of the global hooks (NULL means the global hooks).
+ * A tree has to be deleted with the allocator it was created with. Functions that modify a tree and don't take an
+ * allocator (Replace*, Delete*, AddItemToObject) use the global hooks, so use Detach* and the functions below instead.
+ * Text returned by cJSON_PrintWithAllocator has to be released with the allocator's free_fn. */
+extern cJSON *cJSON_ParseWithAllocator(const char *value, const char **return_parse_end, int require_null_terminated, const cJSON_Allocator *allocator);
+extern char  *cJSON_PrintWithAllocator(const cJSON *item, int fmt, const cJSON_Allocator *allocator);
+extern cJSON *cJSON_DuplicateWithAllocator(const cJSON *item, int recurse, const cJSON_Allocator *allocator);
+extern void   cJSON_DeleteWithAllocator(cJSON *c, const cJSON_Allocator *allocator);
+extern cJSON *cJSON_CreateNumberWithAllocator(double num, const cJSON_Allocator *allocator);
+extern cJSON *cJSON_CreateStringWithAllocator(const char *string, const cJSON_Allocator *allocator);
+extern cJSON *cJSON_CreateArrayWithAllocator(const cJSON_Allocator *allocator);
+extern cJSON *cJSON_CreateObjectWithAllocator(const cJSON_Allocator *allocator);
+extern void   cJSON_AddItemToObjectWithAllocator(cJSON *object, const char *string, cJSON *item, const cJSON_Allocator *allocator);
+
 /* Returns the number of items in an array (or object). */
 extern int	  cJSON_GetArraySize(const cJSON *array);
 /* Retrieve item number "item" from array "array". Returns NULL if unsuccessful. */
 extern cJSON *cJSON_GetArrayItem(const cJSON *array, int item);
 /* Get item "string" from object. Case insensitive. */
 extern cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+/* Get item "string" from object. Case sensitive, so the keys are compared with strcmp. */
+extern cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string);
 extern int cJSON_HasObjectItem(const cJSON *object, const char *string);
+
+/* Give an array or object an index, so cJSON_GetArraySize and cJSON_GetArrayItem are O(1) and looking up, detaching and
+ * replacing items doesn't have to walk the whole list. Objects also get a hash table of their keys. The index is built on the first lookup and kept up to date by the functions in this header that add, detach or
+ * replace items. Objects with duplicate keys (compared case insensitively) keep working, but are searched linearly.
+ * If you modify child/next/prev yourself, call cJSON_InvalidateIndex afterwards.
+ * Since the first lookup modifies the index, do one before sharing the object between threads.
+ * Returns 1 on success, 0 on failure. */
+extern int cJSON_EnableIndex(cJSON *item);
+/* Remove the index and give its memory back. */
+extern void cJSON_DisableIndex(cJSON *item);
+/* Rebuild the index on the next lookup. */
+extern void cJSON_InvalidateIndex(cJSON *item);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 extern const char *cJSON_GetErrorPtr(void);
 
@@ -104,6 +239,8 @@ extern cJSON *cJSON_CreateTrue(void);
 extern cJSON *cJSON_CreateFalse(void);
 extern cJSON *cJSON_CreateBool(int b);
 extern cJSON *cJSON_CreateNumber(double num);
+/* A number that keeps all 64 bits of num (valuedouble and valueint are as close as they can get). */
+extern cJSON *cJSON_CreateInt64(cJSON_int64 num);
 extern cJSON *cJSON_CreateString(const char *string);
 extern cJSON *cJSON_CreateArray(void);
 extern cJSON *cJSON_CreateObject(void);
@@ -114,14 +251,16 @@ extern cJSON *cJSON_CreateFloatArray(const float *numbers, int count);
 extern cJSON *cJSON_CreateDoubleArray(const double *numbers, int count);
 extern cJSON *cJSON_CreateStringArray(const char **strings, int count);
 
-/* Append item to the specified array/object. */
+/* Append item to the specified array/object. These and the insert/replace functions below take over the item: if
+ * the array/object can't be modified (it is frozen, see cJSON_Share) the item is freed. */
 extern void cJSON_AddItemToArray(cJSON *array, cJSON *item);
 extern void	cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
 /* Use this when string is definitely const (i.e. a literal, or as good as), and will definitely survive the cJSON object.
  * WARNING: When this function was used, make sure to always check that (item->type & cJSON_StringIsConst) is zero before
  * writing to `item->string` */
 extern void	cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item);
-/* Append reference to item to the specified array/object. Use this when you want to add an existing cJSON to a new cJSON, but don't want to corrupt your existing cJSON. */
+/* Append reference to item to the specified array/object. Use this when you want to add an existing cJSON to a new cJSON, but don't want to corrupt your existing cJSON.
+ * A reference to a frozen item can be added anywhere, its content stays read only. */
 extern void cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item);
 extern void	cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item);
 
@@ -142,11 +281,216 @@ extern cJSON *cJSON_Duplicate(const cJSON *item, int recurse);
 need to be released. With recurse!=0, it will duplicate any children connected to the item.
 The item->next and ->prev pointers are always zero on return from Duplicate. */
 
+/* Copy on write sharing: cJSON_Share freezes the detached tree item (which it takes over) and returns an item flagged
+ * cJSON_IsShared that shows its content, holding a reference to it. cJSON_Duplicate of a shared item is another such
+ * item, in O(1), and the frozen tree is freed by cJSON_Delete of the last one. Frozen items (cJSON_IsImmutable),
+ * reached by walking the children of a shared item, are read only: the functions in this header refuse to modify
+ * them. Modifying a shared item itself first gives it a private copy of its level (see cJSON_Unshare), whose
+ * children are shared items again, so a modified copy costs the size of the levels on the way to the change.
+ * Reference counts are atomic (with GCC compatible compilers and MSVC), so frozen trees can be read and shared items
+ * created and deleted by several threads. Shared trees use the global hooks; don't share arena trees. */
+extern cJSON *cJSON_Share(cJSON *item);
+/* Make a shared item modifiable, replacing its children by shared items with copies of their keys. Returns item,
+ * or NULL if it is frozen or out of memory. To change something deep down, unshare every level on the way to it
+ * (cJSON_GetObjectItem etc. return the new shared children of an unshared item). */
+extern cJSON *cJSON_Unshare(cJSON *item);
+
 /* ParseWithOpts allows you to require (and check) that the JSON is null terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error. If not, then cJSON_GetErrorPtr() does the job. */
 extern cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated);
 
+/* Error codes reported in cJSON_ParseError */
+#define cJSON_Error_None 0
+#define cJSON_Error_Memory 1             /* an allocation failed */
+#define cJSON_Error_InvalidArgument 2    /* NULL input or an allocator without malloc_fn/free_fn */
+#define cJSON_Error_InvalidValue 3       /* no valid JSON value starts here */
+#define cJSON_Error_InvalidString 4      /* expected a string (or object key), or it is malformed or unterminated */
+#define cJSON_Error_InvalidEscape 5      /* unknown escape sequence in a string */
+#define cJSON_Error_InvalidUnicode 6     /* malformed unicode escape or surrogate pair */
+#define cJSON_Error_ExpectedColon 7      /* missing ':' after an object key */
+#define cJSON_Error_UnterminatedArray 8  /* expected ',' or ']' */
+#define cJSON_Error_UnterminatedObject 9 /* expected ',' or '}' */
+#define cJSON_Error_TrailingGarbage 10   /* require_null_terminated was set and there is more input */
+#define cJSON_Error_Aborted 11          /* a cJSON_SAXHandler callback stopped parsing */
+#define cJSON_Error_InvalidBinary 12    /* unknown tag, bad header or truncated binary encoding */
+
+/* Where and why parsing failed. Owned by the caller, so parsing never has to touch global state. */
+typedef struct cJSON_ParseError
+{
+    /* byte offset of the error, or of the end of the parsed value on success */
+    size_t position;
+    /* line and column (both starting at 1, counted in bytes) of position */
+    int line;
+    int column;
+    /* one of the cJSON_Error_ codes above */
+    int code;
+} cJSON_ParseError;
+
+/* Runs task(argument, i) for every i below count, in any order and possibly concurrently (e.g. on a thread pool),
+ * and returns when all of them are done. */
+typedef void (*cJSON_Executor)(void *context, void (*task)(void *argument, size_t i), void *argument, size_t count);
+
+/* Options for cJSON_ParseWithOptions. Zero initialise the whole struct before setting the fields you need. */
+typedef struct cJSON_ParseOptions
+{
+    /* where the tree gets its memory from, NULL means the global hooks */
+    const cJSON_Allocator *allocator;
+    /* fail with cJSON_Error_TrailingGarbage if anything but whitespace follows the value */
+    int require_null_terminated;
+    /* arrays and objects with at least this many children get an index (see cJSON_EnableIndex) while parsing, 0 for none */
+    int index_threshold;
+    /* cJSON_ParseArrayParallel splits the root array into this many pieces and parses them with executor (NULL for
+     * one after the other in the calling thread). */
+    int parallel_tasks;
+    cJSON_Executor executor;
+    void *executor_context;
+    /* Lazy parsing: the input is validated, but the children of arrays and objects are only parsed when they are first
+     * reached through cJSON_GetArrayItem, cJSON_GetObjectItem, cJSON_GetArraySize, cJSON_ArrayForEach, printing and so on. The input
+     * must stay unchanged until the tree is deleted. Code that walks child itself has to call cJSON_Materialize first,
+     * and because lookups materialize, a lazy tree can't be read by several threads at once. Not used by the push parser. */
+    int lazy;
+    /* Keys are taken from this table (flagged cJSON_StringIsConst), and so are string values of at most
+     * intern_value_length bytes (flagged cJSON_ValueStringIsConst). cJSON_Delete doesn't free them.
+     * Not used by the push parser and cJSON_ParseArrayParallel. */
+    cJSON_StringTable *string_table;
+    int intern_value_length;
+} cJSON_ParseOptions;
+
+/* Reentrant parse: errors are reported through error (may be NULL), cJSON_GetErrorPtr() is not updated.
+ * options may be NULL for the defaults. */
+extern cJSON *cJSON_ParseWithOptions(const char *value, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+/* Like cJSON_ParseWithOptions, but the input is the length bytes at value and doesn't have to be zero terminated
+ * (a zero byte still ends it early), so JSON can be parsed straight out of network buffers or mapped files.
+ * Bytes past value + length never affect the result. The vector scans may load the rest of the aligned 16 byte
+ * block that holds the last byte, which never crosses into another page, so this is safe for mapped files too. */
+extern cJSON *cJSON_ParseWithLength(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+/* Like cJSON_ParseWithLength, but the input is overwritten: strings are unescaped and zero terminated where they are,
+ * and valuestring and string point into value (flagged cJSON_ValueStringIsConst and cJSON_StringIsConst) instead of
+ * being allocated. value must stay valid until the tree is deleted, and doesn't hold the JSON text anymore.
+ * The items are flagged cJSON_StringIsInBuffer as well: a cJSON_Duplicate of the tree copies the strings and doesn't
+ * depend on value. */
+extern cJSON *cJSON_ParseInSitu(char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+/* Parse the children of an array or object from a lazy parse (the grandchildren stay lazy), so child can be walked.
+ * Does nothing for other items. Returns 0 if out of memory. */
+extern int cJSON_Materialize(const cJSON *item);
+
+/* Push parser for input that arrives in chunks: feed the chunks in order as they come, the partial tree and the
+ * lexer state are kept in between, so nothing has to be buffered up front. The tree is the same cJSON_ParseWithOptions
+ * builds. The chunks are not referenced after cJSON_ParserFeed returns. */
+typedef struct cJSON_Parser cJSON_Parser;
+
+/* Results of cJSON_ParserFeed */
+#define cJSON_ParserNeedMore 0 /* all input so far is valid, but the value isn't complete yet */
+#define cJSON_ParserDone 1     /* the value is complete, take it with cJSON_ParserTakeResult */
+#define cJSON_ParserError 2    /* the input is invalid, see cJSON_ParserGetError */
+
+/* options may be NULL for the defaults. Returns NULL if out of memory or the allocator is unusable. */
+extern cJSON_Parser *cJSON_CreateParser(const cJSON_ParseOptions *options);
+/* Feed the next length bytes. A zero length (or NULL chunk) marks the end of the input, which is needed to finish a
+ * number at the root, as in "123". A zero byte ends the input as well.
+ * Anything after the root value is ignored, unless require_null_terminated is set: then trailing input is still
+ * checked by later calls, and only the end of input makes a cJSON_ParserDone final. */
+extern int cJSON_ParserFeed(cJSON_Parser *parser, const char *chunk, size_t length);
+/* The parsed tree after cJSON_ParserDone, NULL otherwise. The caller owns it and deletes it with the allocator from the options. */
+extern cJSON *cJSON_ParserTakeResult(cJSON_Parser *parser);
+/* Error details after cJSON_ParserError, positions are offsets into the whole stream. */
+extern void cJSON_ParserGetError(const cJSON_Parser *parser, cJSON_ParseError *error);
+/* Deletes the parser, and the tree too if it wasn't taken. */
+extern void cJSON_DeleteParser(cJSON_Parser *parser);
+
+/* Callbacks for cJSON_ParseSAX, any of them may be NULL. Returning 0 stops parsing with cJSON_Error_Aborted. */
+typedef struct cJSON_SAXHandler
+{
+    int (*null)(void *context);
+    int (*boolean)(void *context, int value);
+    /* the value as cJSON_Parse would store it in valuedouble, and the number's text in the input */
+    int (*number)(void *context, double value, const char *text, size_t length);
+    /* Strings and keys are the slice of the input between the quotes, not zero terminated. If escaped is set it
+     * still contains (valid) escape sequences, cJSON_UnescapeString decodes them. */
+    int (*string)(void *context, const char *string, size_t length, int escaped);
+    int (*start_object)(void *context);
+    int (*key)(void *context, const char *string, size_t length, int escaped);
+    int (*end_object)(void *context);
+    int (*start_array)(void *context);
+    int (*end_array)(void *context);
+} cJSON_SAXHandler;
+
+/* Parse the length bytes at value like cJSON_ParseWithLength, but report every value to handler as it is read
+ * instead of building a tree. Nothing is allocated, except for a temporary copy of numbers of 64 or more characters.
+ * Of the options (may be NULL) allocator (for that copy) and require_null_terminated are used.
+ * Returns 1 if the input is valid and no callback stopped parsing, errors are reported through error (may be NULL). */
+extern int cJSON_ParseSAX(const char *value, size_t length, const cJSON_SAXHandler *handler, void *context, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+/* Decode the escape sequences in a string slice from cJSON_ParseSAX. out needs room for length + 1 bytes, it is zero
+ * terminated. Returns the decoded length, 0 if the escapes are invalid. */
+extern size_t cJSON_UnescapeString(const char *string, size_t length, char *out);
+
+/* Called by cJSON_ParseRecords for every record, index counts them from 0. item is the parsed record, or NULL with
+ * error set (positions relative to the start of the record) if it is invalid. The tree belongs to the parser and is
+ * released when the callback returns, so copy what you need. Return 0 to stop. */
+typedef int (*cJSON_RecordCallback)(void *context, size_t index, cJSON *item, const cJSON_ParseError *error);
+
+/* Parse a batch of whitespace separated (e.g. newline delimited) JSON documents from the length bytes at value, one
+ * callback per record. Trees are allocated from the arena, which is reset after every record so its chunks are reused,
+ * or from the allocator in options if arena is NULL. After an invalid record parsing resumes on the next line.
+ * Returns how many bytes were processed, less than length only if the callback stopped early. */
+extern size_t cJSON_ParseRecords(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_Arena *arena, cJSON_RecordCallback callback, void *context);
+/* Offset of the first line that starts after offset (length if there is none). To spread a big batch over threads,
+ * cut it at such boundaries and give every thread its own arena and a cJSON_ParseRecords call for its piece. */
+extern size_t cJSON_RecordBoundary(const char *value, size_t length, size_t offset);
+/* Like cJSON_ParseWithLength into an arena, but a root array is split into options->parallel_tasks pieces at element
+ * boundaries (found by a scan that skips strings), which are parsed concurrently by options->executor, each into an
+ * arena of its own. Those arenas are moved into arena afterwards, release the tree with cJSON_ArenaReset(arena).
+ * Other roots, and input that doesn't split cleanly, are parsed the usual way. options->allocator is not used. */
+extern cJSON *cJSON_ParseArrayParallel(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_Arena *arena, cJSON_ParseError *error);
+
+/* A read-only, compact form of a parsed document for walking big inputs. All values are 24 byte nodes in one
+ * contiguous array, in document order (a container is directly followed by its children), and all strings are in
+ * one pool, every distinct key only once. Nodes are referred to by their number: the root is 0, which also stands
+ * for "none" in the results below, since the root is never a child or sibling. */
+typedef struct cJSON_Tape cJSON_Tape;
+
+/* Parse the length bytes at value into a tape. Of the options (may be NULL) allocator and require_null_terminated
+ * are used. Release the tape with cJSON_DeleteTape. */
+extern cJSON_Tape *cJSON_ParseTape(const char *value, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+extern void cJSON_DeleteTape(cJSON_Tape *tape);
+/* Number of nodes, they are numbered 0 to count - 1. */
+extern size_t cJSON_TapeNodeCount(const cJSON_Tape *tape);
+/* One of the cJSON types, 0 if there is no such node. */
+extern int cJSON_TapeType(const cJSON_Tape *tape, size_t node);
+/* First child of an array or object, next sibling of a node, 0 if there is none. */
+extern size_t cJSON_TapeChild(const cJSON_Tape *tape, size_t node);
+extern size_t cJSON_TapeNext(const cJSON_Tape *tape, size_t node);
+/* Like cJSON_GetArraySize, cJSON_GetArrayItem and cJSON_GetObjectItem (case insensitive), 0 if not found. */
+extern int cJSON_TapeGetArraySize(const cJSON_Tape *tape, size_t node);
+extern size_t cJSON_TapeGetArrayItem(const cJSON_Tape *tape, size_t node, int which);
+extern size_t cJSON_TapeGetObjectItem(const cJSON_Tape *tape, size_t node, const char *string);
+/* The value of a number (0 for other nodes), of a string (zero terminated, its length is stored in length if that
+ * isn't NULL, NULL for other nodes), and the key of an object member (NULL for other nodes). The strings belong to the tape. */
+extern double cJSON_TapeNumber(const cJSON_Tape *tape, size_t node);
+extern const char *cJSON_TapeString(const cJSON_Tape *tape, size_t node, size_t *length);
+extern const char *cJSON_TapeKey(const cJSON_Tape *tape, size_t node);
+
+/* Remove whitespace and comments from json, in place. */
 extern void cJSON_Minify(char *json);
+/* The same for the length bytes at json (a zero byte ends them early), which aren't modified: the result goes to out,
+ * which needs room for length + 1 bytes (it may be json itself). The output is zero terminated, returns its length. */
+extern size_t cJSON_MinifyInto(const char *json, size_t length, char *out);
+
+/* A compact binary encoding of a tree, for passing trees between programs without printing and parsing text:
+ * strings are length prefixed, numbers keep their int64 or double value and containers start with their number of
+ * children. cJSON_BinarySize is the size of the encoding (0 if a string or container is bigger than 32 bits can
+ * count). cJSON_PrintBinary allocates it with the global hooks, cJSON_PrintBinaryPreallocated writes it to buffer
+ * and returns its size, 0 if buffer is too small. */
+extern size_t cJSON_BinarySize(const cJSON *item);
+extern unsigned char *cJSON_PrintBinary(const cJSON *item, size_t *length);
+extern size_t cJSON_PrintBinaryPreallocated(const cJSON *item, unsigned char *buffer, size_t size);
+/* Decode length bytes of binary encoding. Of the options only allocator, index_threshold and require_null_terminated
+ * (nothing may follow the value) are used; error->line is always 1 for binary input. */
+extern cJSON *cJSON_ParseBinary(const unsigned char *data, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error);
+/* The same without copying strings: keys and valuestrings (flagged cJSON_StringIsConst and cJSON_ValueStringIsConst)
+ * point into data, which isn't modified - it may be a read only mapping of a file - and has to outlive the tree.
+ * As with cJSON_ParseInSitu, a cJSON_Duplicate of the tree has its own copies of the strings. */
+extern cJSON *cJSON_ParseBinaryInSitu(const unsigned char *data, size_t length, const cJSON_ParseOptions *options, cJSON_ParseError *error);
 
 /* Macros for creating things quickly. */
 #define cJSON_AddNullToObject(object,name) cJSON_AddItemToObject(object, name, cJSON_CreateNull())
@@ -156,12 +500,14 @@ extern void cJSON_Minify(char *json);
 #define cJSON_AddNumberToObject(object,name,n) cJSON_AddItemToObject(object, name, cJSON_CreateNumber(n))
 #define cJSON_AddStringToObject(object,name,s) cJSON_AddItemToObject(object, name, cJSON_CreateString(s))
 
-/* When assigning an integer value, it needs to be propagated to valuedouble too. */
-#define cJSON_SetIntValue(object,val) ((object) ? (object)->valueint = (object)->valuedouble = (val) : (val))
-#define cJSON_SetNumberValue(object,val) ((object) ? (object)->valueint = (object)->valuedouble = (val) : (val))
+/* When assigning an integer value, it needs to be propagated to valuedouble too (and valueint64 isn't valid anymore). */
+#define cJSON_SetIntValue(object,val) ((object) ? ((object)->type &= ~cJSON_NumberIsInt64, (object)->valueint = (object)->valuedouble = (val)) : (val))
+#define cJSON_SetNumberValue(object,val) ((object) ? ((object)->type &= ~cJSON_NumberIsInt64, (object)->valueint = (object)->valuedouble = (val)) : (val))
 
-/* Macro for iterating over an array */
-#define cJSON_ArrayForEach(pos, head) for(pos = (head)->child; pos != NULL; pos = pos->next)
+/* Macro for iterating over an array (or object), lazy ones are materialized first */
+#define cJSON_ArrayForEach(pos, head) for(pos = cJSON_Materialize(head) ? (head)->child : NULL; pos != NULL; pos = pos->next)
+/* The same for the children of node parent of a tape, pos is a size_t */
+#define cJSON_TapeForEach(pos, tape, parent) for(pos = cJSON_TapeChild((tape), (parent)); pos != 0; pos = cJSON_TapeNext((tape), pos))
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include "cJSON_Utils.h"
 
 static char* cJSONUtils_strdup(const char* str)
@@ -126,6 +127,7 @@ char *cJSONUtils_FindPointerFromObjectTo(cJSON *object, cJSON *target)
     }
 
     /* recursively search all children of the object */
+    cJSON_Materialize(object);
     for (obj = object->child; obj; obj = obj->next, c++)
     {
         char *found = cJSONUtils_FindPointerFromObjectTo(obj, target);
@@ -161,11 +163,16 @@ char *cJSONUtils_FindPointerFromObjectTo(cJSON *object, cJSON *target)
     return NULL;
 }
 
-cJSON *cJSONUtils_GetPointer(cJSON *object, const char *pointer)
+/* follow the path of a pointer; if writable is set, every item on the way (and the one found) is unshared first, so
+ * that the result can be modified, NULL if one of them can't be */
+static cJSON *cJSONUtils_FollowPointer(cJSON *object, const char *pointer, int writable)
 {
-    /* follow path of the pointer */
     while ((*pointer++ == '/') && object)
     {
+        if (writable && !cJSON_Unshare(object))
+        {
+            return NULL;
+        }
         if ((object->type & 0xFF) == cJSON_Array)
         {
             int which = 0;
@@ -183,6 +190,7 @@ cJSON *cJSONUtils_GetPointer(cJSON *object, const char *pointer)
         }
         else if ((object->type & 0xFF) == cJSON_Object)
         {
+            cJSON_Materialize(object);
             object = object->child;
             /* GetObjectItem. */
             while (object && cJSONUtils_Pstrcasecmp(object->string, pointer))
@@ -201,9 +209,32 @@ cJSON *cJSONUtils_GetPointer(cJSON *object, const char *pointer)
         }
     }
 
+    if (writable && object)
+    {
+        return cJSON_Unshare(object);
+    }
+
     return object;
 }
 
+cJSON *cJSONUtils_GetPointer(cJSON *object, const char *pointer)
+{
+    return cJSONUtils_FollowPointer(object, pointer, 0);
+}
+
+/* the parent a patch modifies, made modifiable; status is set to 11 if it exists but can't be (it is frozen, or out of
+ * memory unsharing it) */
+static cJSON *cJSONUtils_PatchParent(cJSON *object, const char *pointer, int *status)
+{
+    cJSON *parent = cJSONUtils_FollowPointer(object, pointer, 1);
+    if (!parent && cJSONUtils_GetPointer(object, pointer))
+    {
+        *status = 11;
+    }
+
+    return parent;
+}
+
 /* JSON Patch implementation. */
 static void cJSONUtils_InplaceDecodePointerString(char *string)
 {
@@ -220,12 +251,88 @@ static void cJSONUtils_InplaceDecodePointerString(char *string)
     *s2 = '\0';
 }
 
-static cJSON *cJSONUtils_PatchDetach(cJSON *object, const char *path)
+/* One change made by an atomic ApplyPatches, undone in reverse order on failure. Positions are those in the parent at
+ * the time of the change, which is the state the parent is in again when the change is undone. */
+typedef struct
+{
+    cJSON *parent;
+    cJSON *item;
+    char *string; /* key of a moved item before it was added to an object */
+    int position;
+    int linked; /* item was added to parent, otherwise detached from it */
+    int owned; /* item is deleted on rollback if it was added, when committing if it was detached */
+    int rekeyed; /* a moved item got a new key, string is the old one */
+    int string_is_const;
+} cJSONUtils_Undo;
+
+typedef struct
+{
+    cJSONUtils_Undo *entries;
+    size_t count;
+    size_t size;
+} cJSONUtils_UndoLog;
+
+/* make room for the two changes a patch can make, so logging them can't fail */
+static int cJSONUtils_UndoReserve(cJSONUtils_UndoLog *log)
+{
+    cJSONUtils_Undo *entries = NULL;
+    size_t size = 0;
+    if ((log->count + 2) <= log->size)
+    {
+        return 1;
+    }
+
+    size = (log->size < 8) ? 8 : (log->size * 2);
+    entries = (cJSONUtils_Undo*)malloc(size * sizeof(cJSONUtils_Undo));
+    if (!entries)
+    {
+        return 0;
+    }
+    if (log->entries)
+    {
+        memcpy(entries, log->entries, log->count * sizeof(cJSONUtils_Undo));
+        free(log->entries);
+    }
+    log->entries = entries;
+    log->size = size;
+
+    return 1;
+}
+
+static cJSONUtils_Undo *cJSONUtils_UndoAdd(cJSONUtils_UndoLog *log, cJSON *parent, cJSON *item, int position, int linked, int owned)
+{
+    cJSONUtils_Undo *undo = log->entries + log->count++;
+    undo->parent = parent;
+    undo->item = item;
+    undo->string = NULL;
+    undo->position = position;
+    undo->linked = linked;
+    undo->owned = owned;
+    undo->rekeyed = 0;
+    undo->string_is_const = 0;
+
+    return undo;
+}
+
+/* position of an item in its parent */
+static int cJSONUtils_Position(const cJSON *item)
+{
+    int position = 0;
+    for (; item && item->prev; item = item->prev)
+    {
+        position++;
+    }
+
+    return position;
+}
+
+static cJSON *cJSONUtils_PatchDetach(cJSON *object, const char *path, cJSONUtils_UndoLog *undo, int *status)
 {
     char *parentptr = NULL;
     char *childptr = NULL;
     cJSON *parent = NULL;
     cJSON *ret = NULL;
+    int position = 0;
 
     /* copy path and split it in parent and child */
     parentptr = cJSONUtils_strdup(path);
@@ -235,7 +342,7 @@ static cJSON *cJSONUtils_PatchDetach(cJSON *object, const char *path)
         /* split strings */
         *childptr++ = '\0';
     }
-    parent = cJSONUtils_GetPointer(object, parentptr);
+    parent = cJSONUtils_PatchParent(object, parentptr, status);
     cJSONUtils_InplaceDecodePointerString(childptr);
 
     if (!parent)
@@ -245,20 +352,87 @@ static cJSON *cJSONUtils_PatchDetach(cJSON *object, const char *path)
     }
     else if ((parent->type & 0xFF) == cJSON_Array)
     {
-        ret = cJSON_DetachItemFromArray(parent, atoi(childptr));
+        position = atoi(childptr);
+        ret = cJSON_DetachItemFromArray(parent, position);
     }
     else if ((parent->type & 0xFF) == cJSON_Object)
     {
+        if (undo)
+        {
+            position = cJSONUtils_Position(cJSON_GetObjectItem(parent, childptr));
+        }
         ret = cJSON_DetachItemFromObject(parent, childptr);
     }
     free(parentptr);
 
+    if (ret && undo)
+    {
+        /* the caller gives the item back to the log by clearing owned if it keeps it */
+        cJSONUtils_UndoAdd(undo, parent, ret, position, 0, 1);
+    }
+
     /* return the detachted item */
     return ret;
 }
 
-static int cJSONUtils_Compare(cJSON *a, cJSON *b)
+/* unsigned 64 bit integer for the hashes, ISO C90 doesn't have one */
+#if ULONG_MAX > 4294967295UL
+    typedef unsigned long cJSONUtils_uint64;
+#elif defined(_MSC_VER)
+    typedef unsigned __int64 cJSONUtils_uint64;
+#elif defined(__GNUC__)
+    __extension__ typedef unsigned long long cJSONUtils_uint64;
+#else
+    #error "Failed to find a 64 bit integer type"
+#endif
+
+#define CJSONUTILS_FNV_OFFSET ((((cJSONUtils_uint64)0xCBF29CE4UL) << 32) | 0x84222325UL)
+#define CJSONUTILS_FNV_PRIME ((((cJSONUtils_uint64)0x100UL) << 32) | 0x000001B3UL)
+
+/* FNV-1a over length bytes (case folded if fold is set), continuing from hash */
+static cJSONUtils_uint64 cJSONUtils_HashBytes(cJSONUtils_uint64 hash, const unsigned char *bytes, size_t length, int fold)
 {
+    for (; length > 0; length--, bytes++)
+    {
+        hash ^= (cJSONUtils_uint64)(fold ? tolower(*bytes) : *bytes);
+        hash *= CJSONUTILS_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/* scramble a hash, so that sums of them (for objects) don't cancel out */
+static cJSONUtils_uint64 cJSONUtils_Mix(cJSONUtils_uint64 hash)
+{
+    hash ^= hash >> 33;
+    hash *= ((((cJSONUtils_uint64)0xFF51AFD7UL) << 32) | 0xED558CCDUL);
+    hash ^= hash >> 33;
+    hash *= ((((cJSONUtils_uint64)0xC4CEB9FEUL) << 32) | 0x1A85EC53UL);
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/* members of an object of at least this many are matched through a hash table, smaller ones by searching */
+#define CJSONUTILS_COMPARE_TABLE_MIN 8
+
+static cJSON **cJSONUtils_KeyTable(const cJSON *object, size_t count, size_t *size);
+static cJSON *cJSONUtils_FindKey(cJSON **table, size_t size, const cJSON *object, const char *key);
+
+/* valueint64 is the number only while it matches valuedouble, see cJSON.h */
+static int cJSONUtils_IsInt64(const cJSON *item)
+{
+    return (item->type & cJSON_NumberIsInt64) && ((double)item->valueint64 == item->valuedouble);
+}
+
+/* Compare two trees without changing them: 0 if they are equal (keys are case insensitive, the order of object members
+ * doesn't matter), otherwise a negative code for the first difference. */
+static int cJSONUtils_Compare(const cJSON *a, const cJSON *b)
+{
+    if (!a || !b)
+    {
+        return (a == b) ? 0 : -1;
+    }
     if ((a->type & 0xFF) != (b->type & 0xFF))
     {
         /* mismatched type. */
@@ -268,11 +442,18 @@ static int cJSONUtils_Compare(cJSON *a, cJSON *b)
     {
         case cJSON_Number:
             /* numeric mismatch. */
+            if (cJSONUtils_IsInt64(a) && cJSONUtils_IsInt64(b))
+            {
+                /* the doubles might be the same even though the integers aren't */
+                return (a->valueint64 != b->valueint64) ? -2 : 0;
+            }
             return ((a->valueint != b->valueint) || (a->valuedouble != b->valuedouble)) ? -2 : 0;
         case cJSON_String:
             /* string mismatch. */
             return (strcmp(a->valuestring, b->valuestring) != 0) ? -3 : 0;
         case cJSON_Array:
+            cJSON_Materialize(a);
+            cJSON_Materialize(b);
             for (a = a->child, b = b->child; a && b; a = a->next, b = b->next)
             {
                 int err = cJSONUtils_Compare(a, b);
@@ -284,44 +465,723 @@ static int cJSONUtils_Compare(cJSON *a, cJSON *b)
             /* array size mismatch? (one of both children is not NULL) */
             return (a || b) ? -4 : 0;
         case cJSON_Object:
-            cJSONUtils_SortObject(a);
-            cJSONUtils_SortObject(b);
-            a = a->child;
-            b = b->child;
-            while (a && b)
-            {
-                int err = 0;
-                /* compare object keys */
-                if (cJSONUtils_strcasecmp(a->string, b->string))
+        {
+            const cJSON *member = NULL;
+            cJSON **table = NULL;
+            size_t size = 0;
+            int count = cJSON_GetArraySize(a);
+            int err = 0;
+            if (count != cJSON_GetArraySize(b))
+            {
+                /* object length mismatch */
+                return -5;
+            }
+            /* find every member of a in b, through a temporary table for big objects */
+            table = (count >= CJSONUTILS_COMPARE_TABLE_MIN) ? cJSONUtils_KeyTable(b, (size_t)count, &size) : NULL;
+            for (member = a->child; member && !err; member = member->next)
+            {
+                const cJSON *other = cJSONUtils_FindKey(table, size, b, member->string);
+                /* missing member */
+                err = other ? cJSONUtils_Compare(member, other) : -6;
+            }
+            free(table);
+            return err;
+        }
+
+        default:
+            break;
+    }
+    /* null, true or false */
+    return 0;
+}
+
+/* Open addressing table (linear probing, twice the size of count) of the members of an object by their case folded
+ * key. NULL if out of memory, lookups then search the object. */
+static cJSON **cJSONUtils_KeyTable(const cJSON *object, size_t count, size_t *size)
+{
+    cJSON **table = NULL;
+    cJSON *member = NULL;
+    size_t slot = 0;
+
+    for (*size = CJSONUTILS_COMPARE_TABLE_MIN; *size < (count * 2); *size *= 2)
+    {
+    }
+    table = (cJSON**)calloc(*size, sizeof(cJSON*));
+    if (!table)
+    {
+        return NULL;
+    }
+    for (member = object->child; member; member = member->next)
+    {
+        slot = (size_t)cJSONUtils_HashBytes(CJSONUTILS_FNV_OFFSET, (const unsigned char*)member->string, member->string ? strlen(member->string) : 0, 1) & (*size - 1);
+        while (table[slot])
+        {
+            slot = (slot + 1) & (*size - 1);
+        }
+        table[slot] = member;
+    }
+
+    return table;
+}
+
+/* first member of object with the (case insensitive) key, through table if there is one */
+static cJSON *cJSONUtils_FindKey(cJSON **table, size_t size, const cJSON *object, const char *key)
+{
+    cJSON *member = NULL;
+    size_t slot = 0;
+    if (!table)
+    {
+        for (member = object->child; member && cJSONUtils_strcasecmp(member->string, key); member = member->next)
+        {
+        }
+        return member;
+    }
+
+    /* members were inserted in order, so the first one with the key comes first in its probe sequence */
+    slot = (size_t)cJSONUtils_HashBytes(CJSONUTILS_FNV_OFFSET, (const unsigned char*)key, key ? strlen(key) : 0, 1) & (size - 1);
+    for (; table[slot]; slot = (slot + 1) & (size - 1))
+    {
+        if (!cJSONUtils_strcasecmp(table[slot]->string, key))
+        {
+            return table[slot];
+        }
+    }
+
+    return NULL;
+}
+
+int cJSONUtils_Equal(const cJSON *a, const cJSON *b)
+{
+    return !cJSONUtils_Compare(a, b);
+}
+
+/* hash of a single item, the hashes of its children come from get_hash(context, child) */
+static cJSONUtils_uint64 cJSONUtils_HashItem(const cJSON *item, cJSONUtils_uint64 (*get_hash)(void *context, const cJSON *child), void *context)
+{
+    cJSONUtils_uint64 hash = CJSONUTILS_FNV_OFFSET;
+    const cJSON *child = NULL;
+    unsigned char type = (unsigned char)(item->type & 0xFF);
+    double number = item->valuedouble;
+
+    hash = cJSONUtils_HashBytes(hash, &type, 1, 0);
+    switch (item->type & 0xFF)
+    {
+        case cJSON_Number:
+            /* equal numbers have equal doubles (and 0 == -0) */
+            if (number == 0)
+            {
+                number = 0;
+            }
+            return cJSONUtils_Mix(cJSONUtils_HashBytes(hash, (const unsigned char*)&number, sizeof(number), 0));
+        case cJSON_String:
+            return cJSONUtils_Mix(cJSONUtils_HashBytes(hash, (const unsigned char*)item->valuestring, strlen(item->valuestring), 0));
+        case cJSON_Array:
+            cJSON_Materialize(item);
+            for (child = item->child; child; child = child->next)
+            {
+                hash = (hash ^ get_hash(context, child)) * CJSONUTILS_FNV_PRIME;
+            }
+            return cJSONUtils_Mix(hash);
+        case cJSON_Object:
+            /* independent of the order of the members */
+            cJSON_Materialize(item);
+            for (child = item->child; child; child = child->next)
+            {
+                const char *key = child->string ? child->string : "";
+                hash += cJSONUtils_Mix(cJSONUtils_HashBytes(get_hash(context, child), (const unsigned char*)key, strlen(key), 1));
+            }
+            return cJSONUtils_Mix(hash);
+        default:
+            return cJSONUtils_Mix(hash);
+    }
+}
+
+/* subtree hashes without a cache */
+static cJSONUtils_uint64 cJSONUtils_HashUncached(void *context, const cJSON *item)
+{
+    return cJSONUtils_HashItem(item, cJSONUtils_HashUncached, context);
+}
+
+typedef struct
+{
+    const cJSON *item;
+    cJSONUtils_uint64 hash;
+} cJSONUtils_HashEntry;
+
+struct cJSONUtils_Hashes
+{
+    /* open addressing table (linear probing) by item address */
+    cJSONUtils_HashEntry *entries;
+    size_t size; /* a power of 2 */
+};
+
+/* slot of an item in an open addressing table of size (a power of 2) by address */
+static size_t cJSONUtils_AddressSlot(const cJSON *item, size_t size)
+{
+    return (size_t)cJSONUtils_Mix((cJSONUtils_uint64)(size_t)item) & (size - 1);
+}
+
+static size_t cJSONUtils_CountItems(const cJSON *item)
+{
+    size_t count = 1;
+    cJSON_Materialize(item);
+    for (item = item->child; item; item = item->next)
+    {
+        count += cJSONUtils_CountItems(item);
+    }
+
+    return count;
+}
+
+/* hash of a subtree of the hashed tree, stored once it is computed */
+static cJSONUtils_uint64 cJSONUtils_HashCached(void *context, const cJSON *item)
+{
+    cJSONUtils_Hashes *hashes = (cJSONUtils_Hashes*)context;
+    size_t slot = cJSONUtils_AddressSlot(item, hashes->size);
+    cJSONUtils_uint64 hash = cJSONUtils_HashItem(item, cJSONUtils_HashCached, context);
+
+    while (hashes->entries[slot].item)
+    {
+        slot = (slot + 1) & (hashes->size - 1);
+    }
+    hashes->entries[slot].item = item;
+    hashes->entries[slot].hash = hash;
+
+    return hash;
+}
+
+cJSONUtils_Hashes *cJSONUtils_HashTree(const cJSON *root)
+{
+    cJSONUtils_Hashes *hashes = NULL;
+    size_t count = 0;
+    if (!root)
+    {
+        return NULL;
+    }
+
+    hashes = (cJSONUtils_Hashes*)malloc(sizeof(cJSONUtils_Hashes));
+    if (!hashes)
+    {
+        return NULL;
+    }
+    /* at most half full */
+    count = cJSONUtils_CountItems(root);
+    for (hashes->size = 16; hashes->size < (count * 2); hashes->size *= 2)
+    {
+    }
+    hashes->entries = (cJSONUtils_HashEntry*)calloc(hashes->size, sizeof(cJSONUtils_HashEntry));
+    if (!hashes->entries)
+    {
+        free(hashes);
+        return NULL;
+    }
+    cJSONUtils_HashCached(hashes, root);
+
+    return hashes;
+}
+
+void cJSONUtils_DeleteHashes(cJSONUtils_Hashes *hashes)
+{
+    if (hashes)
+    {
+        free(hashes->entries);
+        free(hashes);
+    }
+}
+
+/* the stored hash of item, computed if it isn't in hashes (or there are none) */
+static cJSONUtils_uint64 cJSONUtils_GetHash(const cJSONUtils_Hashes *hashes, const cJSON *item)
+{
+    size_t slot = 0;
+    if (hashes)
+    {
+        for (slot = cJSONUtils_AddressSlot(item, hashes->size); hashes->entries[slot].item; slot = (slot + 1) & (hashes->size - 1))
+        {
+            if (hashes->entries[slot].item == item)
+            {
+                return hashes->entries[slot].hash;
+            }
+        }
+    }
+
+    return cJSONUtils_HashUncached(NULL, item);
+}
+
+int cJSONUtils_EqualHashed(const cJSONUtils_Hashes *hashes_a, const cJSON *a, const cJSONUtils_Hashes *hashes_b, const cJSON *b)
+{
+    if (!a || !b)
+    {
+        return a == b;
+    }
+
+    return cJSONUtils_GetHash(hashes_a, a) == cJSONUtils_GetHash(hashes_b, b);
+}
+
+/* Path index: the parent and position of every item of a tree, by item address */
+typedef struct
+{
+    const cJSON *item;
+    const cJSON *parent;
+    int position;
+} cJSONUtils_PathEntry;
+
+struct cJSONUtils_PathIndex
+{
+    /* open addressing table (linear probing) */
+    cJSONUtils_PathEntry *entries;
+    size_t size; /* a power of 2 */
+};
+
+static void cJSONUtils_AddPaths(cJSONUtils_PathIndex *index, const cJSON *item, const cJSON *parent, int position)
+{
+    size_t slot = cJSONUtils_AddressSlot(item, index->size);
+    const cJSON *child = NULL;
+    while (index->entries[slot].item)
+    {
+        slot = (slot + 1) & (index->size - 1);
+    }
+    index->entries[slot].item = item;
+    index->entries[slot].parent = parent;
+    index->entries[slot].position = position;
+
+    for (position = 0, child = item->child; child; child = child->next, position++)
+    {
+        cJSONUtils_AddPaths(index, child, item, position);
+    }
+}
+
+cJSONUtils_PathIndex *cJSONUtils_BuildPathIndex(const cJSON *root)
+{
+    cJSONUtils_PathIndex *index = NULL;
+    size_t count = 0;
+    if (!root)
+    {
+        return NULL;
+    }
+
+    index = (cJSONUtils_PathIndex*)malloc(sizeof(cJSONUtils_PathIndex));
+    if (!index)
+    {
+        return NULL;
+    }
+    /* at most half full (counting materializes lazy containers) */
+    count = cJSONUtils_CountItems(root);
+    for (index->size = 16; index->size < (count * 2); index->size *= 2)
+    {
+    }
+    index->entries = (cJSONUtils_PathEntry*)calloc(index->size, sizeof(cJSONUtils_PathEntry));
+    if (!index->entries)
+    {
+        free(index);
+        return NULL;
+    }
+    cJSONUtils_AddPaths(index, root, NULL, 0);
+
+    return index;
+}
+
+void cJSONUtils_DeletePathIndex(cJSONUtils_PathIndex *index)
+{
+    if (index)
+    {
+        free(index->entries);
+        free(index);
+    }
+}
+
+static const cJSONUtils_PathEntry *cJSONUtils_FindPath(const cJSONUtils_PathIndex *index, const cJSON *item)
+{
+    size_t slot = 0;
+    for (slot = cJSONUtils_AddressSlot(item, index->size); index->entries[slot].item; slot = (slot + 1) & (index->size - 1))
+    {
+        if (index->entries[slot].item == item)
+        {
+            return index->entries + slot;
+        }
+    }
+
+    return NULL;
+}
+
+/* number of decimal digits of a position */
+static size_t cJSONUtils_Digits(int position)
+{
+    size_t digits = 1;
+    for (; position >= 10; position /= 10)
+    {
+        digits++;
+    }
+
+    return digits;
+}
+
+char *cJSONUtils_FindPointerFromIndex(const cJSONUtils_PathIndex *index, const cJSON *target)
+{
+    const cJSONUtils_PathEntry *entry = NULL;
+    char *pointer = NULL;
+    char *end = NULL;
+    size_t length = 0;
+    if (!index || !target)
+    {
+        return NULL;
+    }
+
+    /* measure the pointer while walking up to the root */
+    for (entry = cJSONUtils_FindPath(index, target); entry && entry->parent; entry = cJSONUtils_FindPath(index, entry->parent))
+    {
+        length += 1 + (((entry->parent->type & 0xFF) == cJSON_Array) ? cJSONUtils_Digits(entry->position) : (size_t)cJSONUtils_PointerEncodedstrlen(entry->item->string));
+    }
+    if (!entry)
+    {
+        /* not in the indexed tree */
+        return NULL;
+    }
+
+    pointer = (char*)malloc(length + 1);
+    if (!pointer)
+    {
+        return NULL;
+    }
+    /* and write it from its end on the second walk */
+    end = pointer + length;
+    *end = '\0';
+    for (entry = cJSONUtils_FindPath(index, target); entry->parent; entry = cJSONUtils_FindPath(index, entry->parent))
+    {
+        if ((entry->parent->type & 0xFF) == cJSON_Array)
+        {
+            int position = entry->position;
+            do
+            {
+                *--end = (char)('0' + (position % 10));
+                position /= 10;
+            } while (position > 0);
+        }
+        else
+        {
+            size_t key_length = (size_t)cJSONUtils_PointerEncodedstrlen(entry->item->string);
+            char following = *end;
+            end -= key_length;
+            cJSONUtils_PointerEncodedstrcpy(end, entry->item->string);
+            /* PointerEncodedstrcpy terminated the token */
+            end[key_length] = following;
+        }
+        *--end = '/';
+    }
+
+    return pointer;
+}
+
+/* Compiled JSON Pointers: the tokens are decoded once, with the hash of their case folded key and the array index */
+typedef struct
+{
+    const char *key;
+    cJSONUtils_uint64 hash;
+    int index; /* -1 if the token can't be an array index */
+} cJSONUtils_PointerToken;
+
+struct cJSONUtils_Pointer
+{
+    cJSONUtils_PointerToken *tokens;
+    size_t count;
+};
+
+cJSONUtils_Pointer *cJSONUtils_CompilePointer(const char *pointer)
+{
+    cJSONUtils_Pointer *compiled = NULL;
+    cJSONUtils_PointerToken *token = NULL;
+    const char *p = NULL;
+    char *key = NULL;
+    size_t count = 0;
+    if (!pointer || (*pointer && (*pointer != '/')))
+    {
+        return NULL;
+    }
+    for (p = pointer; *p; p++)
+    {
+        count += (*p == '/') ? 1 : 0;
+        if ((*p == '~') && (p[1] != '0') && (p[1] != '1'))
+        {
+            /* invalid escape sequence */
+            return NULL;
+        }
+    }
+
+    /* the tokens and their keys are in the same allocation as the pointer */
+    compiled = (cJSONUtils_Pointer*)malloc(sizeof(cJSONUtils_Pointer) + (count * sizeof(cJSONUtils_PointerToken)) + (size_t)(p - pointer) + 1);
+    if (!compiled)
+    {
+        return NULL;
+    }
+    compiled->tokens = (cJSONUtils_PointerToken*)(compiled + 1);
+    compiled->count = count;
+    key = (char*)(compiled->tokens + count);
+    for (token = compiled->tokens, p = pointer; *p++ == '/'; token++)
+    {
+        token->key = key;
+        token->index = 0;
+        for (; *p && (*p != '/'); p++)
+        {
+            if ((*p >= '0') && (*p <= '9') && (token->index >= 0))
+            {
+                token->index = (token->index > ((INT_MAX - 9) / 10)) ? -1 : ((10 * token->index) + (*p - '0'));
+            }
+            else
+            {
+                token->index = -1;
+            }
+            if (*p == '~')
+            {
+                *key++ = (*++p == '0') ? '~' : '/';
+            }
+            else
+            {
+                *key++ = *p;
+            }
+        }
+        *key++ = '\0';
+        token->hash = cJSONUtils_HashBytes(CJSONUTILS_FNV_OFFSET, (const unsigned char*)token->key, (size_t)(key - token->key - 1), 1);
+    }
+
+    return compiled;
+}
+
+void cJSONUtils_DeletePointer(cJSONUtils_Pointer *pointer)
+{
+    free(pointer);
+}
+
+/* follow a single token, like cJSONUtils_GetPointer does */
+static cJSON *cJSONUtils_FollowToken(const cJSON *object, const cJSONUtils_PointerToken *token)
+{
+    if ((object->type & 0xFF) == cJSON_Array)
+    {
+        return (token->index >= 0) ? cJSON_GetArrayItem(object, token->index) : NULL;
+    }
+    if ((object->type & 0xFF) == cJSON_Object)
+    {
+        return cJSON_GetObjectItem(object, token->key);
+    }
+
+    return NULL;
+}
+
+cJSON *cJSONUtils_GetCompiledPointer(cJSON *object, const cJSONUtils_Pointer *pointer)
+{
+    size_t i = 0;
+    if (!pointer)
+    {
+        return NULL;
+    }
+    for (i = 0; (i < pointer->count) && object; i++)
+    {
+        object = cJSONUtils_FollowToken(object, pointer->tokens + i);
+    }
+
+    return object;
+}
+
+typedef struct
+{
+    const cJSONUtils_Pointer *pointer;
+    int position;
+} cJSONUtils_PointerEntry;
+
+static int cJSONUtils_CompareTokens(const cJSONUtils_PointerToken *a, const cJSONUtils_PointerToken *b)
+{
+    if (a->hash != b->hash)
+    {
+        return (a->hash < b->hash) ? -1 : 1;
+    }
+
+    return cJSONUtils_strcasecmp(a->key, b->key);
+}
+
+/* order the pointers by their tokens (by hash), so pointers with a common prefix are next to each other */
+static int cJSONUtils_ComparePointerEntries(const void *a, const void *b)
+{
+    const cJSONUtils_Pointer *first = ((const cJSONUtils_PointerEntry*)a)->pointer;
+    const cJSONUtils_Pointer *second = ((const cJSONUtils_PointerEntry*)b)->pointer;
+    size_t i = 0;
+    int diff = 0;
+    for (i = 0; (i < first->count) && (i < second->count); i++)
+    {
+        diff = cJSONUtils_CompareTokens(first->tokens + i, second->tokens + i);
+        if (diff)
+        {
+            return diff;
+        }
+    }
+    if (first->count != second->count)
+    {
+        return (first->count < second->count) ? -1 : 1;
+    }
+
+    return ((const cJSONUtils_PointerEntry*)a)->position - ((const cJSONUtils_PointerEntry*)b)->position;
+}
+
+/* a container with at least this many distinct tokens to follow is walked once instead of being searched for each */
+#define CJSONUTILS_POINTER_WALK_MIN 8
+
+/* Resolve the sorted entries that all lead to item after depth tokens. While walking an object or array, the child
+ * found for a group of entries is kept in the result of the group's first entry until the group is resolved. */
+static void cJSONUtils_ResolvePointers(cJSON *item, const cJSONUtils_PointerEntry *entries, int count, size_t depth, cJSON **results)
+{
+    const cJSONUtils_PointerToken *token = NULL;
+    cJSON *child = NULL;
+    int groups = 0;
+    int start = 0;
+    int end = 0;
+
+    /* pointers that end here */
+    for (; (start < count) && (entries[start].pointer->count == depth); start++)
+    {
+        results[entries[start].position] = item;
+    }
+    if (!item || (start == count))
+    {
+        return;
+    }
+
+    for (end = start; end < count; groups++)
+    {
+        token = entries[end].pointer->tokens + depth;
+        for (end++; (end < count) && !cJSONUtils_CompareTokens(token, entries[end].pointer->tokens + depth); end++)
+        {
+        }
+    }
+    if ((groups >= CJSONUTILS_POINTER_WALK_MIN) && ((item->type & 0xFF) == cJSON_Object))
+    {
+        /* one pass over the members, finding the groups by the hash of their key */
+        cJSON_Materialize(item);
+        for (child = item->child; child; child = child->next)
+        {
+            cJSONUtils_uint64 hash = cJSONUtils_HashBytes(CJSONUTILS_FNV_OFFSET, (const unsigned char*)child->string, child->string ? strlen(child->string) : 0, 1);
+            int low = start;
+            int high = count;
+            /* first entry with this hash */
+            while (low < high)
+            {
+                int middle = low + ((high - low) / 2);
+                if (entries[middle].pointer->tokens[depth].hash < hash)
                 {
-                    /* missing member */
-                    return -6;
+                    low = middle + 1;
                 }
-                err = cJSONUtils_Compare(a, b);
-                if (err)
+                else
                 {
-                    return err;
+                    high = middle;
+                }
+            }
+            for (; (low < count) && (entries[low].pointer->tokens[depth].hash == hash); low = end)
+            {
+                token = entries[low].pointer->tokens + depth;
+                for (end = low + 1; (end < count) && !cJSONUtils_CompareTokens(token, entries[end].pointer->tokens + depth); end++)
+                {
+                }
+                /* the first member with the key wins */
+                if (!results[entries[low].position] && !cJSONUtils_strcasecmp(child->string, token->key))
+                {
+                    results[entries[low].position] = child;
                 }
-                a = a->next;
-                b = b->next;
             }
-            /* object length mismatch (one of both children is not null) */
-            return (a || b) ? -5 : 0;
+        }
+    }
+    else if ((groups >= CJSONUTILS_POINTER_WALK_MIN) && ((item->type & 0xFF) == cJSON_Array))
+    {
+        cJSON **children = NULL;
+        int size = 0;
+        int i = 0;
+        cJSON_Materialize(item);
+        size = cJSON_GetArraySize(item);
+        children = (cJSON**)malloc(sizeof(cJSON*) * (size_t)(size + 1));
+        for (i = 0, child = item->child; children && child; child = child->next, i++)
+        {
+            children[i] = child;
+        }
+        for (end = start; end < count; )
+        {
+            token = entries[end].pointer->tokens + depth;
+            if (token->index < 0)
+            {
+                child = NULL;
+            }
+            else
+            {
+                child = !children ? cJSON_GetArrayItem(item, token->index) : ((token->index < size) ? children[token->index] : NULL);
+            }
+            results[entries[end].position] = child;
+            for (end++; (end < count) && !cJSONUtils_CompareTokens(token, entries[end].pointer->tokens + depth); end++)
+            {
+            }
+        }
+        free(children);
+    }
+    else
+    {
+        for (end = start; end < count; )
+        {
+            token = entries[end].pointer->tokens + depth;
+            results[entries[end].position] = cJSONUtils_FollowToken(item, token);
+            for (end++; (end < count) && !cJSONUtils_CompareTokens(token, entries[end].pointer->tokens + depth); end++)
+            {
+            }
+        }
+    }
 
-        default:
-            break;
+    /* descend into the children that were found */
+    for (; start < count; start = end)
+    {
+        token = entries[start].pointer->tokens + depth;
+        for (end = start + 1; (end < count) && !cJSONUtils_CompareTokens(token, entries[end].pointer->tokens + depth); end++)
+        {
+        }
+        child = results[entries[start].position];
+        results[entries[start].position] = NULL;
+        cJSONUtils_ResolvePointers(child, entries + start, end - start, depth + 1, results);
+    }
+}
+
+int cJSONUtils_GetPointers(cJSON *object, const cJSONUtils_Pointer * const *pointers, int count, cJSON **results)
+{
+    cJSONUtils_PointerEntry *entries = NULL;
+    int valid = 0;
+    int i = 0;
+    if (!pointers || !results || (count < 0))
+    {
+        return 0;
+    }
+
+    entries = (cJSONUtils_PointerEntry*)malloc(sizeof(cJSONUtils_PointerEntry) * (size_t)(count + 1));
+    if (!entries)
+    {
+        return 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        results[i] = NULL;
+        if (pointers[i])
+        {
+            entries[valid].pointer = pointers[i];
+            entries[valid].position = i;
+            valid++;
+        }
     }
-    /* null, true or false */
-    return 0;
+    qsort(entries, (size_t)valid, sizeof(cJSONUtils_PointerEntry), cJSONUtils_ComparePointerEntries);
+    cJSONUtils_ResolvePointers(object, entries, valid, 0, results);
+    free(entries);
+
+    return 1;
 }
 
-static int cJSONUtils_ApplyPatch(cJSON *object, cJSON *patch)
+static int cJSONUtils_ApplyPatch(cJSON *object, cJSON *patch, cJSONUtils_UndoLog *undo)
 {
     cJSON *op = NULL;
     cJSON *path = NULL;
     cJSON *value = NULL;
     cJSON *parent = NULL;
+    cJSONUtils_Undo *moved = NULL;
+    cJSONUtils_Undo *added = NULL;
     int opcode = 0;
+    int status = 0;
     char *parentptr = NULL;
     char *childptr = NULL;
 
@@ -365,11 +1225,27 @@ static int cJSONUtils_ApplyPatch(cJSON *object, cJSON *patch)
         return 3;
     }
 
+    if (undo && !cJSONUtils_UndoReserve(undo))
+    {
+        /* out of memory for the undo log. */
+        return 10;
+    }
+
     /* Remove/Replace */
     if ((opcode == 1) || (opcode == 2))
     {
-        /* Get rid of old. */
-        cJSON_Delete(cJSONUtils_PatchDetach(object, path->valuestring));
+        /* Get rid of old (an atomic apply keeps it in its log). */
+        value = cJSONUtils_PatchDetach(object, path->valuestring, undo, &status);
+        if (!undo)
+        {
+            cJSON_Delete(value);
+        }
+        value = NULL;
+        if (status)
+        {
+            /* couldn't modify the parent. */
+            return status;
+        }
         if (opcode == 1)
         {
             /* For Remove, this is job done. */
@@ -390,7 +1266,13 @@ static int cJSONUtils_ApplyPatch(cJSON *object, cJSON *patch)
         if (opcode == 3)
         {
             /* move */
-            value = cJSONUtils_PatchDetach(object, from->valuestring);
+            value = cJSONUtils_PatchDetach(object, from->valuestring, undo, &status);
+            moved = (value && undo) ? (undo->entries + undo->count - 1) : NULL;
+            if (status)
+            {
+                /* couldn't modify the parent of "from". */
+                return status;
+            }
         }
         if (opcode == 4)
         {
@@ -437,43 +1319,81 @@ static int cJSONUtils_ApplyPatch(cJSON *object, cJSON *patch)
     {
         *childptr++ = '\0';
     }
-    parent = cJSONUtils_GetPointer(object, parentptr);
+    parent = cJSONUtils_PatchParent(object, parentptr, &status);
     cJSONUtils_InplaceDecodePointerString(childptr);
 
     /* add, remove, replace, move, copy, test. */
     if (!parent)
     {
-        /* Couldn't find object to add to. */
+        /* Couldn't find or modify object to add to (a moved item is still owned by the log). */
         free(parentptr);
-        cJSON_Delete(value);
-        return 9;
+        if (!moved)
+        {
+            cJSON_Delete(value);
+        }
+        return status ? status : 9;
     }
     else if ((parent->type & 0xFF) == cJSON_Array)
     {
+        int size = undo ? cJSON_GetArraySize(parent) : 0;
+        int which = 0;
         if (!strcmp(childptr, "-"))
         {
+            which = size;
             cJSON_AddItemToArray(parent, value);
         }
         else
         {
-            cJSON_InsertItemInArray(parent, atoi(childptr), value);
+            which = atoi(childptr);
+            cJSON_InsertItemInArray(parent, which, value);
+        }
+        if (undo)
+        {
+            /* out of range indices append */
+            added = cJSONUtils_UndoAdd(undo, parent, value, ((which >= 0) && (which < size)) ? which : size, 1, !moved);
         }
     }
     else if ((parent->type & 0xFF) == cJSON_Object)
     {
-        cJSON_DeleteItemFromObject(parent, childptr);
+        if (undo)
+        {
+            cJSON *old = cJSON_GetObjectItem(parent, childptr);
+            if (old)
+            {
+                cJSONUtils_UndoAdd(undo, parent, cJSON_DetachItemFromObject(parent, childptr), cJSONUtils_Position(old), 0, 1);
+            }
+            added = cJSONUtils_UndoAdd(undo, parent, value, cJSON_GetArraySize(parent), 1, !moved);
+            if (moved)
+            {
+                /* keep the old key of the moved item for a rollback */
+                added->rekeyed = 1;
+                added->string = value->string;
+                added->string_is_const = (value->type & cJSON_StringIsConst) ? 1 : 0;
+                value->string = NULL;
+            }
+        }
+        else
+        {
+            cJSON_DeleteItemFromObject(parent, childptr);
+        }
         cJSON_AddItemToObject(parent, childptr, value);
     }
-    else
+    else if (!moved)
     {
         cJSON_Delete(value);
     }
     free(parentptr);
 
+    if (moved && added)
+    {
+        /* the moved item is back in the tree */
+        moved->owned = 0;
+    }
+
     return 0;
 }
 
-int cJSONUtils_ApplyPatches(cJSON *object, cJSON *patches)
+static int cJSONUtils_ApplyPatchList(cJSON *object, cJSON *patches, cJSONUtils_UndoLog *undo)
 {
     int err = 0;
     if ((patches->type & 0xFF) != cJSON_Array)
@@ -483,11 +1403,12 @@ int cJSONUtils_ApplyPatches(cJSON *object, cJSON *patches)
     }
     if (patches)
     {
+        cJSON_Materialize(patches);
         patches = patches->child;
     }
     while (patches)
     {
-        if ((err = cJSONUtils_ApplyPatch(object, patches)))
+        if ((err = cJSONUtils_ApplyPatch(object, patches, undo)))
         {
             return err;
         }
@@ -497,6 +1418,67 @@ int cJSONUtils_ApplyPatches(cJSON *object, cJSON *patches)
     return 0;
 }
 
+int cJSONUtils_ApplyPatches(cJSON *object, cJSON *patches)
+{
+    return cJSONUtils_ApplyPatchList(object, patches, NULL);
+}
+
+int cJSONUtils_AtomicApplyPatches(cJSON *object, cJSON *patches)
+{
+    cJSONUtils_UndoLog undo;
+    cJSONUtils_Undo *entry = NULL;
+    int err = 0;
+    undo.entries = NULL;
+    undo.count = 0;
+    undo.size = 0;
+
+    err = cJSONUtils_ApplyPatchList(object, patches, &undo);
+    if (err)
+    {
+        /* roll back, newest change first */
+        while (undo.count > 0)
+        {
+            entry = undo.entries + --undo.count;
+            if (entry->linked)
+            {
+                cJSON_DetachItemFromArray(entry->parent, entry->position);
+                if (entry->rekeyed)
+                {
+                    free(entry->item->string);
+                    entry->item->string = entry->string;
+                    entry->item->type = (entry->item->type & ~cJSON_StringIsConst) | (entry->string_is_const ? cJSON_StringIsConst : 0);
+                }
+                if (entry->owned)
+                {
+                    cJSON_Delete(entry->item);
+                }
+            }
+            else
+            {
+                cJSON_InsertItemInArray(entry->parent, entry->position, entry->item);
+            }
+        }
+    }
+    else
+    {
+        /* commit: free what was removed or replaced */
+        for (entry = undo.entries; entry < (undo.entries + undo.count); entry++)
+        {
+            if (!entry->linked && entry->owned)
+            {
+                cJSON_Delete(entry->item);
+            }
+            if (entry->rekeyed && !entry->string_is_const)
+            {
+                free(entry->string);
+            }
+        }
+    }
+    free(undo.entries);
+
+    return err;
+}
+
 static void cJSONUtils_GeneratePatch(cJSON *patches, const char *op, const char *path, const char *suffix, cJSON *val)
 {
     cJSON *patch = cJSON_CreateObject();
@@ -524,7 +1506,456 @@ void cJSONUtils_AddPatchToArray(cJSON *array, const char *op, const char *path,
     cJSONUtils_GeneratePatch(array, op, path, 0, val);
 }
 
-static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *from, cJSON *to)
+/* one step of an array edit script: from and to are both set for an element that is kept, otherwise it is a deletion
+ * (to < 0) or an insertion (from < 0) */
+typedef struct
+{
+    int from;
+    int to;
+    int pair; /* the matching insertion/deletion of an element that is moved or modified, -1 if there is none */
+    int keeps; /* number of kept elements before this step */
+    int anchor; /* first element of from that stays where it is at or after this step, -1 for the end */
+} cJSONUtils_Edit;
+
+static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *from, cJSON *to, int max_edits);
+
+/* write the array index after the "path/" prefix of buffer, "-" for the end of the array */
+static char *cJSONUtils_IndexPath(char *buffer, size_t prefix_length, int index)
+{
+    char digits[24];
+    char *end = buffer + prefix_length;
+    int length = 0;
+    if (index < 0)
+    {
+        *end++ = '-';
+    }
+    else
+    {
+        do
+        {
+            digits[length++] = (char)('0' + (index % 10));
+            index /= 10;
+        } while (index > 0);
+        while (length > 0)
+        {
+            *end++ = digits[--length];
+        }
+    }
+    *end = '\0';
+
+    return buffer;
+}
+
+static void cJSONUtils_GenerateMove(cJSON *patches, const char *from, const char *path)
+{
+    cJSON *patch = cJSON_CreateObject();
+    cJSON_AddItemToObject(patch, "op", cJSON_CreateString("move"));
+    cJSON_AddItemToObject(patch, "from", cJSON_CreateString(from));
+    cJSON_AddItemToObject(patch, "path", cJSON_CreateString(path));
+    cJSON_AddItemToArray(patches, patch);
+}
+
+/* Myers' greedy diff of a[0..n) and b[0..m), written to script (room for n + m steps) with indices starting at offset.
+ * Returns the number of steps, or -1 if it needs more than max_edits insertions and deletions (or memory). */
+static int cJSONUtils_Myers(const cJSONUtils_uint64 *a, int n, const cJSONUtils_uint64 *b, int m, int offset, int max_edits, cJSONUtils_Edit *script)
+{
+    /* furthest x on diagonal k after d edits is at trace[d * d + d + k] */
+    int *trace = NULL;
+    int *previous = NULL;
+    int *v = NULL;
+    int found = 0;
+    int d = 0;
+    int k = 0;
+    int x = 0;
+    int y = 0;
+    int steps = 0;
+    int position = 0;
+
+    if (max_edits > (n + m))
+    {
+        max_edits = n + m;
+    }
+    trace = (int*)malloc(sizeof(int) * (size_t)(max_edits + 1) * (size_t)(max_edits + 1));
+    if (!trace)
+    {
+        return -1;
+    }
+
+    for (d = 0; (d <= max_edits) && !found; d++)
+    {
+        v = trace + (d * d) + d;
+        previous = trace + ((d - 1) * (d - 1)) + (d - 1);
+        for (k = -d; k <= d; k += 2)
+        {
+            if (d == 0)
+            {
+                x = 0;
+            }
+            else if ((k == -d) || ((k != d) && (previous[k - 1] < previous[k + 1])))
+            {
+                /* insertion */
+                x = previous[k + 1];
+            }
+            else
+            {
+                /* deletion */
+                x = previous[k - 1] + 1;
+            }
+            for (y = x - k; (x < n) && (y < m) && (a[x] == b[y]); x++, y++)
+            {
+            }
+            v[k] = x;
+            if ((x >= n) && (y >= m))
+            {
+                found = 1;
+                break;
+            }
+        }
+    }
+    if (!found)
+    {
+        free(trace);
+        return -1;
+    }
+    d--;
+
+    /* walk back from the end, filling the script from its end */
+    steps = (n + m + d) / 2;
+    position = steps;
+    x = n;
+    y = m;
+    for (; d > 0; d--)
+    {
+        int insertion = 0;
+        int start = 0;
+        previous = trace + ((d - 1) * (d - 1)) + (d - 1);
+        insertion = (k == -d) || ((k != d) && (previous[k - 1] < previous[k + 1]));
+        k = insertion ? (k + 1) : (k - 1);
+        start = previous[k] + (insertion ? 0 : 1);
+        for (; x > start; position--)
+        {
+            x--;
+            y--;
+            script[position - 1].from = offset + x;
+            script[position - 1].to = offset + y;
+        }
+        position--;
+        if (insertion)
+        {
+            y--;
+            script[position].from = -1;
+            script[position].to = offset + y;
+        }
+        else
+        {
+            x--;
+            script[position].from = offset + x;
+            script[position].to = -1;
+        }
+    }
+    for (; x > 0; position--)
+    {
+        x--;
+        y--;
+        script[position - 1].from = offset + x;
+        script[position - 1].to = offset + y;
+    }
+    free(trace);
+
+    return steps;
+}
+
+/* index of element id of from in the tracked array, searching from position */
+static int cJSONUtils_FindIndex(const int *current, int count, int position, int id)
+{
+    for (; position < count; position++)
+    {
+        if (current[position] == id)
+        {
+            return position;
+        }
+    }
+
+    return -1;
+}
+
+static void cJSONUtils_TrackMove(int *current, int from, int to)
+{
+    int id = current[from];
+    if (from < to)
+    {
+        memmove(current + from, current + from + 1, sizeof(int) * (size_t)(to - from));
+    }
+    else
+    {
+        memmove(current + to + 1, current + to, sizeof(int) * (size_t)(from - to));
+    }
+    current[to] = id;
+}
+
+/* Diffs two arrays into add/remove/move operations: common prefix and suffix are trimmed, the rest goes through
+ * Myers' algorithm on the hashes of the elements (or by index if that needs more than max_edits). Deleted elements
+ * equal to inserted ones become moves, other deletions and insertions next to each other are diffed recursively.
+ * The patches are emitted while tracking where the original elements are, so the indices are always right.
+ * Returns 0 if it is out of memory before having emitted anything. */
+static int cJSONUtils_CompareArraysToPatch(cJSON *patches, const char *path, cJSON *from, cJSON *to, int max_edits)
+{
+    int n = cJSON_GetArraySize(from);
+    int m = cJSON_GetArraySize(to);
+    size_t total = (size_t)n + (size_t)m;
+    size_t prefix_length = strlen(path) + 1;
+    cJSONUtils_uint64 *hashes = NULL;
+    cJSON **items = NULL;
+    cJSONUtils_Edit *script = NULL;
+    int *current = NULL;
+    char *newpath = NULL;
+    char *frompath = NULL;
+    cJSON *item = NULL;
+    int prefix = 0;
+    int suffix = 0;
+    int middle = -1;
+    int steps = 0;
+    int count = n;
+    int position = 0;
+    int q = 0;
+    int r = 0;
+    int keeps = 0;
+    int anchor = -1;
+    int moves = 0;
+
+    if (total == 0)
+    {
+        return 1;
+    }
+    /* hashes, items, script and tracked indices in one allocation */
+    hashes = (cJSONUtils_uint64*)malloc(total * (sizeof(cJSONUtils_uint64) + sizeof(cJSON*) + sizeof(cJSONUtils_Edit) + sizeof(int)));
+    newpath = (char*)malloc(2 * (prefix_length + 23));
+    if (!hashes || !newpath)
+    {
+        free(hashes);
+        free(newpath);
+        return 0;
+    }
+    items = (cJSON**)(hashes + total);
+    script = (cJSONUtils_Edit*)(items + total);
+    current = (int*)(script + total);
+    frompath = newpath + prefix_length + 23;
+    sprintf(newpath, "%s/", path);
+    memcpy(frompath, newpath, prefix_length);
+
+    for (q = 0, item = from->child; item; item = item->next, q++)
+    {
+        items[q] = item;
+        hashes[q] = cJSONUtils_HashUncached(NULL, item);
+        current[q] = q;
+    }
+    for (item = to->child; item; item = item->next, q++)
+    {
+        items[q] = item;
+        hashes[q] = cJSONUtils_HashUncached(NULL, item);
+    }
+
+    for (; (prefix < n) && (prefix < m) && (hashes[prefix] == hashes[n + prefix]); prefix++)
+    {
+        script[prefix].from = prefix;
+        script[prefix].to = prefix;
+    }
+    for (; (suffix < (n - prefix)) && (suffix < (m - prefix)) && (hashes[n - suffix - 1] == hashes[n + m - suffix - 1]); suffix++)
+    {
+    }
+    if (max_edits > 0)
+    {
+        middle = cJSONUtils_Myers(hashes + prefix, n - prefix - suffix, hashes + n + prefix, m - prefix - suffix, prefix, max_edits, script + prefix);
+        moves = (middle >= 0);
+    }
+    if (middle < 0)
+    {
+        /* too many changes, compare by index */
+        middle = 0;
+        for (q = prefix; q < (n - suffix); q++, middle++)
+        {
+            script[prefix + middle].from = q;
+            script[prefix + middle].to = -1;
+        }
+        for (q = prefix; q < (m - suffix); q++, middle++)
+        {
+            script[prefix + middle].from = -1;
+            script[prefix + middle].to = q;
+        }
+    }
+    steps = prefix + middle;
+    for (q = 0; q < suffix; q++, steps++)
+    {
+        script[steps].from = n - suffix + q;
+        script[steps].to = m - suffix + q;
+    }
+    for (q = 0; q < steps; q++)
+    {
+        script[q].pair = -1;
+    }
+
+    /* deleted elements that are inserted elsewhere are moved (only with a bounded number of edits) */
+    for (q = prefix; moves && (q < (prefix + middle)); q++)
+    {
+        if (script[q].to >= 0)
+        {
+            continue;
+        }
+        for (r = prefix; r < (prefix + middle); r++)
+        {
+            if ((script[r].from < 0) && (script[r].pair < 0) && (hashes[script[q].from] == hashes[n + script[r].to]))
+            {
+                script[q].pair = r;
+                script[r].pair = q;
+                break;
+            }
+        }
+    }
+    /* pair up the remaining deletions and insertions between two kept elements */
+    for (q = prefix; q < (prefix + middle); q = r)
+    {
+        int deletion = q;
+        int insertion = q;
+        for (r = q; (r < (prefix + middle)) && ((script[r].from < 0) || (script[r].to < 0)); r++)
+        {
+        }
+        if (r == q)
+        {
+            r++;
+            continue;
+        }
+        for (;;)
+        {
+            for (; (deletion < r) && ((script[deletion].to >= 0) || (script[deletion].pair >= 0)); deletion++)
+            {
+            }
+            for (; (insertion < r) && ((script[insertion].from >= 0) || (script[insertion].pair >= 0)); insertion++)
+            {
+            }
+            if ((deletion >= r) || (insertion >= r))
+            {
+                break;
+            }
+            script[deletion].pair = insertion;
+            script[insertion].pair = deletion;
+        }
+    }
+    for (q = 0; q < steps; q++)
+    {
+        script[q].keeps = keeps;
+        keeps += ((script[q].from >= 0) && (script[q].to >= 0)) ? 1 : 0;
+    }
+    for (q = steps - 1; q >= 0; q--)
+    {
+        if ((script[q].from >= 0) && ((script[q].to >= 0) || (script[q].pair < 0)))
+        {
+            anchor = script[q].from;
+        }
+        script[q].anchor = anchor;
+    }
+
+    for (q = 0; q < steps; q++)
+    {
+        const cJSONUtils_Edit *edit = script + q;
+        int source = (edit->from >= 0) ? edit->from : ((edit->pair >= 0) ? script[edit->pair].from : -1);
+        int index = (source >= 0) ? cJSONUtils_FindIndex(current, count, position, source) : -1;
+        if (edit->to < 0)
+        {
+            if (edit->pair < 0)
+            {
+                cJSONUtils_GeneratePatch(patches, "remove", cJSONUtils_IndexPath(newpath, prefix_length, index), 0, 0);
+                memmove(current + index, current + index + 1, sizeof(int) * (size_t)(count - index - 1));
+                count--;
+            }
+            else if ((edit->pair > q) && (script[edit->pair].keeps > edit->keeps))
+            {
+                /* moved further back: put it before the element that will follow it */
+                int target = (script[edit->pair].anchor >= 0) ? cJSONUtils_FindIndex(current, count, position, script[edit->pair].anchor) : -1;
+                /* index after removing the element */
+                target = (target < 0) ? (count - 1) : (target - ((target > index) ? 1 : 0));
+                if (target != index)
+                {
+                    cJSONUtils_GenerateMove(patches, cJSONUtils_IndexPath(frompath, prefix_length, index), cJSONUtils_IndexPath(newpath, prefix_length, (target == (count - 1)) ? -1 : target));
+                    cJSONUtils_TrackMove(current, index, target);
+                }
+            }
+            continue;
+        }
+
+        if (index < 0)
+        {
+            /* a new element */
+            cJSONUtils_GeneratePatch(patches, "add", cJSONUtils_IndexPath(newpath, prefix_length, (position == count) ? -1 : position), 0, items[n + edit->to]);
+            memmove(current + position + 1, current + position, sizeof(int) * (size_t)(count - position));
+            current[position] = -1;
+            count++;
+        }
+        else
+        {
+            if (index != position)
+            {
+                cJSONUtils_GenerateMove(patches, cJSONUtils_IndexPath(frompath, prefix_length, index), cJSONUtils_IndexPath(newpath, prefix_length, position));
+                cJSONUtils_TrackMove(current, index, position);
+            }
+            if (cJSONUtils_Compare(items[source], items[n + edit->to]))
+            {
+                cJSONUtils_CompareToPatch(patches, cJSONUtils_IndexPath(newpath, prefix_length, position), items[source], items[n + edit->to], max_edits);
+            }
+        }
+        position++;
+    }
+
+    free(hashes);
+    free(newpath);
+
+    return 1;
+}
+
+/* Diffs two objects without sorting them: the members are matched by key (through temporary tables for big objects,
+ * like cJSONUtils_Compare), members of from that aren't in to are removed and those only in to are added. */
+static void cJSONUtils_CompareObjectsToPatch(cJSON *patches, const char *path, cJSON *from, cJSON *to, int max_edits)
+{
+    cJSON **from_table = NULL;
+    cJSON **to_table = NULL;
+    size_t from_size = 0;
+    size_t to_size = 0;
+    cJSON *member = NULL;
+    cJSON *other = NULL;
+    int from_count = cJSON_GetArraySize(from);
+    int to_count = cJSON_GetArraySize(to);
+
+    from_table = (from_count >= CJSONUTILS_COMPARE_TABLE_MIN) ? cJSONUtils_KeyTable(from, (size_t)from_count, &from_size) : NULL;
+    to_table = (to_count >= CJSONUTILS_COMPARE_TABLE_MIN) ? cJSONUtils_KeyTable(to, (size_t)to_count, &to_size) : NULL;
+    for (member = from->child; member; member = member->next)
+    {
+        other = cJSONUtils_FindKey(to_table, to_size, to, member->string);
+        if (!other)
+        {
+            /* object element doesn't exist in 'to' --> remove it */
+            cJSONUtils_GeneratePatch(patches, "remove", path, member->string, 0);
+        }
+        else if (cJSONUtils_FindKey(from_table, from_size, from, member->string) == member)
+        {
+            /* both object keys are the same (only the first of duplicate keys is reachable by a pointer) */
+            char *newpath = (char*)malloc(strlen(path) + cJSONUtils_PointerEncodedstrlen(member->string) + 2);
+            cJSONUtils_PointerEncodedstrcpy(newpath + sprintf(newpath, "%s/", path), member->string);
+            cJSONUtils_CompareToPatch(patches, newpath, member, other, max_edits);
+            free(newpath);
+        }
+    }
+    for (member = to->child; member; member = member->next)
+    {
+        if (!cJSONUtils_FindKey(from_table, from_size, from, member->string))
+        {
+            /* object element doesn't exist in 'from' --> add it */
+            cJSONUtils_GeneratePatch(patches, "add", path, member->string, member);
+        }
+    }
+    free(from_table);
+    free(to_table);
+}
+
+static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *from, cJSON *to, int max_edits)
 {
     if ((from->type & 0xFF) != (to->type & 0xFF))
     {
@@ -535,7 +1966,9 @@ static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *f
     switch ((from->type & 0xFF))
     {
         case cJSON_Number:
-            if ((from->valueint != to->valueint) || (from->valuedouble != to->valuedouble))
+            if ((cJSONUtils_IsInt64(from) && cJSONUtils_IsInt64(to))
+                    ? (from->valueint64 != to->valueint64)
+                    : ((from->valueint != to->valueint) || (from->valuedouble != to->valuedouble)))
             {
                 cJSONUtils_GeneratePatch(patches, "replace", path, 0, to);
             }
@@ -551,18 +1984,26 @@ static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *f
         case cJSON_Array:
         {
             int c = 0;
-            char *newpath = (char*)malloc(strlen(path) + 23); /* Allow space for 64bit int. */
+            size_t prefix_length = strlen(path) + 1;
+            char *newpath = NULL;
+            cJSON_Materialize(from);
+            cJSON_Materialize(to);
+            if ((max_edits >= 0) && cJSONUtils_CompareArraysToPatch(patches, path, from, to, max_edits))
+            {
+                return;
+            }
+            newpath = (char*)malloc(prefix_length + 23); /* Allow space for 64bit int. */
+            sprintf(newpath, "%s/", path);
             /* generate patches for all array elements that exist in "from" and "to" */
             for (c = 0, from = from->child, to = to->child; from && to; from = from->next, to = to->next, c++)
             {
-                sprintf(newpath, "%s/%d", path, c); /* path of the current array element */
-                cJSONUtils_CompareToPatch(patches, newpath, from, to);
+                /* path of the current array element */
+                cJSONUtils_CompareToPatch(patches, cJSONUtils_IndexPath(newpath, prefix_length, c), from, to, max_edits);
             }
             /* remove leftover elements from 'from' that are not in 'to' */
             for (; from; from = from->next, c++)
             {
-                sprintf(newpath, "%d", c);
-                cJSONUtils_GeneratePatch(patches, "remove", path, newpath, 0);
+                cJSONUtils_GeneratePatch(patches, "remove", cJSONUtils_IndexPath(newpath, prefix_length, c), 0, 0);
             }
             /* add new elements in 'to' that were not in 'from' */
             for (; to; to = to->next, c++)
@@ -577,6 +2018,25 @@ static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *f
         {
             cJSON *a = NULL;
             cJSON *b = NULL;
+            if (max_edits >= 0)
+            {
+                /* cJSONUtils_GenerateMinimalPatches leaves its inputs as they are */
+                cJSONUtils_CompareObjectsToPatch(patches, path, from, to, max_edits);
+                return;
+            }
+            if ((from->type | to->type) & cJSON_IsImmutable)
+            {
+                /* frozen objects can't be sorted, diff copies of them */
+                a = cJSON_Duplicate(from, 1);
+                b = cJSON_Duplicate(to, 1);
+                if (a && b)
+                {
+                    cJSONUtils_CompareToPatch(patches, path, a, b, max_edits);
+                }
+                cJSON_Delete(a);
+                cJSON_Delete(b);
+                return;
+            }
             cJSONUtils_SortObject(from);
             cJSONUtils_SortObject(to);
 
@@ -592,7 +2052,7 @@ static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *f
                     char *newpath = (char*)malloc(strlen(path) + cJSONUtils_PointerEncodedstrlen(a->string) + 2);
                     cJSONUtils_PointerEncodedstrcpy(newpath + sprintf(newpath, "%s/", path), a->string);
                     /* create a patch for the element */
-                    cJSONUtils_CompareToPatch(patches, newpath, a, b);
+                    cJSONUtils_CompareToPatch(patches, newpath, a, b, max_edits);
                     free(newpath);
                     a = a->next;
                     b = b->next;
@@ -621,7 +2081,15 @@ static void cJSONUtils_CompareToPatch(cJSON *patches, const char *path, cJSON *f
 cJSON* cJSONUtils_GeneratePatches(cJSON *from, cJSON *to)
 {
     cJSON *patches = cJSON_CreateArray();
-    cJSONUtils_CompareToPatch(patches, "", from, to);
+    cJSONUtils_CompareToPatch(patches, "", from, to, -1);
+
+    return patches;
+}
+
+cJSON *cJSONUtils_GenerateMinimalPatches(cJSON *from, cJSON *to, int max_edits)
+{
+    cJSON *patches = cJSON_CreateArray();
+    cJSONUtils_CompareToPatch(patches, "", from, to, (max_edits < 0) ? 0 : max_edits);
 
     return patches;
 }
@@ -735,7 +2203,15 @@ static cJSON *cJSONUtils_SortList(cJSON *list)
 
 void cJSONUtils_SortObject(cJSON *object)
 {
+    if (!cJSON_Unshare(object))
+    {
+        /* part of a frozen shared tree */
+        return;
+    }
+    cJSON_Materialize(object);
     object->child = cJSONUtils_SortList(object->child);
+    /* the order of the children changed behind cJSON's back */
+    cJSON_InvalidateIndex(object);
 }
 
 cJSON* cJSONUtils_MergePatch(cJSON *target, cJSON *patch)
@@ -753,6 +2229,7 @@ cJSON* cJSONUtils_MergePatch(cJSON *target, cJSON *patch)
         target = cJSON_CreateObject();
     }
 
+    cJSON_Materialize(patch);
     patch = patch->child;
     while (patch)
     {
@@ -783,6 +2260,16 @@ cJSON *cJSONUtils_GenerateMergePatch(cJSON *from, cJSON *to)
     {
         return cJSON_Duplicate(to, 1);
     }
+    if ((from->type | to->type) & cJSON_IsImmutable)
+    {
+        /* frozen objects can't be sorted, diff copies of them */
+        cJSON *from_copy = cJSON_Duplicate(from, 1);
+        cJSON *to_copy = cJSON_Duplicate(to, 1);
+        patch = (from_copy && to_copy) ? cJSONUtils_GenerateMergePatch(from_copy, to_copy) : NULL;
+        cJSON_Delete(from_copy);
+        cJSON_Delete(to_copy);
+        return patch;
+    }
 
     cJSONUtils_SortObject(from);
     cJSONUtils_SortObject(to);
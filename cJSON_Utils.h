@@ -3,33 +3,35 @@
 /* Implement RFC6901 (https://tools.ietf.org/html/rfc6901) JSON Pointer spec. */
 cJSON *cJSONUtils_GetPointer(cJSON *object, const char *pointer);
 
+/* A pointer decoded once (with hashed keys and parsed array indices) for evaluating it many times. Gives the same
+ * results as cJSONUtils_GetPointer; returns NULL for malformed pointers (not starting with '/', invalid '~' escapes)
+ * or when out of memory. */
+typedef struct cJSONUtils_Pointer cJSONUtils_Pointer;
+cJSONUtils_Pointer *cJSONUtils_CompilePointer(const char *pointer);
+void cJSONUtils_DeletePointer(cJSONUtils_Pointer *pointer);
+cJSON *cJSONUtils_GetCompiledPointer(cJSON *object, const cJSONUtils_Pointer *pointer);
+/* Resolve count compiled pointers in one traversal: pointers with a common prefix share its lookups, and objects or
+ * arrays where many different tokens are followed are walked once. results[i] is what pointers[i] points to (NULL if
+ * nothing, or if pointers[i] is NULL). Returns 0 when out of memory. */
+int cJSONUtils_GetPointers(cJSON *object, const cJSONUtils_Pointer * const *pointers, int count, cJSON **results);
+
 /* Implement RFC6902 (https://tools.ietf.org/html/rfc6902) JSON Patch spec. */
 cJSON* cJSONUtils_GeneratePatches(cJSON *from, cJSON *to);
+/* Like cJSONUtils_GeneratePatches, but arrays are diffed with Myers' algorithm into near minimal add/remove/move
+ * operations (changed elements are still diffed recursively). The search is bounded by max_edits insertions and
+ * deletions per array, its memory grows with the square of that; arrays that differ more are compared by index.
+ * Unlike cJSONUtils_GeneratePatches it doesn't sort the members of from and to, neither tree is modified. */
+cJSON *cJSONUtils_GenerateMinimalPatches(cJSON *from, cJSON *to, int max_edits);
 /* Utility for generating patch array entries. */
 void cJSONUtils_AddPatchToArray(cJSON *array, const char *op, const char *path, cJSON *val);
-/* Returns 0 for success. */
+/* Returns 0 for success. Shared items (see cJSON_Share) on the way to a change are unshared; 11 if one can't be
+ * (the path leads into a frozen item, or out of memory). */
 int cJSONUtils_ApplyPatches(cJSON *object, cJSON *patches);
 
-/*
-// Note that ApplyPatches is NOT atomic on failure. To implement an atomic ApplyPatches, use:
-//int cJSONUtils_AtomicApplyPatches(cJSON **object, cJSON *patches)
-//{
-//    cJSON *modme = cJSON_Duplicate(*object, 1);
-//    int error = cJSONUtils_ApplyPatches(modme, patches);
-//    if (!error)
-//    {
-//        cJSON_Delete(*object);
-//        *object = modme;
-//    }
-//    else
-//    {
-//        cJSON_Delete(modme);
-//    }
-//
-//    return error;
-//}
-// Code not added to library since this strategy is a LOT slower.
-*/
+/* Note that ApplyPatches is NOT atomic on failure. AtomicApplyPatches is: it logs every item it detaches or adds
+ * and on failure undoes the changes in reverse order, so object is left as it was, without copying it. Returns the
+ * same codes (10 when out of memory for the log). */
+int cJSONUtils_AtomicApplyPatches(cJSON *object, cJSON *patches);
 
 /* Implement RFC7386 (https://tools.ietf.org/html/rfc7396) JSON Merge Patch spec. */
 /* target will be modified by patch. return value is new ptr for target. */
@@ -40,5 +42,28 @@ cJSON *cJSONUtils_GenerateMergePatch(cJSON *from, cJSON *to);
 /* Given a root object and a target object, construct a pointer from one to the other. */
 char *cJSONUtils_FindPointerFromObjectTo(cJSON *object, cJSON *target);
 
+/* The parent and position of every item of a tree, built in one pass, so cJSONUtils_FindPointerFromIndex finds the
+ * pointer to an item in O(depth) instead of searching the whole tree. The index is keyed by item address and doesn't
+ * follow changes to the tree: rebuild it after modifying the tree. */
+typedef struct cJSONUtils_PathIndex cJSONUtils_PathIndex;
+cJSONUtils_PathIndex *cJSONUtils_BuildPathIndex(const cJSON *root);
+void cJSONUtils_DeletePathIndex(cJSONUtils_PathIndex *index);
+/* Same result as cJSONUtils_FindPointerFromObjectTo(root, target), NULL if target isn't in the indexed tree. */
+char *cJSONUtils_FindPointerFromIndex(const cJSONUtils_PathIndex *index, const cJSON *target);
+
 /* Sorts the members of the object into alphabetical order. */
 void cJSONUtils_SortObject(cJSON *object);
+
+/* Structural equality, 1 if equal. Keys are compared case insensitively and the order of object members doesn't
+ * matter. Neither tree is modified (the "test" patch operation uses this too). */
+int cJSONUtils_Equal(const cJSON *a, const cJSON *b);
+
+/* Hashes of every subtree of a tree, for comparing subtrees in O(1). The table is keyed by item address, so it is
+ * stale once the tree changes. */
+typedef struct cJSONUtils_Hashes cJSONUtils_Hashes;
+cJSONUtils_Hashes *cJSONUtils_HashTree(const cJSON *root);
+void cJSONUtils_DeleteHashes(cJSONUtils_Hashes *hashes);
+/* 1 if the subtrees have the same 64 bit hash (with the semantics of cJSONUtils_Equal). Equal trees always match,
+ * different ones only collide with negligible probability; confirm with cJSONUtils_Equal if that matters.
+ * Items that aren't in their table (or a NULL table) are hashed on the fly. */
+int cJSONUtils_EqualHashed(const cJSONUtils_Hashes *hashes_a, const cJSON *a, const cJSONUtils_Hashes *hashes_b, const cJSON *b);
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "cJSON.h"
 
 /* Parse text to JSON, then render back to text, and print! */
@@ -76,6 +77,1576 @@ static void dofile(char *filename)
 }
 #endif
 
+/* For the checks of the newer functions below: print what failed and give up. */
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Check failed: %s\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* item has to print (unformatted) as expected */
+static void check_print(const cJSON *item, const char *expected, const char *what)
+{
+    char *out = cJSON_PrintUnformatted(item);
+    check(out != NULL, what);
+    if (strcmp(out, expected) != 0)
+    {
+        printf("Expected: %s\nGot:      %s\n", expected, out);
+        free(out);
+        check(0, what);
+    }
+    free(out);
+}
+
+/* Trees parsed into an arena are freed all at once. */
+static void arena_tests(void)
+{
+    cJSON_Arena *arena = cJSON_CreateArena(64);
+    cJSON_Allocator allocator;
+    cJSON *root = NULL;
+    cJSON *item = NULL;
+    int i = 0;
+
+    check(arena != NULL, "cJSON_CreateArena");
+    for (i = 0; i < 3; i++)
+    {
+        /* bigger than a chunk, and the chunk is reused after a reset */
+        root = cJSON_ParseWithArena("{\"name\": \"a string that is longer than one chunk of the arena\", \"list\": [1, 2, 3]}", arena);
+        check(root != NULL, "cJSON_ParseWithArena");
+        check_print(root, "{\"name\":\"a string that is longer than one chunk of the arena\",\"list\":[1,2,3]}", "arena tree");
+        cJSON_ArenaReset(arena);
+    }
+    check(cJSON_ParseWithArena("[1, 2", arena) == NULL, "cJSON_ParseWithArena of invalid JSON");
+
+    /* the items made with the arena allocator are released with the arena too */
+    cJSON_GetArenaAllocator(arena, &allocator);
+    root = cJSON_CreateObjectWithAllocator(&allocator);
+    item = cJSON_CreateStringWithAllocator("value", &allocator);
+    check((root != NULL) && (item != NULL), "cJSON_Create*WithAllocator with an arena");
+    cJSON_AddItemToObjectWithAllocator(root, "key", item, &allocator);
+    check_print(root, "{\"key\":\"value\"}", "arena items");
+    cJSON_DeleteArena(arena);
+}
+
+/* An allocator that counts the blocks it hands out, through its context. */
+static void *counting_malloc(void *context, size_t size)
+{
+    ++*(int*)context;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *context, void *pointer, size_t size)
+{
+    if (pointer == NULL)
+    {
+        ++*(int*)context;
+    }
+    return realloc(pointer, size);
+}
+
+static void counting_free(void *context, void *pointer)
+{
+    --*(int*)context;
+    free(pointer);
+}
+
+/* Everything a tree made with an allocator holds goes back to it. */
+static void allocator_tests(void)
+{
+    int blocks = 0;
+    cJSON_Allocator allocator;
+    cJSON_Allocator broken;
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *root = NULL;
+    cJSON *copy = NULL;
+    char *out = NULL;
+
+    allocator.context = &blocks;
+    allocator.malloc_fn = counting_malloc;
+    allocator.realloc_fn = counting_realloc;
+    allocator.free_fn = counting_free;
+
+    root = cJSON_ParseWithAllocator("{\"a\": [1, \"two\"], \"b\": {\"c\": null}}", NULL, 1, &allocator);
+    check((root != NULL) && (blocks > 0), "cJSON_ParseWithAllocator");
+    cJSON_AddItemToObjectWithAllocator(root, "d", cJSON_CreateNumberWithAllocator(4, &allocator), &allocator);
+    copy = cJSON_DuplicateWithAllocator(root, 1, &allocator);
+    out = cJSON_PrintWithAllocator(copy, 0, &allocator);
+    check((out != NULL) && !strcmp(out, "{\"a\":[1,\"two\"],\"b\":{\"c\":null},\"d\":4}"), "cJSON_PrintWithAllocator");
+    counting_free(&blocks, out);
+    cJSON_DeleteWithAllocator(copy, &allocator);
+    cJSON_DeleteWithAllocator(root, &allocator);
+    check(blocks == 0, "trees made with an allocator give all of their memory back");
+
+    /* realloc_fn is optional */
+    allocator.realloc_fn = NULL;
+    root = cJSON_CreateArrayWithAllocator(&allocator);
+    cJSON_AddItemToArray(root, cJSON_CreateStringWithAllocator("a string long enough to make the print buffer grow a few times over", &allocator));
+    out = cJSON_PrintWithAllocator(root, 1, &allocator);
+    check(out != NULL, "cJSON_PrintWithAllocator without realloc_fn");
+    counting_free(&blocks, out);
+    cJSON_DeleteWithAllocator(root, &allocator);
+    check(blocks == 0, "printing without realloc_fn gives all of its memory back");
+
+    /* an allocator needs malloc_fn and free_fn */
+    broken = allocator;
+    broken.free_fn = NULL;
+    memset(&options, '\0', sizeof(options));
+    options.allocator = &broken;
+    check(cJSON_ParseWithOptions("[]", &options, &error) == NULL, "parsing with an allocator without free_fn");
+    check(error.code == cJSON_Error_InvalidArgument, "an allocator without free_fn is an invalid argument");
+}
+
+/* Where and why parsing fails is reported through the caller's cJSON_ParseError. */
+static void parse_error_tests(void)
+{
+    struct
+    {
+        const char *json;
+        int require_null_terminated;
+        int code;
+        size_t position;
+        int line;
+        int column;
+    } cases[] =
+    {
+        {"[1, 2,\n  x]", 0, cJSON_Error_InvalidValue, 9, 2, 3},
+        {"{\"a\" 1}", 0, cJSON_Error_ExpectedColon, 5, 1, 6},
+        {"{1:2}", 0, cJSON_Error_InvalidString, 1, 1, 2},
+        {"\"\\q\"", 0, cJSON_Error_InvalidEscape, 0, 1, 1},
+        {"\"\\ud800\"", 0, cJSON_Error_InvalidUnicode, 0, 1, 1},
+        {"[1 2]", 0, cJSON_Error_UnterminatedArray, 3, 1, 4},
+        {"{\"a\":1 \"b\"}", 0, cJSON_Error_UnterminatedObject, 7, 1, 8},
+        {"[1] x", 1, cJSON_Error_TrailingGarbage, 4, 1, 5},
+        /* on success, the end of the value */
+        {"[1] x", 0, cJSON_Error_None, 3, 1, 4},
+        {"  [1]  ", 1, cJSON_Error_None, 7, 1, 8}
+    };
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *root = NULL;
+    const char *legacy_error = NULL;
+    size_t i = 0;
+
+    memset(&options, '\0', sizeof(options));
+    for (i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++)
+    {
+        options.require_null_terminated = cases[i].require_null_terminated;
+        root = cJSON_ParseWithOptions(cases[i].json, &options, &error);
+        check((root != NULL) == (cases[i].code == cJSON_Error_None), cases[i].json);
+        check(error.code == cases[i].code, cases[i].json);
+        check(error.position == cases[i].position, cases[i].json);
+        check((error.line == cases[i].line) && (error.column == cases[i].column), cases[i].json);
+        cJSON_Delete(root);
+    }
+
+    check(cJSON_ParseWithOptions(NULL, NULL, &error) == NULL, "cJSON_ParseWithOptions(NULL)");
+    check(error.code == cJSON_Error_InvalidArgument, "NULL input is an invalid argument");
+    check(cJSON_ParseWithOptions("[", NULL, NULL) == NULL, "cJSON_ParseWithOptions without an error struct");
+
+    /* the global error pointer is left alone */
+    check(cJSON_Parse("[x") == NULL, "cJSON_Parse of invalid JSON");
+    legacy_error = cJSON_GetErrorPtr();
+    check(cJSON_ParseWithOptions("[y", NULL, &error) == NULL, "cJSON_ParseWithOptions of invalid JSON");
+    check(cJSON_GetErrorPtr() == legacy_error, "cJSON_ParseWithOptions doesn't set the global error pointer");
+}
+
+/* Lookups through the hash index of an object find what a walk of the list would. */
+static void object_index_tests(void)
+{
+    cJSON_ParseOptions options;
+    cJSON *root = cJSON_CreateObject();
+    cJSON *item = NULL;
+    char key[16];
+    int i = 0;
+
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(key, "Key%d", i);
+        cJSON_AddNumberToObject(root, key, i);
+    }
+    check(cJSON_EnableIndex(root) && (root->index != NULL), "cJSON_EnableIndex");
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(key, "key%d", i);
+        item = cJSON_GetObjectItem(root, key);
+        check((item != NULL) && (item->valueint == i), "case insensitive lookup through the index");
+        check(cJSON_GetObjectItemCaseSensitive(root, key) == NULL, "case sensitive lookup through the index");
+        key[0] = 'K';
+        check(cJSON_GetObjectItemCaseSensitive(root, key) == item, "case sensitive lookup of the exact key");
+    }
+    check(!cJSON_HasObjectItem(root, "key100"), "lookup of a missing key");
+
+    /* the index follows changes */
+    cJSON_DeleteItemFromObject(root, "key50");
+    check(!cJSON_HasObjectItem(root, "key50") && (cJSON_GetArraySize(root) == 99), "lookup after a delete");
+    cJSON_ReplaceItemInObject(root, "key51", cJSON_CreateString("replaced"));
+    check_print(cJSON_GetObjectItem(root, "KEY51"), "\"replaced\"", "lookup after a replace");
+    cJSON_AddStringToObject(root, "added", "yes");
+    check_print(cJSON_GetObjectItem(root, "ADDED"), "\"yes\"", "lookup after an add");
+
+    /* and after changing the list by hand it is rebuilt */
+    item = cJSON_CreateTrue();
+    item->string = (char*)malloc(sizeof("manual"));
+    strcpy(item->string, "manual");
+    item->next = root->child;
+    root->child->prev = item;
+    root->child = item;
+    cJSON_InvalidateIndex(root);
+    check(cJSON_GetObjectItem(root, "Manual") == item, "lookup after cJSON_InvalidateIndex");
+
+    /* duplicate keys are looked up in the list */
+    cJSON_AddNumberToObject(root, "KEY1", 1000);
+    check(cJSON_GetObjectItem(root, "key1")->valueint == 1, "the first of duplicate keys is found");
+    check(cJSON_GetObjectItemCaseSensitive(root, "KEY1")->valueint == 1000, "case sensitive lookup of a duplicate key");
+
+    cJSON_DisableIndex(root);
+    check((root->index == NULL) && (cJSON_GetObjectItem(root, "key99")->valueint == 99), "lookup without the index");
+    cJSON_Delete(root);
+
+    /* big containers get their index while parsing */
+    memset(&options, '\0', sizeof(options));
+    options.index_threshold = 2;
+    root = cJSON_ParseWithOptions("{\"a\": {\"b\": 1, \"c\": 2}, \"d\": {\"e\": 3}}", &options, NULL);
+    check((root != NULL) && (root->index != NULL), "index_threshold");
+    check((cJSON_GetObjectItem(root, "a")->index != NULL) && (cJSON_GetObjectItem(root, "d")->index == NULL), "index_threshold of nested objects");
+    check(cJSON_GetObjectItem(cJSON_GetObjectItem(root, "a"), "C")->valueint == 2, "lookup in a parsed index");
+    cJSON_Delete(root);
+}
+
+/* Positions through the index of an array stay right while it changes. */
+static void array_index_tests(void)
+{
+    cJSON *array = cJSON_CreateArray();
+    cJSON *item = NULL;
+    int i = 0;
+
+    check(cJSON_EnableIndex(array), "cJSON_EnableIndex of an empty array");
+    for (i = 0; i < 1000; i++)
+    {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(i));
+    }
+    check(cJSON_GetArraySize(array) == 1000, "cJSON_GetArraySize through the index");
+    for (i = 0; i < 1000; i++)
+    {
+        check(cJSON_GetArrayItem(array, i)->valueint == i, "cJSON_GetArrayItem through the index");
+    }
+    check(cJSON_GetArrayItem(array, 1000) == NULL, "cJSON_GetArrayItem past the end");
+    /* like the list walk, positions below 0 are the first item */
+    check(cJSON_GetArrayItem(array, -1) == array->child, "cJSON_GetArrayItem below 0");
+
+    cJSON_InsertItemInArray(array, 0, cJSON_CreateNumber(-1));
+    cJSON_InsertItemInArray(array, 500, cJSON_CreateString("middle"));
+    check((cJSON_GetArrayItem(array, 0)->valueint == -1) && (cJSON_GetArrayItem(array, 1)->valueint == 0), "insert at the start");
+    check_print(cJSON_GetArrayItem(array, 500), "\"middle\"", "insert in the middle");
+    check(cJSON_GetArrayItem(array, 501)->valueint == 499, "positions after an insert");
+    item = cJSON_DetachItemFromArray(array, 500);
+    check_print(item, "\"middle\"", "detach from the middle");
+    cJSON_Delete(item);
+    cJSON_DeleteItemFromArray(array, 0);
+    cJSON_ReplaceItemInArray(array, 999, cJSON_CreateString("last"));
+    check(cJSON_GetArraySize(array) == 1000, "size after insert, detach and delete");
+    check((cJSON_GetArrayItem(array, 998)->valueint == 998) && (cJSON_GetArrayItem(array, 999)->type == cJSON_String), "positions after a replace");
+    cJSON_AddItemToArray(array, cJSON_CreateNull());
+    check(cJSON_GetArrayItem(array, 1000)->type == cJSON_NULL, "append after a replace at the end");
+
+    cJSON_DisableIndex(array);
+    check(cJSON_GetArrayItem(array, 999)->type == cJSON_String, "cJSON_GetArrayItem without the index");
+    cJSON_Delete(array);
+}
+
+/* Parse length bytes copied to a buffer of exactly that size, so reading past them is caught by memory checkers. */
+static cJSON *parse_exact(const char *json, size_t length, cJSON_ParseError *error)
+{
+    char *copy = (char*)malloc(length > 0 ? length : 1);
+    cJSON *root = NULL;
+    check(copy != NULL, "out of memory");
+    memcpy(copy, json, length);
+    root = cJSON_ParseWithLength(copy, length, NULL, error);
+    free(copy);
+
+    return root;
+}
+
+/* The vector scans of strings and whitespace, with what they look for at every offset of a block. */
+static void scan_tests(void)
+{
+    char json[256];
+    char expected[256];
+    cJSON_ParseError error;
+    cJSON *root = NULL;
+    size_t length = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    for (i = 0; i < 40; i++)
+    {
+        /* a string of i letters, an escape, i letters again, whitespace before and after */
+        length = 0;
+        for (j = 0; j < i; j++)
+        {
+            json[length++] = (j % 3) ? ' ' : '\n';
+        }
+        json[length++] = '\"';
+        for (j = 0; j < i; j++)
+        {
+            json[length++] = (char)('a' + (j % 26));
+        }
+        json[length++] = '\\';
+        json[length++] = 't';
+        for (j = 0; j < i; j++)
+        {
+            json[length++] = (char)('A' + (j % 26));
+        }
+        json[length++] = '\"';
+        for (j = 0; j < i; j++)
+        {
+            json[length++] = '\t';
+        }
+
+        root = parse_exact(json, length, &error);
+        check((root != NULL) && (root->type == cJSON_String), "string with an escape");
+        for (j = 0; j < i; j++)
+        {
+            expected[j] = (char)('a' + (j % 26));
+            expected[i + 1 + j] = (char)('A' + (j % 26));
+        }
+        expected[i] = '\t';
+        expected[(2 * i) + 1] = '\0';
+        check(strcmp(root->valuestring, expected) == 0, "string with an escape");
+        check(error.position == (length - i), "the string is parsed to its end");
+        cJSON_Delete(root);
+
+        /* the string ends early, a control character in it isn't taken for its end */
+        root = parse_exact(json + i, length - (2 * i) - 1, &error);
+        check((root == NULL) && (error.code == cJSON_Error_InvalidString), "unterminated string");
+        json[i + 1 + (i / 2)] = '\001';
+        root = parse_exact(json, length, &error);
+        check(root != NULL, "string with a control character");
+        cJSON_Delete(root);
+    }
+}
+
+/* Numbers are parsed to the nearest double, as a correctly rounding strtod does. */
+static void number_parse_tests(void)
+{
+    const char *numbers[] =
+    {
+        "0.1", "0.30000000000000004", "-1.5e-3", "1E+2", "0.000001", "100000000000000000000000e-20",
+        "1e308", "1.7976931348623157e308", "2.2250738585072014e-308", "4.9e-324",
+        "2.4703282292062327e-324", "2.4703282292062328e-324", "1e-400",
+        "9007199254740993", "123456789012345678901234567890", "3.14159265358979323846264338327950288"
+    };
+    char text[64];
+    cJSON *root = NULL;
+    double value = 0;
+    unsigned long seed = 12345;
+    size_t i = 0;
+
+    for (i = 0; i < (sizeof(numbers) / sizeof(numbers[0])); i++)
+    {
+        root = cJSON_Parse(numbers[i]);
+        check((root != NULL) && ((root->type & 0xFF) == cJSON_Number), numbers[i]);
+        check(root->valuedouble == strtod(numbers[i], NULL), numbers[i]);
+        cJSON_Delete(root);
+    }
+
+    root = cJSON_Parse("-0");
+    check((root->valuedouble == 0) && ((1 / root->valuedouble) < 0), "-0 keeps its sign");
+    cJSON_Delete(root);
+    root = cJSON_Parse("1e400");
+    check(root->valuedouble > 1.7976931348623157e308, "overflow is infinity");
+    cJSON_Delete(root);
+
+    /* the shortest text of lots of doubles of all magnitudes parses back to the same double */
+    for (i = 0; i < 2000; i++)
+    {
+        seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        value = ((double)seed / 2147483648.0) * pow(10, (double)((int)(i % 600) - 300));
+        sprintf(text, "%.17g", value);
+        root = cJSON_Parse(text);
+        check((root != NULL) && (root->valuedouble == value), text);
+        cJSON_Delete(root);
+    }
+}
+
+/* Integer literals keep all 64 bits and print exactly. */
+static void int64_tests(void)
+{
+    const char *exact[] = {"9223372036854775807", "-9223372036854775808", "12345678901234567", "-1", "0"};
+    cJSON *root = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < (sizeof(exact) / sizeof(exact[0])); i++)
+    {
+        root = cJSON_Parse(exact[i]);
+        check((root != NULL) && (root->type & cJSON_NumberIsInt64), exact[i]);
+        check_print(root, exact[i], exact[i]);
+        cJSON_Delete(root);
+    }
+    root = cJSON_Parse("9223372036854775807");
+    check((root->valueint == INT_MAX) && (root->valueint64 == ((((cJSON_int64)1 << 62) - 1) + ((cJSON_int64)1 << 62))), "valueint saturates, valueint64 is exact");
+    cJSON_Delete(root);
+
+    /* too big, or not an integer literal: a double */
+    root = cJSON_Parse("[9223372036854775808, 1.0, 1e3]");
+    check(!(cJSON_GetArrayItem(root, 0)->type & cJSON_NumberIsInt64), "an integer that doesn't fit is a double");
+    check(!(cJSON_GetArrayItem(root, 1)->type & cJSON_NumberIsInt64) && !(cJSON_GetArrayItem(root, 2)->type & cJSON_NumberIsInt64), "fractions and exponents are doubles");
+    check_print(root, "[9223372036854776000,1,1000]", "doubles");
+    cJSON_Delete(root);
+
+    root = cJSON_CreateInt64(-((cJSON_int64)1 << 62) - 1);
+    check_print(root, "-4611686018427387905", "cJSON_CreateInt64");
+    /* assigning the double changes the number, with or without the macros */
+    root->valuedouble = 2.5;
+    check_print(root, "2.5", "valuedouble assigned directly");
+    cJSON_SetNumberValue(root, 7);
+    check(!(root->type & cJSON_NumberIsInt64), "cJSON_SetNumberValue drops valueint64");
+    check_print(root, "7", "cJSON_SetNumberValue");
+    cJSON_Delete(root);
+}
+
+/* digits of a printed number from the first to the last one that isn't zero, the exponent doesn't count */
+static size_t significant_digits(const char *number)
+{
+    size_t digits = 0;
+    size_t significant = 0;
+    for (; *number && (*number != 'e'); number++)
+    {
+        if ((*number >= '0') && (*number <= '9') && ((digits > 0) || (*number != '0')))
+        {
+            digits++;
+            if (*number != '0')
+            {
+                significant = digits;
+            }
+        }
+    }
+
+    return significant;
+}
+
+/* Doubles print as short as they can while still parsing back to the same value. */
+static void number_print_tests(void)
+{
+    struct
+    {
+        double value;
+        const char *text;
+    } cases[] =
+    {
+        {0.1, "0.1"}, {-2.5, "-2.5"}, {100, "100"}, {0.001, "0.001"}, {1e-7, "1e-7"}, {123456.789, "123456.789"},
+        {1.5e300, "1.5e+300"}, {1e21, "1e+21"}, {5e-324, "5e-324"},
+        {1.7976931348623157e308, "1.7976931348623157e+308"}, {2.2250738585072014e-308, "2.2250738585072014e-308"}
+    };
+    unsigned char bytes[sizeof(double)];
+    char longest[64];
+    double value = 0;
+    cJSON *number = NULL;
+    char *out = NULL;
+    unsigned long seed = 4242;
+    size_t i = 0;
+    size_t j = 0;
+
+    for (i = 0; i < (sizeof(cases) / sizeof(cases[0])); i++)
+    {
+        number = cJSON_CreateNumber(cases[i].value);
+        check_print(number, cases[i].text, cases[i].text);
+        cJSON_Delete(number);
+    }
+    number = cJSON_CreateNumber(1.0 / 3);
+    check_print(number, "0.3333333333333333", "1/3");
+    cJSON_Delete(number);
+
+    /* random bit patterns cover every exponent */
+    for (i = 0; i < 5000; i++)
+    {
+        for (j = 0; j < sizeof(double); j++)
+        {
+            seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            bytes[j] = (unsigned char)(seed >> 16);
+        }
+        memcpy(&value, bytes, sizeof(double));
+        if ((value != value) || ((value - value) != 0))
+        {
+            /* NaN or infinity, printed as null */
+            continue;
+        }
+        number = cJSON_CreateNumber(value);
+        out = cJSON_PrintUnformatted(number);
+        sprintf(longest, "%.17g", value);
+        check((out != NULL) && (strtod(out, NULL) == value), longest);
+        check(significant_digits(out) <= 17, longest);
+        free(out);
+        cJSON_Delete(number);
+    }
+}
+
+/* where a writer of the tests below collects the output */
+typedef struct
+{
+    char text[32768];
+    size_t length;
+    size_t calls;
+    /* fail at this call, 0 for never */
+    size_t fail_at;
+} collected_text;
+
+static int collect_text(void *context, const char *data, size_t length)
+{
+    collected_text *collected = (collected_text*)context;
+    if (++collected->calls == collected->fail_at)
+    {
+        return 0;
+    }
+    check(collected->length + length < sizeof(collected->text), "writer output fits");
+    memcpy(collected->text + collected->length, data, length);
+    collected->length += length;
+    collected->text[collected->length] = '\0';
+
+    return 1;
+}
+
+/* Printing to a writer gives the same text as printing into one string. */
+static void writer_tests(void)
+{
+    collected_text collected;
+    cJSON *root = cJSON_CreateArray();
+    char *out = NULL;
+    int fmt = 0;
+    int i = 0;
+
+    for (i = 0; i < 2000; i++)
+    {
+        cJSON_AddItemToArray(root, (i % 2) ? cJSON_CreateString("element") : cJSON_CreateNumber(i));
+    }
+    cJSON_AddItemToArray(root, cJSON_Parse("{\"nested\": {\"empty\": [], \"text\": \"with \\\"escapes\\\"\\n\"}}"));
+    for (fmt = 0; fmt < 2; fmt++)
+    {
+        memset(&collected, '\0', sizeof(collected));
+        check(cJSON_PrintToWriter(root, collect_text, &collected, fmt), "cJSON_PrintToWriter");
+        out = fmt ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+        check((strlen(out) == collected.length) && !strcmp(out, collected.text), "cJSON_PrintToWriter gives the text of cJSON_Print");
+        check(collected.calls > 1, "cJSON_PrintToWriter writes in pieces");
+        free(out);
+
+        /* a small guess makes the buffer grow, the text stays the same */
+        out = cJSON_PrintBuffered(root, 1, fmt);
+        check((out != NULL) && !strcmp(out, collected.text), "cJSON_PrintBuffered with a small guess");
+        free(out);
+
+        /* a failing writer stops printing */
+        collected.length = 0;
+        collected.fail_at = 2;
+        collected.calls = 0;
+        check(!cJSON_PrintToWriter(root, collect_text, &collected, fmt), "cJSON_PrintToWriter with a failing writer");
+        check(collected.calls == 2, "printing stops at the first failed write");
+    }
+    cJSON_Delete(root);
+}
+
+/* Only the given bytes are parsed, they don't need a terminating zero. */
+static void length_tests(void)
+{
+    const char *json = "{\"key\": [1, 2.5e3, true, false, null, \"\\u00e4\"]}";
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *root = NULL;
+    size_t length = strlen(json);
+    size_t i = 0;
+
+    root = parse_exact(json, length, &error);
+    check_print(root, "{\"key\":[1,2500,true,false,null,\"\xc3\xa4\"]}", "cJSON_ParseWithLength");
+    cJSON_Delete(root);
+    /* every shorter piece is incomplete */
+    for (i = 0; i < length; i++)
+    {
+        root = parse_exact(json, i, &error);
+        check((root == NULL) && (error.code != cJSON_Error_None), "incomplete input");
+    }
+
+    /* values that end exactly at the end of the input */
+    root = parse_exact("123", 3, NULL);
+    check((root != NULL) && (root->valueint == 123), "number at the end of the input");
+    cJSON_Delete(root);
+    root = parse_exact("123", 2, NULL);
+    check((root != NULL) && (root->valueint == 12), "number cut by the length");
+    cJSON_Delete(root);
+    check(parse_exact("true", 3, &error) == NULL, "literal cut by the length");
+    check(parse_exact("\"abc\"", 4, &error) == NULL, "string cut by the length");
+
+    /* what follows the length doesn't count, a zero byte ends the input early */
+    memset(&options, '\0', sizeof(options));
+    options.require_null_terminated = 1;
+    root = cJSON_ParseWithLength("[1] garbage", 4, &options, &error);
+    check((root != NULL) && (error.position == 4), "bytes past the length are ignored");
+    cJSON_Delete(root);
+    root = cJSON_ParseWithLength("[1]\0 garbage", 12, &options, &error);
+    check(root != NULL, "a zero byte ends the input");
+    cJSON_Delete(root);
+    check(cJSON_ParseWithLength("[1,\0 2]", 7, NULL, &error) == NULL, "a zero byte in the value");
+}
+
+/* Feed json to a new push parser in pieces of at most step bytes (after a first piece of first bytes), then the
+ * end of the input. Returns the result, error is filled in on failure. */
+static cJSON *push_parse(const char *json, size_t first, size_t step, const cJSON_ParseOptions *options, cJSON_ParseError *error)
+{
+    cJSON_Parser *parser = cJSON_CreateParser(options);
+    size_t length = strlen(json);
+    size_t offset = 0;
+    size_t piece = first;
+    int result = cJSON_ParserNeedMore;
+    cJSON *root = NULL;
+
+    check(parser != NULL, "cJSON_CreateParser");
+    while ((offset < length) && (result != cJSON_ParserError))
+    {
+        if ((piece == 0) || (piece > (length - offset)))
+        {
+            piece = length - offset;
+        }
+        result = cJSON_ParserFeed(parser, json + offset, piece);
+        offset += piece;
+        piece = step;
+    }
+    if (result != cJSON_ParserError)
+    {
+        result = cJSON_ParserFeed(parser, NULL, 0);
+    }
+    root = cJSON_ParserTakeResult(parser);
+    check((root != NULL) == (result == cJSON_ParserDone), "cJSON_ParserTakeResult");
+    cJSON_ParserGetError(parser, error);
+    cJSON_DeleteParser(parser);
+
+    return root;
+}
+
+/* The push parser builds the tree cJSON_Parse does, however the input is split. */
+static void push_parser_tests(void)
+{
+    const char *documents[] =
+    {
+        "{\"name\": \"Jack (\\\"Bee\\\") Nimble\", \"format\": {\"width\": 1920, \"ratio\": -1.5e-3, \"interlace\": false},"
+        " \"list\": [null, true, [], {}, \"\\ud83d\\ude00\"]}",
+        "  -123.25e2  ",
+        "\"\\u00e4\\n\""
+    };
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON_Parser *parser = NULL;
+    cJSON *expected = NULL;
+    cJSON *root = NULL;
+    char *text = NULL;
+    size_t length = 0;
+    size_t i = 0;
+    size_t split = 0;
+
+    for (i = 0; i < (sizeof(documents) / sizeof(documents[0])); i++)
+    {
+        expected = cJSON_Parse(documents[i]);
+        text = cJSON_PrintUnformatted(expected);
+        length = strlen(documents[i]);
+        /* split at every byte, and fed byte by byte */
+        for (split = 0; split <= length; split++)
+        {
+            root = push_parse(documents[i], split, 0, NULL, &error);
+            check_print(root, text, documents[i]);
+            cJSON_Delete(root);
+        }
+        root = push_parse(documents[i], 1, 1, NULL, &error);
+        check_print(root, text, documents[i]);
+        cJSON_Delete(root);
+        free(text);
+        cJSON_Delete(expected);
+    }
+
+    /* errors are at their offset in the whole stream */
+    root = push_parse("[1, 2,\n 3, x]", 4, 1, NULL, &error);
+    check((root == NULL) && (error.code == cJSON_Error_InvalidValue), "push parser error");
+    check((error.position == 11) && (error.line == 2) && (error.column == 5), "push parser error position");
+    check(push_parse("[1, 2", 2, 1, NULL, &error) == NULL, "incomplete input");
+    check(error.code == cJSON_Error_UnterminatedArray, "incomplete input is unterminated");
+    memset(&options, '\0', sizeof(options));
+    options.require_null_terminated = 1;
+    check(push_parse("[1] x", 1, 1, &options, &error) == NULL, "trailing garbage with require_null_terminated");
+    check(error.code == cJSON_Error_TrailingGarbage, "trailing garbage");
+    root = push_parse("[1] x", 1, 1, NULL, &error);
+    check_print(root, "[1]", "trailing garbage is ignored");
+    cJSON_Delete(root);
+
+    /* a root number is only complete at the end of the input */
+    parser = cJSON_CreateParser(NULL);
+    check(cJSON_ParserFeed(parser, "12", 2) == cJSON_ParserNeedMore, "root number before the end");
+    check(cJSON_ParserFeed(parser, "3", 1) == cJSON_ParserNeedMore, "root number before the end");
+    check(cJSON_ParserFeed(parser, NULL, 0) == cJSON_ParserDone, "root number at the end");
+    root = cJSON_ParserTakeResult(parser);
+    check((root != NULL) && (root->valueint == 123), "root number");
+    cJSON_Delete(root);
+    cJSON_DeleteParser(parser);
+
+    /* an unfinished tree is deleted with the parser */
+    parser = cJSON_CreateParser(NULL);
+    check(cJSON_ParserFeed(parser, "{\"a\": [\"unfinished", 18) == cJSON_ParserNeedMore, "unfinished input");
+    check(cJSON_ParserTakeResult(parser) == NULL, "no result before the end");
+    cJSON_DeleteParser(parser);
+}
+
+/* The SAX handler of the tests below writes down the events in a line of text. */
+typedef struct
+{
+    char events[512];
+    /* stop at this event, 0 for never */
+    int stop_at;
+    int count;
+} sax_events;
+
+static int sax_event(sax_events *events, const char *event, const char *text, size_t length)
+{
+    size_t used = strlen(events->events);
+    check(used + strlen(event) + length + 2 < sizeof(events->events), "SAX events fit");
+    strcat(events->events, event);
+    strncat(events->events, text, length);
+    strcat(events->events, " ");
+
+    return ++events->count != events->stop_at;
+}
+
+static int sax_null(void *context)
+{
+    return sax_event((sax_events*)context, "null", "", 0);
+}
+
+static int sax_boolean(void *context, int value)
+{
+    return sax_event((sax_events*)context, value ? "true" : "false", "", 0);
+}
+
+static int sax_number(void *context, double value, const char *text, size_t length)
+{
+    check(value == strtod(text, NULL), "SAX number value");
+    return sax_event((sax_events*)context, "number:", text, length);
+}
+
+static int sax_string(void *context, const char *string, size_t length, int escaped)
+{
+    char decoded[64];
+    if (escaped)
+    {
+        check(length < sizeof(decoded), "SAX string fits");
+        length = cJSON_UnescapeString(string, length, decoded);
+        return sax_event((sax_events*)context, "escaped:", decoded, length);
+    }
+    return sax_event((sax_events*)context, "string:", string, length);
+}
+
+static int sax_key(void *context, const char *string, size_t length, int escaped)
+{
+    check(!escaped, "SAX key without escapes");
+    return sax_event((sax_events*)context, "key:", string, length);
+}
+
+static int sax_start_object(void *context)
+{
+    return sax_event((sax_events*)context, "{", "", 0);
+}
+
+static int sax_end_object(void *context)
+{
+    return sax_event((sax_events*)context, "}", "", 0);
+}
+
+static int sax_start_array(void *context)
+{
+    return sax_event((sax_events*)context, "[", "", 0);
+}
+
+static int sax_end_array(void *context)
+{
+    return sax_event((sax_events*)context, "]", "", 0);
+}
+
+/* cJSON_ParseSAX reports the values in document order, and stops where a callback says so. */
+static void sax_tests(void)
+{
+    const char *json = "{\"a\": [1, -2.5e1, \"x\\ty\"], \"b\": {\"c\": null, \"d\": true, \"e\": false}, \"f\": \"plain\"}";
+    const char *long_number = "[1234567890123456789012345678901234567890123456789012345678901234567890]";
+    cJSON_SAXHandler handler;
+    cJSON_SAXHandler empty;
+    cJSON_Allocator allocator;
+    cJSON_ParseOptions options;
+    int blocks = 0;
+    cJSON_ParseError error;
+    sax_events events;
+
+    memset(&handler, '\0', sizeof(handler));
+    handler.null = sax_null;
+    handler.boolean = sax_boolean;
+    handler.number = sax_number;
+    handler.string = sax_string;
+    handler.key = sax_key;
+    handler.start_object = sax_start_object;
+    handler.end_object = sax_end_object;
+    handler.start_array = sax_start_array;
+    handler.end_array = sax_end_array;
+
+    memset(&events, '\0', sizeof(events));
+    check(cJSON_ParseSAX(json, strlen(json), &handler, &events, NULL, &error), "cJSON_ParseSAX");
+    check(!strcmp(events.events, "{ key:a [ number:1 number:-2.5e1 escaped:x\ty ] key:b { key:c null key:d true key:e false } key:f string:plain } "), "SAX events");
+    check(error.position == strlen(json), "cJSON_ParseSAX reports the end");
+
+    /* a callback stops parsing */
+    memset(&events, '\0', sizeof(events));
+    events.stop_at = 4;
+    check(!cJSON_ParseSAX(json, strlen(json), &handler, &events, NULL, &error), "cJSON_ParseSAX stopped by a callback");
+    check((error.code == cJSON_Error_Aborted) && (error.position == 7) && (events.count == 4), "stopped at the fourth event");
+
+    /* invalid input is found with or without callbacks */
+    memset(&empty, '\0', sizeof(empty));
+    check(cJSON_ParseSAX("[1, 2]", 6, &empty, NULL, NULL, NULL), "cJSON_ParseSAX without callbacks");
+    check(!cJSON_ParseSAX("[1, 2", 5, &empty, NULL, NULL, &error) && (error.code == cJSON_Error_UnterminatedArray), "unterminated array");
+    check(!cJSON_ParseSAX("[\"\\x\"]", 6, &empty, NULL, NULL, &error) && (error.code == cJSON_Error_InvalidEscape), "invalid escape");
+    memset(&options, '\0', sizeof(options));
+    options.require_null_terminated = 1;
+    check(!cJSON_ParseSAX("[] x", 4, &empty, NULL, &options, &error) && (error.code == cJSON_Error_TrailingGarbage), "trailing garbage");
+    check(!cJSON_ParseSAX(NULL, 0, &empty, NULL, NULL, &error) && (error.code == cJSON_Error_InvalidArgument), "NULL input");
+
+    /* numbers of 64 characters and more are converted from a heap copy, made with the options' allocator */
+    memset(&events, '\0', sizeof(events));
+    check(cJSON_ParseSAX(long_number, strlen(long_number), &handler, &events, NULL, &error), "cJSON_ParseSAX of a long number");
+    check((events.count == 3) && (strncmp(events.events, "[ number:1234567890", 19) == 0), "SAX events of a long number");
+    memset(&options, '\0', sizeof(options));
+    allocator.context = &blocks;
+    allocator.malloc_fn = counting_malloc;
+    allocator.realloc_fn = counting_realloc;
+    allocator.free_fn = counting_free;
+    options.allocator = &allocator;
+    check(cJSON_ParseSAX(long_number, strlen(long_number), &empty, NULL, &options, &error) && (blocks == 0), "cJSON_ParseSAX of a long number with an allocator");
+    allocator.malloc_fn = NULL;
+    check(!cJSON_ParseSAX("[]", 2, &empty, NULL, &options, &error) && (error.code == cJSON_Error_InvalidArgument), "cJSON_ParseSAX with an unusable allocator");
+}
+
+/* The record callback of the tests below prints every record (or "error") into a line of text. */
+typedef struct
+{
+    char records[512];
+    size_t count;
+    /* stop after this many records, 0 for never */
+    size_t stop_after;
+} collected_records;
+
+static int collect_record(void *context, size_t index, cJSON *item, const cJSON_ParseError *error)
+{
+    collected_records *collected = (collected_records*)context;
+    char *out = item ? cJSON_PrintUnformatted(item) : NULL;
+    check(index == collected->count++, "records are counted in order");
+    check((item != NULL) || (error->code != cJSON_Error_None), "an invalid record has an error");
+    check(strlen(collected->records) + (out ? strlen(out) : 5) + 2 < sizeof(collected->records), "records fit");
+    strcat(collected->records, out ? out : "error");
+    strcat(collected->records, " ");
+    free(out);
+
+    return collected->count != collected->stop_after;
+}
+
+/* cJSON_ParseRecords parses one document after the other and resumes after invalid ones. */
+static void records_tests(void)
+{
+    const char *batch = "{\"a\": 1}\n[1, 2]\n\n  \"text\" 42\n{\"broken\": \n[true]\n{\"last\": null}";
+    cJSON_Arena *arena = cJSON_CreateArena(0);
+    collected_records collected;
+    size_t length = strlen(batch);
+    size_t processed = 0;
+    size_t boundary = 0;
+
+    memset(&collected, '\0', sizeof(collected));
+    check(cJSON_ParseRecords(batch, length, NULL, arena, collect_record, &collected) == length, "cJSON_ParseRecords into an arena");
+    check(!strcmp(collected.records, "{\"a\":1} [1,2] \"text\" 42 error [true] {\"last\":null} "), "records");
+
+    /* the same from the global hooks */
+    memset(&collected, '\0', sizeof(collected));
+    check(cJSON_ParseRecords(batch, length, NULL, NULL, collect_record, &collected) == length, "cJSON_ParseRecords without an arena");
+    check(!strcmp(collected.records, "{\"a\":1} [1,2] \"text\" 42 error [true] {\"last\":null} "), "records without an arena");
+
+    /* the callback stops early */
+    memset(&collected, '\0', sizeof(collected));
+    collected.stop_after = 2;
+    processed = cJSON_ParseRecords(batch, length, NULL, arena, collect_record, &collected);
+    check((collected.count == 2) && (processed == 15), "stopped after the second record");
+    cJSON_DeleteArena(arena);
+
+    /* pieces cut at line boundaries */
+    boundary = cJSON_RecordBoundary(batch, length, 3);
+    check(boundary == 9, "cJSON_RecordBoundary");
+    check(cJSON_RecordBoundary(batch, length, 9) == 16, "cJSON_RecordBoundary at a line start");
+    check(cJSON_RecordBoundary(batch, length, length - 2) == length, "cJSON_RecordBoundary on the last line");
+}
+
+/* runs the tasks last to first, they may run in any order */
+static void reverse_executor(void *context, void (*task)(void *argument, size_t i), void *argument, size_t count)
+{
+    ++*(int*)context;
+    while (count > 0)
+    {
+        task(argument, --count);
+    }
+}
+
+/* cJSON_ParseArrayParallel builds the tree cJSON_ParseWithLength does, however many pieces it uses. */
+static void parallel_tests(void)
+{
+    char json[8192];
+    cJSON_Arena *arena = cJSON_CreateArena(0);
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *expected = NULL;
+    cJSON *root = NULL;
+    char *text = NULL;
+    size_t length = 0;
+    int executed = 0;
+    int tasks = 0;
+    int i = 0;
+
+    /* strings with brackets and commas, nested containers */
+    length = (size_t)sprintf(json, "[");
+    for (i = 0; i < 100; i++)
+    {
+        length += (size_t)sprintf(json + length, "%s{\"id\": %d, \"tags\": [\"a,b\", \"]\\\"[\"], \"x\": {}}", i ? ", " : "", i);
+    }
+    length += (size_t)sprintf(json + length, "]");
+    expected = cJSON_Parse(json);
+    text = cJSON_PrintUnformatted(expected);
+
+    memset(&options, '\0', sizeof(options));
+    options.executor = reverse_executor;
+    options.executor_context = &executed;
+    for (tasks = 1; tasks <= 8; tasks++)
+    {
+        options.parallel_tasks = tasks;
+        options.index_threshold = (tasks % 2) ? 0 : 50;
+        root = cJSON_ParseArrayParallel(json, length, &options, arena, &error);
+        check_print(root, text, "cJSON_ParseArrayParallel");
+        check((error.code == cJSON_Error_None) && (error.position == length), "cJSON_ParseArrayParallel reports the end");
+        check(cJSON_GetObjectItem(cJSON_GetArrayItem(root, 99), "id")->valueint == 99, "lookup in a parallel tree");
+        check((cJSON_GetArraySize(root) == 100) && ((tasks % 2) || (root->index != NULL)), "index of a parallel tree");
+        cJSON_ArenaReset(arena);
+    }
+    check(executed > 0, "the executor runs the tasks");
+    free(text);
+    cJSON_Delete(expected);
+
+    /* errors are those of the sequential parser */
+    options.parallel_tasks = 4;
+    check(cJSON_ParseArrayParallel("[1, 2, [3, 4}, 5, 6, 7, 8]", 26, &options, arena, &error) == NULL, "invalid parallel input");
+    check((error.code == cJSON_Error_UnterminatedArray) && (error.position == 12), "parallel errors are reported like sequential ones");
+    check(cJSON_ParseArrayParallel("[1, 2, 3, 4, 5, 6, 7, 8,]", 25, &options, arena, &error) == NULL, "trailing comma");
+    check(error.code == cJSON_Error_InvalidValue, "trailing comma is an invalid value");
+
+    /* other roots are parsed the usual way */
+    root = cJSON_ParseArrayParallel("{\"a\": [1, 2]}", 13, &options, arena, &error);
+    check_print(root, "{\"a\":[1,2]}", "object root");
+    root = cJSON_ParseArrayParallel("[]", 2, &options, arena, &error);
+    check_print(root, "[]", "empty array root");
+    cJSON_DeleteArena(arena);
+    check(cJSON_ParseArrayParallel("[1]", 3, &options, NULL, &error) == NULL, "cJSON_ParseArrayParallel without an arena");
+    check(error.code == cJSON_Error_InvalidArgument, "an arena is needed");
+}
+
+/* A lazy tree reads like the tree of an eager parse of the same text. */
+static void lazy_tests(void)
+{
+    const char json[] = "{\"name\": \"x\", \"list\": [1, [2, 3], {\"deep\": [true, null]}], \"empty\": {}, \"n\": -1.5}";
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *eager = cJSON_Parse(json);
+    cJSON *root = NULL;
+    cJSON *list = NULL;
+    cJSON *item = NULL;
+    char *text = cJSON_PrintUnformatted(eager);
+    int count = 0;
+
+    memset(&options, '\0', sizeof(options));
+    options.lazy = 1;
+    root = cJSON_ParseWithOptions(json, &options, &error);
+    check((root != NULL) && (error.code == cJSON_Error_None), "lazy parse");
+    check(root->child == NULL, "the children of a lazy object are parsed on first access");
+    list = cJSON_GetObjectItem(root, "list");
+    check(((list->type & 0xFF) == cJSON_Array) && (list->child == NULL), "cJSON_GetObjectItem leaves the grandchildren lazy");
+    check(cJSON_GetArraySize(list) == 3, "size of a lazy array");
+    check(cJSON_GetArrayItem(cJSON_GetArrayItem(list, 1), 1)->valueint == 3, "cJSON_GetArrayItem on a lazy array");
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(cJSON_GetArrayItem(list, 2), "deep"))
+    {
+        count++;
+    }
+    check(count == 2, "cJSON_ArrayForEach materializes");
+    check(strcmp(cJSON_GetObjectItem(root, "name")->valuestring, "x") == 0, "string of a lazy object");
+    check_print(root, text, "printing a lazy tree");
+    cJSON_Delete(root);
+
+    /* printing materializes everything, and so does a duplicate */
+    root = cJSON_ParseWithOptions(json, &options, NULL);
+    check_print(root, text, "printing an untouched lazy tree");
+    cJSON_Delete(root);
+    root = cJSON_ParseWithOptions(json, &options, NULL);
+    item = cJSON_Duplicate(root, 1);
+    check_print(item, text, "cJSON_Duplicate of a lazy tree");
+    cJSON_Delete(item);
+    cJSON_Delete(root);
+
+    /* cJSON_Materialize parses one level, so child can be walked by hand */
+    root = cJSON_ParseWithOptions(json, &options, NULL);
+    check(cJSON_Materialize(root) && (root->child != NULL), "cJSON_Materialize");
+    check(((root->child->next->type & 0xFF) == cJSON_Array) && (root->child->next->child == NULL), "cJSON_Materialize parses one level");
+    check(cJSON_Materialize(root->child), "cJSON_Materialize of a string does nothing");
+    cJSON_Delete(root);
+
+    /* the whole input is validated up front */
+    check(cJSON_ParseWithOptions("{\"a\": [1, 2}, \"b\": 3}", &options, &error) == NULL, "invalid lazy input");
+    check((error.code == cJSON_Error_UnterminatedArray) && (error.position == 11), "lazy errors are reported up front");
+
+    free(text);
+    cJSON_Delete(eager);
+}
+
+/* The tape holds the same document cJSON_Parse does, in document order. */
+static void tape_tests(void)
+{
+    const char json[] = "{\"list\": [{\"id\": 1}, {\"ID\": 2.5}, \"a\\u00e9\"], \"ok\": true, \"none\": null, \"empty\": []}";
+    cJSON_ParseError error;
+    cJSON_Tape *tape = NULL;
+    size_t list = 0;
+    size_t node = 0;
+    size_t length = 0;
+    int count = 0;
+
+    tape = cJSON_ParseTape(json, sizeof(json) - 1, NULL, &error);
+    check((tape != NULL) && (error.code == cJSON_Error_None), "cJSON_ParseTape");
+    check(cJSON_TapeNodeCount(tape) == 10, "cJSON_TapeNodeCount");
+    check(cJSON_TapeType(tape, 0) == cJSON_Object, "type of the root");
+    check(cJSON_TapeType(tape, 10) == 0, "type of a node past the end");
+
+    /* a container is directly followed by its children */
+    list = cJSON_TapeChild(tape, 0);
+    check((list == 1) && (cJSON_TapeType(tape, list) == cJSON_Array), "cJSON_TapeChild");
+    check(strcmp(cJSON_TapeKey(tape, list), "list") == 0, "cJSON_TapeKey");
+    check(cJSON_TapeKey(tape, cJSON_TapeChild(tape, list)) == NULL, "array items have no key");
+    check(cJSON_TapeGetArraySize(tape, list) == 3, "cJSON_TapeGetArraySize");
+    check(cJSON_TapeNext(tape, list) == 7, "cJSON_TapeNext skips the children");
+    check(cJSON_TapeNumber(tape, cJSON_TapeGetObjectItem(tape, cJSON_TapeGetArrayItem(tape, list, 1), "id")) == 2.5, "cJSON_TapeGetObjectItem is case insensitive");
+    check(cJSON_TapeGetArrayItem(tape, list, 3) == 0, "cJSON_TapeGetArrayItem past the end");
+    check(cJSON_TapeGetObjectItem(tape, 0, "missing") == 0, "cJSON_TapeGetObjectItem of a missing key");
+    node = cJSON_TapeGetArrayItem(tape, list, 2);
+    check((cJSON_TapeString(tape, node, &length) != NULL) && (length == 3) && (strcmp(cJSON_TapeString(tape, node, NULL), "a\xC3\xA9") == 0), "cJSON_TapeString unescapes");
+    check((cJSON_TapeString(tape, list, &length) == NULL) && (cJSON_TapeNumber(tape, list) == 0), "the values of other nodes");
+    check(cJSON_TapeType(tape, cJSON_TapeGetObjectItem(tape, 0, "ok")) == cJSON_True, "true on the tape");
+    check(cJSON_TapeType(tape, cJSON_TapeGetObjectItem(tape, 0, "none")) == cJSON_NULL, "null on the tape");
+    node = cJSON_TapeGetObjectItem(tape, 0, "empty");
+    check((cJSON_TapeChild(tape, node) == 0) && (cJSON_TapeNext(tape, node) == 0), "an empty array is the last member");
+    cJSON_TapeForEach(node, tape, 0)
+    {
+        count++;
+    }
+    check(count == 4, "cJSON_TapeForEach");
+    cJSON_DeleteTape(tape);
+
+    /* errors are those of the other parsers */
+    check(cJSON_ParseTape("[1, 2", 5, NULL, &error) == NULL, "truncated tape input");
+    check(error.code == cJSON_Error_UnterminatedArray, "truncated tape input is an unterminated array");
+    tape = cJSON_ParseTape("123", 3, NULL, &error);
+    check((cJSON_TapeNodeCount(tape) == 1) && (cJSON_TapeNumber(tape, 0) == 123), "a scalar root");
+    cJSON_DeleteTape(tape);
+
+    /* a number long enough to be converted from a heap copy */
+    tape = cJSON_ParseTape("[1234567890123456789012345678901234567890123456789012345678901234567890]", 72, NULL, &error);
+    check((tape != NULL) && (error.code == cJSON_Error_None), "cJSON_ParseTape of a long number");
+    check(cJSON_TapeNumber(tape, 1) == 1234567890123456789012345678901234567890123456789012345678901234567890.0, "the value of a long number");
+    cJSON_DeleteTape(tape);
+}
+
+/* Trees parsed with a string table share its copies of the keys and short values. */
+static void string_table_tests(void)
+{
+    const char json[] = "[{\"name\": \"ab\", \"text\": \"abcdef\"}, {\"name\": \"ab\", \"text\": \"abcdef\"}]";
+    cJSON_StringTable *table = cJSON_CreateStringTable();
+    cJSON_ParseOptions options;
+    cJSON *root = NULL;
+    cJSON *first = NULL;
+    cJSON *second = NULL;
+    cJSON *copy = NULL;
+    const char *name = NULL;
+    char *text = NULL;
+
+    check(table != NULL, "cJSON_CreateStringTable");
+    name = cJSON_InternString(table, "name");
+    check((name != NULL) && (strcmp(name, "name") == 0), "cJSON_InternString");
+    check(cJSON_InternString(table, "name") == name, "cJSON_InternString returns the same copy");
+    check(cJSON_InternString(table, "other") != name, "distinct strings are distinct copies");
+
+    memset(&options, '\0', sizeof(options));
+    options.string_table = table;
+    options.intern_value_length = 2;
+    root = cJSON_ParseWithOptions(json, &options, NULL);
+    first = cJSON_GetArrayItem(root, 0)->child;
+    second = cJSON_GetArrayItem(root, 1)->child;
+    check((first->string == name) && (second->string == name), "keys come from the table");
+    check((first->type & cJSON_StringIsConst) && (second->type & cJSON_StringIsConst), "keys from the table are const");
+    check((first->valuestring == second->valuestring) && (first->type & cJSON_ValueStringIsConst), "short values come from the table");
+    check((first->next->valuestring != second->next->valuestring) && !(first->next->type & cJSON_ValueStringIsConst), "longer values are allocated");
+    check(first->next->string == second->next->string, "every key is interned");
+    check(cJSON_GetObjectItem(cJSON_GetArrayItem(root, 1), "text") == second->next, "lookup in an interned tree");
+    check(cJSON_GetObjectItem(cJSON_GetArrayItem(root, 1), "TEXT") == second->next, "case insensitive lookup in an interned tree");
+
+    /* the tree prints, duplicates and deletes like any other, a duplicate shares the const strings too */
+    text = cJSON_PrintUnformatted(root);
+    check(strcmp(text, "[{\"name\":\"ab\",\"text\":\"abcdef\"},{\"name\":\"ab\",\"text\":\"abcdef\"}]") == 0, "printing an interned tree");
+    copy = cJSON_Duplicate(root, 1);
+    cJSON_Delete(root);
+    check_print(copy, text, "cJSON_Duplicate of an interned tree");
+    check(cJSON_GetArrayItem(copy, 0)->child->string == name, "cJSON_Duplicate keeps the interned keys");
+    cJSON_Delete(copy);
+    cJSON_DeleteStringTable(table);
+    free(text);
+}
+
+/* cJSON_ParseInSitu leaves the strings in the input, unescaped. */
+static void in_situ_tests(void)
+{
+    const char json[] = "{\"key\": \"plain\", \"esc\\nkey\": \"tab\\there \\u00e9\", \"list\": [\"\", \"\\\"q\\\"\"], \"n\": 1}";
+    char buffer[sizeof(json)];
+    cJSON_ParseError error;
+    cJSON *root = NULL;
+    cJSON *item = NULL;
+    cJSON *copy = NULL;
+    char *expected = NULL;
+
+    expected = cJSON_PrintUnformatted(root = cJSON_Parse(json));
+    cJSON_Delete(root);
+
+    memcpy(buffer, json, sizeof(json));
+    root = cJSON_ParseInSitu(buffer, sizeof(json) - 1, NULL, &error);
+    check((root != NULL) && (error.code == cJSON_Error_None) && (error.position == sizeof(json) - 1), "cJSON_ParseInSitu");
+    check_print(root, expected, "the tree of cJSON_ParseInSitu");
+    item = root->child;
+    check((item->string >= buffer) && (item->string < buffer + sizeof(buffer)), "keys point into the input");
+    check((item->valuestring >= buffer) && (item->valuestring < buffer + sizeof(buffer)), "values point into the input");
+    check((item->type & cJSON_StringIsConst) && (item->type & cJSON_ValueStringIsConst) && (item->type & cJSON_StringIsInBuffer), "in situ flags");
+    item = item->next;
+    check((strcmp(item->string, "esc\nkey") == 0) && (strcmp(item->valuestring, "tab\there \xC3\xA9") == 0), "escapes are decoded in place");
+    check((strcmp(cJSON_GetArrayItem(cJSON_GetObjectItem(root, "list"), 0)->valuestring, "") == 0) && (strcmp(cJSON_GetArrayItem(cJSON_GetObjectItem(root, "list"), 1)->valuestring, "\"q\"") == 0), "short strings in place");
+
+    /* a duplicate doesn't depend on the buffer */
+    copy = cJSON_Duplicate(root, 1);
+    cJSON_Delete(root);
+    memset(buffer, 'x', sizeof(buffer));
+    check_print(copy, expected, "cJSON_Duplicate of an in situ tree");
+    check(!(copy->child->type & (cJSON_StringIsConst | cJSON_ValueStringIsConst | cJSON_StringIsInBuffer)), "a duplicate owns its strings");
+    cJSON_Delete(copy);
+
+    /* errors, and the input past length stays as it is */
+    memcpy(buffer, json, sizeof(json));
+    check(cJSON_ParseInSitu(buffer, 16, NULL, &error) == NULL, "truncated in situ input");
+    check(error.code == cJSON_Error_InvalidString, "truncated in situ input ends in a string");
+    check(memcmp(buffer + 16, json + 16, sizeof(json) - 16) == 0, "cJSON_ParseInSitu stays within length");
+    check(cJSON_ParseInSitu(NULL, 0, NULL, &error) == NULL, "cJSON_ParseInSitu without input");
+    free(expected);
+}
+
+/* cJSON_Minify drops whitespace and comments, never anything inside strings. */
+static void minify_tests(void)
+{
+    const char json[] = "{ \"a b\" :\t[1,  2 ] , // to the end of the line\n  \"c\\\" /* not a comment */\": /* a comment */ \"// nor this\"\r\n}";
+    const char minified[] = "{\"a b\":[1,2],\"c\\\" /* not a comment */\":\"// nor this\"}";
+    char buffer[512];
+    char out[512];
+    size_t length = 0;
+    size_t i = 0;
+
+    memcpy(buffer, json, sizeof(json));
+    cJSON_Minify(buffer);
+    check(strcmp(buffer, minified) == 0, "cJSON_Minify");
+
+    memset(out, 'x', sizeof(out));
+    check(cJSON_MinifyInto(json, sizeof(json) - 1, out) == sizeof(minified) - 1, "length of cJSON_MinifyInto");
+    check(strcmp(out, minified) == 0, "cJSON_MinifyInto");
+
+    /* in place, and stopping at length or at a zero byte */
+    memcpy(buffer, json, sizeof(json));
+    check((cJSON_MinifyInto(buffer, sizeof(json) - 1, buffer) == sizeof(minified) - 1) && (strcmp(buffer, minified) == 0), "cJSON_MinifyInto in place");
+    check((cJSON_MinifyInto(json, 9, out) == 7) && (strcmp(out, "{\"a b\":") == 0), "cJSON_MinifyInto stops at length");
+    check((cJSON_MinifyInto("[1, 2]\0[3]", 11, out) == 5) && (strcmp(out, "[1,2]") == 0), "cJSON_MinifyInto stops at a zero byte");
+    check((cJSON_MinifyInto("", 0, out) == 0) && (out[0] == '\0'), "cJSON_MinifyInto of nothing");
+
+    /* long runs of whitespace go through the vector scan */
+    length = (size_t)sprintf(buffer, "[");
+    for (i = 0; i < 100; i++)
+    {
+        buffer[length++] = (i % 3) ? ' ' : '\n';
+    }
+    length += (size_t)sprintf(buffer + length, "true,\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tfalse]");
+    check((cJSON_MinifyInto(buffer, length, out) == 12) && (strcmp(out, "[true,false]") == 0), "cJSON_MinifyInto of long whitespace");
+    cJSON_Minify(buffer);
+    check(strcmp(buffer, "[true,false]") == 0, "cJSON_Minify of long whitespace");
+}
+
+/* Shared trees are read only, and copies of them are modified level by level without touching the others. */
+static void share_tests(void)
+{
+    const char json[] = "{\"list\": [1, 2, {\"deep\": \"x\"}], \"name\": \"shared\"}";
+    cJSON *shared = cJSON_Share(cJSON_Parse(json));
+    cJSON *copy = NULL;
+    cJSON *frozen = NULL;
+    cJSON *list = NULL;
+    cJSON *holder = NULL;
+    char *text = NULL;
+
+    check((shared != NULL) && (shared->type & cJSON_IsShared), "cJSON_Share");
+    check_print(shared, "{\"list\":[1,2,{\"deep\":\"x\"}],\"name\":\"shared\"}", "a shared tree prints");
+    copy = cJSON_Duplicate(shared, 1);
+    check((copy->type & cJSON_IsShared) && (copy->child == shared->child), "cJSON_Duplicate of a shared item shares the tree");
+    text = cJSON_PrintUnformatted(shared);
+
+    /* the frozen items themselves refuse every change, and take over (free) what they are given */
+    frozen = cJSON_GetObjectItem(shared, "list");
+    check((frozen->type & cJSON_IsImmutable) != 0, "the children of a shared item are frozen");
+    cJSON_AddItemToArray(frozen, cJSON_CreateNumber(3));
+    cJSON_InsertItemInArray(frozen, 0, cJSON_CreateString("item"));
+    cJSON_ReplaceItemInArray(frozen, 1, cJSON_CreateNull());
+    cJSON_AddItemToObject(cJSON_GetArrayItem(frozen, 2), "key", cJSON_CreateObject());
+    cJSON_ReplaceItemInObject(cJSON_GetArrayItem(frozen, 2), "deep", cJSON_CreateTrue());
+    cJSON_AddItemToObjectCS(cJSON_GetArrayItem(frozen, 2), "cs", cJSON_CreateFalse());
+    check(cJSON_DetachItemFromArray(frozen, 0) == NULL, "a frozen array refuses detaching");
+    cJSON_DeleteItemFromObject(cJSON_GetArrayItem(frozen, 2), "deep");
+    check(cJSON_Unshare(frozen) == NULL, "a frozen item can't be unshared");
+    check_print(shared, text, "a frozen tree is unchanged");
+
+    /* frozen items can't be added anywhere either, but references to them can, read only */
+    holder = cJSON_CreateArray();
+    cJSON_AddItemToArray(holder, frozen);
+    check(cJSON_GetArraySize(holder) == 0, "a frozen item isn't added");
+    cJSON_AddItemReferenceToArray(holder, frozen);
+    check(cJSON_GetArraySize(holder) == 1, "a reference to a frozen item");
+    check((holder->child->type & cJSON_IsReference) && !(holder->child->type & (cJSON_IsShared | cJSON_IsImmutable)), "a reference to a frozen item is a plain reference");
+    cJSON_AddItemToArray(holder->child, cJSON_CreateNumber(4));
+    check(cJSON_DetachItemFromArray(holder->child, 0) == NULL, "a reference to a frozen item refuses detaching");
+    check_print(holder, "[[1,2,{\"deep\":\"x\"}]]", "a reference to a frozen item stays unchanged");
+    cJSON_Delete(holder);
+
+    /* the shared items are modified after they get a private copy of their level */
+    cJSON_AddItemToObject(copy, "added", cJSON_CreateNumber(5));
+    check_print(copy, "{\"list\":[1,2,{\"deep\":\"x\"}],\"name\":\"shared\",\"added\":5}", "adding to a shared item");
+    list = cJSON_GetObjectItem(copy, "list");
+    check((list != frozen) && (list->type & cJSON_IsShared), "the children of an unshared item are shared again");
+    check(cJSON_Unshare(list) == list, "cJSON_Unshare");
+    check(cJSON_Unshare(cJSON_GetArrayItem(list, 2)) != NULL, "cJSON_Unshare of a deeper level");
+    cJSON_ReplaceItemInObject(cJSON_GetArrayItem(list, 2), "deep", cJSON_CreateString("y"));
+    cJSON_DeleteItemFromArray(list, 0);
+    check_print(copy, "{\"list\":[2,{\"deep\":\"y\"}],\"name\":\"shared\",\"added\":5}", "modifying a copy level by level");
+    check_print(shared, text, "the original is unchanged");
+
+    /* the frozen tree lives until the last shared item is deleted, in any order */
+    cJSON_Delete(shared);
+    check_print(list, "[2,{\"deep\":\"y\"}]", "a copy outlives the original");
+    shared = cJSON_Duplicate(copy, 1);
+    cJSON_Delete(copy);
+    check_print(shared, "{\"list\":[2,{\"deep\":\"y\"}],\"name\":\"shared\",\"added\":5}", "cJSON_Duplicate of a modified copy");
+    cJSON_Delete(shared);
+    free(text);
+
+    /* scalars and attached items */
+    shared = cJSON_Share(cJSON_CreateString("text"));
+    check((shared != NULL) && (strcmp(shared->valuestring, "text") == 0), "cJSON_Share of a string");
+    cJSON_Delete(shared);
+    holder = cJSON_CreateArray();
+    cJSON_AddItemToArray(holder, cJSON_CreateNull());
+    cJSON_AddItemToArray(holder, cJSON_CreateNull());
+    check(cJSON_Share(holder->child->next) == NULL, "items with siblings can't be shared");
+    cJSON_Delete(holder);
+}
+
+/* The binary encoding gives back the same tree, and every damaged encoding is rejected. */
+static void binary_tests(void)
+{
+    const char json[] = "{\"int\": 9007199254740993, \"neg\": -42, \"double\": 0.1, \"big\": 1e300, \"text\": \"a\\\"b\\u00e9\", \"\": \"\", "
+        "\"list\": [true, false, null, [], {}, [[1]]], \"obj\": {\"k\": {\"l\": \"m\"}}}";
+    unsigned char buffer[512];
+    cJSON_ParseOptions options;
+    cJSON_ParseError error;
+    cJSON *root = cJSON_Parse(json);
+    cJSON *decoded = NULL;
+    cJSON *copy = NULL;
+    unsigned char *binary = NULL;
+    char *text = cJSON_PrintUnformatted(root);
+    size_t length = 0;
+    size_t size = 0;
+
+    binary = cJSON_PrintBinary(root, &length);
+    check((binary != NULL) && (length == cJSON_BinarySize(root)), "cJSON_PrintBinary");
+    check((length < sizeof(buffer)) && (cJSON_PrintBinaryPreallocated(root, buffer, length) == length), "cJSON_PrintBinaryPreallocated");
+    check(memcmp(buffer, binary, length) == 0, "cJSON_PrintBinaryPreallocated gives the same encoding");
+    check(cJSON_PrintBinaryPreallocated(root, buffer, length - 1) == 0, "cJSON_PrintBinaryPreallocated of a small buffer");
+
+    decoded = cJSON_ParseBinary(binary, length, NULL, &error);
+    check((decoded != NULL) && (error.code == cJSON_Error_None) && (error.position == length), "cJSON_ParseBinary");
+    check_print(decoded, text, "the binary round trip");
+    check((cJSON_GetObjectItem(decoded, "int")->type & cJSON_NumberIsInt64) && (cJSON_GetObjectItem(decoded, "int")->valueint64 == cJSON_GetObjectItem(root, "int")->valueint64), "64 bit integers in binary");
+    check(cJSON_GetObjectItem(decoded, "double")->valuedouble == 0.1, "doubles in binary");
+    cJSON_Delete(decoded);
+
+    /* truncated encodings and extra bytes */
+    for (size = 0; size < length; size++)
+    {
+        check(cJSON_ParseBinary(binary, size, NULL, &error) == NULL, "truncated binary");
+        check(error.code == cJSON_Error_InvalidBinary, "truncated binary is invalid");
+        check(cJSON_ParseBinaryInSitu(binary, size, NULL, &error) == NULL, "truncated binary in situ");
+    }
+    memcpy(buffer, binary, length);
+    buffer[length] = 0;
+    memset(&options, '\0', sizeof(options));
+    options.require_null_terminated = 1;
+    check(cJSON_ParseBinary(buffer, length + 1, &options, &error) == NULL, "binary followed by more bytes");
+    check(error.code == cJSON_Error_TrailingGarbage, "binary followed by more bytes is trailing garbage");
+    decoded = cJSON_ParseBinary(buffer, length + 1, NULL, &error);
+    check((decoded != NULL) && (error.position == length), "binary followed by more bytes without require_null_terminated");
+    cJSON_Delete(decoded);
+    buffer[0] = 0xFF;
+    check(cJSON_ParseBinary(buffer, length, NULL, &error) == NULL, "binary with an unknown tag");
+    check(cJSON_ParseBinary(NULL, 0, NULL, &error) == NULL, "cJSON_ParseBinary without input");
+
+    /* in situ the strings stay in the encoding, and a duplicate copies them */
+    decoded = cJSON_ParseBinaryInSitu(binary, length, NULL, &error);
+    check_print(decoded, text, "cJSON_ParseBinaryInSitu");
+    copy = cJSON_GetObjectItem(decoded, "text");
+    check((copy->valuestring >= (char*)binary) && (copy->valuestring < (char*)binary + length) && (copy->type & cJSON_StringIsInBuffer), "in situ binary strings point into the encoding");
+    copy = cJSON_Duplicate(decoded, 1);
+    cJSON_Delete(decoded);
+    memset(binary, 0, length);
+    check_print(copy, text, "cJSON_Duplicate of an in situ binary tree");
+    cJSON_Delete(copy);
+    free(binary);
+
+    /* a scalar root */
+    copy = cJSON_CreateNumber(-0.5);
+    size = cJSON_PrintBinaryPreallocated(copy, buffer, sizeof(buffer));
+    check((size > 0) && (size == cJSON_BinarySize(copy)), "binary of a scalar");
+    cJSON_Delete(copy);
+    decoded = cJSON_ParseBinary(buffer, size, &options, NULL);
+    check((decoded != NULL) && (decoded->valuedouble == -0.5), "a scalar from binary");
+    cJSON_Delete(decoded);
+
+    free(text);
+    cJSON_Delete(root);
+}
+
+/* the lengths cJSON_PrintLengths reports, with the items they belong to */
+typedef struct
+{
+    const cJSON *items[16];
+    size_t lengths[16];
+    int count;
+} collected_lengths;
+
+static void collect_length(void *context, const cJSON *item, size_t length)
+{
+    collected_lengths *collected = (collected_lengths*)context;
+    if (collected->count < 16)
+    {
+        collected->items[collected->count] = item;
+        collected->lengths[collected->count] = length;
+    }
+    collected->count++;
+}
+
+/* cJSON_PrintLength is the exact length of the printed text. */
+static void print_length_tests(void)
+{
+    const char *documents[] =
+    {
+        "{\"a\": [1, -2.5, 1e300, 9007199254740993, \"x\\ny\\u0001\\u00e9\"], \"b\": {\"c\": {}, \"d\": []}, \"e\": [[], [{}]], \"\": null}",
+        "[true, false, null, 0.1, 123456789, -0]",
+        "\"\\\"\\\\/\\b\\f\\r\\t\"",
+        "[]",
+        "3"
+    };
+    collected_lengths collected;
+    char buffer[512];
+    cJSON *root = NULL;
+    char *text = NULL;
+    size_t length = 0;
+    size_t lines = 0;
+    size_t i = 0;
+    int fmt = 0;
+
+    for (i = 0; i < sizeof(documents) / sizeof(documents[0]); i++)
+    {
+        root = cJSON_Parse(documents[i]);
+        for (fmt = 0; fmt <= 1; fmt++)
+        {
+            text = fmt ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+            length = cJSON_PrintLength(root, fmt);
+            check(length == strlen(text), "cJSON_PrintLength");
+            check(cJSON_PrintPreallocated(root, buffer, (int)length + 1, fmt) && (strcmp(buffer, text) == 0), "cJSON_PrintPreallocated of cJSON_PrintLength + 1 bytes");
+            check(!cJSON_PrintPreallocated(root, buffer, (int)length, fmt), "cJSON_PrintPreallocated of cJSON_PrintLength bytes");
+            check(cJSON_PrintLengths(root, fmt, NULL, NULL) == length, "cJSON_PrintLengths without a callback");
+            free(text);
+        }
+        cJSON_Delete(root);
+    }
+
+    /* the subtree lengths, children first */
+    root = cJSON_Parse("{\"a\": [1, 2], \"b\": {\"c\": []}}");
+    memset(&collected, '\0', sizeof(collected));
+    length = cJSON_PrintLengths(root, 0, collect_length, &collected);
+    check((collected.count == 4) && (length == strlen("{\"a\":[1,2],\"b\":{\"c\":[]}}")), "cJSON_PrintLengths");
+    check((collected.items[0] == root->child) && (collected.lengths[0] == 5), "the length of an array");
+    check((collected.items[1] == root->child->next->child) && (collected.lengths[1] == 2), "the length of a nested array");
+    check((collected.items[2] == root->child->next) && (collected.lengths[2] == 8), "the length of an object");
+    check((collected.items[3] == root) && (collected.lengths[3] == length), "the length of the root");
+    memset(&collected, '\0', sizeof(collected));
+    length = cJSON_PrintLengths(root, 1, collect_length, &collected);
+    text = cJSON_Print(root);
+    check((collected.count == 4) && (length == strlen(text)) && (collected.lengths[3] == length), "formatted cJSON_PrintLengths");
+    free(text);
+    /* one level deeper than when printed alone, so every line after the first has one more tab */
+    text = cJSON_Print(root->child->next);
+    for (i = 0; text[i]; i++)
+    {
+        lines += (text[i] == '\n') ? 1 : 0;
+    }
+    check(collected.lengths[2] == strlen(text) + lines, "a nested length includes its indentation");
+    free(text);
+    cJSON_Delete(root);
+
+    check(cJSON_PrintLength(NULL, 0) == 0, "cJSON_PrintLength of NULL");
+}
+
+#ifdef CJSON_STATS
+/* how often the stats callbacks were called, per operation */
+typedef struct
+{
+    int parse_begins;
+    int parse_ends;
+    int print_begins;
+    int print_ends;
+} stats_calls;
+
+static void stats_begin(void *context, const char *operation, const cJSON_Stats *stats)
+{
+    stats_calls *calls = (stats_calls*)context;
+    check(stats != NULL, "the counters are passed to the callbacks");
+    if (strcmp(operation, "parse") == 0)
+    {
+        calls->parse_begins++;
+    }
+    else
+    {
+        calls->print_begins++;
+    }
+}
+
+static void stats_end(void *context, const char *operation, const cJSON_Stats *stats)
+{
+    stats_calls *calls = (stats_calls*)context;
+    check(stats != NULL, "the counters are passed to the callbacks");
+    if (strcmp(operation, "parse") == 0)
+    {
+        calls->parse_ends++;
+    }
+    else
+    {
+        calls->print_ends++;
+    }
+}
+
+/* The counters of the last operation, which are reset for the next one. */
+static cJSON_Stats take_stats(void)
+{
+    cJSON_Stats stats;
+    check(cJSON_GetStats(&stats) == 1, "cJSON_GetStats");
+    cJSON_ResetStats();
+    return stats;
+}
+#endif
+
+/* Every parser is counted the same way, when the counters are compiled in. */
+static void stats_tests(void)
+{
+    cJSON_Stats stats;
+#ifdef CJSON_STATS
+    const char json[] = "[{\"a\": [1, [2]]}, \"x\", [3]]";
+    const size_t length = sizeof(json) - 1;
+    cJSON_Arena *arena = cJSON_CreateArena(0);
+    cJSON_ParseOptions options;
+    cJSON_SAXHandler handler;
+    stats_calls calls;
+    cJSON *root = NULL;
+    char *text = NULL;
+    int i = 0;
+
+    memset(&options, '\0', sizeof(options));
+    memset(&handler, '\0', sizeof(handler));
+    memset(&calls, '\0', sizeof(calls));
+    cJSON_ResetStats();
+    stats = take_stats();
+    check((stats.node_allocations == 0) && (stats.bytes_parsed == 0) && (stats.max_depth == 0), "cJSON_ResetStats");
+
+    cJSON_SetStatsCallbacks(stats_begin, stats_end, &calls);
+    root = cJSON_Parse(json);
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4), "the counters of cJSON_Parse");
+    check((stats.node_allocations == 9) && (stats.string_allocations == 2), "the allocations of cJSON_Parse");
+    check((calls.parse_begins == 1) && (calls.parse_ends == 1), "the callbacks of cJSON_Parse");
+    cJSON_GetObjectItem(cJSON_GetArrayItem(root, 0), "a");
+    check(take_stats().key_comparisons == 1, "key comparisons");
+    cJSON_Delete(root);
+
+    /* the other parsers count the same */
+    cJSON_Delete(push_parse(json, 1, 1, NULL, NULL));
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4) && (stats.node_allocations == 9), "the counters of the push parser");
+    check(cJSON_ParseSAX(json, length, &handler, NULL, NULL, NULL), "cJSON_ParseSAX");
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4), "the counters of cJSON_ParseSAX");
+    cJSON_DeleteTape(cJSON_ParseTape(json, length, NULL, NULL));
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4), "the counters of cJSON_ParseTape");
+    options.lazy = 1;
+    cJSON_Delete(cJSON_ParseWithOptions(json, &options, NULL));
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4), "the counters of a lazy parse");
+    options.lazy = 0;
+    options.parallel_tasks = 3;
+    check(cJSON_ParseArrayParallel(json, length, &options, arena, NULL) != NULL, "cJSON_ParseArrayParallel");
+    stats = take_stats();
+    check((stats.bytes_parsed == length) && (stats.max_depth == 4) && (stats.node_allocations == 9), "the counters of cJSON_ParseArrayParallel");
+    cJSON_DeleteArena(arena);
+    check(calls.parse_begins == calls.parse_ends, "every parse ends");
+    check(calls.parse_begins == 6, "every parser calls the callbacks once");
+
+    /* failed parses don't count their bytes, growing print buffers are counted */
+    cJSON_Delete(cJSON_Parse("[1, 2"));
+    check(take_stats().bytes_parsed == 0, "failed parses consume nothing");
+    root = cJSON_CreateArray();
+    for (i = 0; i < 1000; i++)
+    {
+        cJSON_AddItemToArray(root, cJSON_CreateNumber(i));
+    }
+    cJSON_ResetStats();
+    text = cJSON_Print(root);
+    check(take_stats().buffer_reallocations > 0, "buffer reallocations");
+    check((calls.print_begins == 1) && (calls.print_ends == 1), "the callbacks of printing");
+    free(text);
+    cJSON_Delete(root);
+    cJSON_SetStatsCallbacks(NULL, NULL, NULL);
+#else
+    memset(&stats, 0xFF, sizeof(stats));
+    check(cJSON_GetStats(&stats) == 0, "cJSON_GetStats without CJSON_STATS");
+    check((stats.node_allocations == 0) && (stats.bytes_parsed == 0) && (stats.max_depth == 0), "cJSON_GetStats zeroes the counters");
+    cJSON_ResetStats();
+#endif
+}
+
 /* Used by some code below as an example datatype. */
 struct record
 {
@@ -401,5 +1972,31 @@ int main(void)
     /* Now some samplecode for building objects concisely: */
     create_objects();
 
+    /* Checks of the newer functions: */
+    arena_tests();
+    allocator_tests();
+    parse_error_tests();
+    object_index_tests();
+    array_index_tests();
+    scan_tests();
+    number_parse_tests();
+    int64_tests();
+    number_print_tests();
+    writer_tests();
+    length_tests();
+    push_parser_tests();
+    sax_tests();
+    records_tests();
+    parallel_tests();
+    lazy_tests();
+    tape_tests();
+    string_table_tests();
+    in_situ_tests();
+    minify_tests();
+    share_tests();
+    binary_tests();
+    print_length_tests();
+    stats_tests();
+
     return 0;
 }
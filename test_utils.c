@@ -3,6 +3,379 @@
 #include <string.h>
 #include "cJSON_Utils.h"
 
+/* For the checks of the newer functions below: print what failed and give up. */
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Check failed: %s\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* the patched tree has to print (unformatted) as expected */
+static void check_print(const cJSON *item, const char *expected, const char *what)
+{
+    char *out = cJSON_PrintUnformatted(item);
+    check(out != NULL, what);
+    if (strcmp(out, expected) != 0)
+    {
+        printf("Expected: %s\nGot:      %s\n", expected, out);
+        free(out);
+        check(0, what);
+    }
+    free(out);
+}
+
+/* cJSONUtils_Equal and the subtree hashes agree on which trees are the same. */
+static void equal_tests(void)
+{
+    const char *pairs[][2] =
+    {
+        {"{\"a\": 1, \"b\": [true, null, \"x\"]}", "{\"B\": [true, null, \"x\"], \"A\": 1.0}"},
+        {"[1, 2, 3]", "[1,2,3]"},
+        {"{}", "{}"},
+        {"\"text\"", "\"text\""},
+        {"{\"a\": {\"b\": {\"c\": []}}}", "{\"a\": {\"b\": {\"c\": []}}}"}
+    };
+    const char *different[][2] =
+    {
+        {"[1, 2, 3]", "[1, 3, 2]"},
+        {"[1, 2]", "[1, 2, 3]"},
+        {"{\"a\": 1}", "{\"a\": 1, \"b\": 1}"},
+        {"{\"a\": 1}", "{\"b\": 1}"},
+        {"{\"a\": \"x\"}", "{\"a\": \"X\"}"},
+        {"1", "\"1\""},
+        {"true", "false"},
+        {"null", "{}"},
+        {"[]", "{}"},
+        {"{\"a\": {\"b\": [1]}}", "{\"a\": {\"b\": [2]}}"}
+    };
+    cJSONUtils_Hashes *hashes_a = NULL;
+    cJSONUtils_Hashes *hashes_b = NULL;
+    cJSON *a = NULL;
+    cJSON *b = NULL;
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+        a = cJSON_Parse(pairs[i][0]);
+        b = cJSON_Parse(pairs[i][1]);
+        hashes_a = cJSONUtils_HashTree(a);
+        hashes_b = cJSONUtils_HashTree(b);
+        check(cJSONUtils_Equal(a, b) && cJSONUtils_Equal(b, a), "cJSONUtils_Equal of equal trees");
+        check(cJSONUtils_EqualHashed(hashes_a, a, hashes_b, b), "cJSONUtils_EqualHashed of equal trees");
+        check(cJSONUtils_EqualHashed(NULL, a, hashes_b, b), "cJSONUtils_EqualHashed hashes on the fly");
+        if (a->child)
+        {
+            check(cJSONUtils_EqualHashed(hashes_a, a, hashes_a, a) && !cJSONUtils_EqualHashed(hashes_a, a, hashes_a, a->child), "subtree hashes");
+        }
+        cJSONUtils_DeleteHashes(hashes_a);
+        cJSONUtils_DeleteHashes(hashes_b);
+        cJSON_Delete(a);
+        cJSON_Delete(b);
+    }
+
+    for (i = 0; i < sizeof(different) / sizeof(different[0]); i++)
+    {
+        a = cJSON_Parse(different[i][0]);
+        b = cJSON_Parse(different[i][1]);
+        hashes_a = cJSONUtils_HashTree(a);
+        hashes_b = cJSONUtils_HashTree(b);
+        check(!cJSONUtils_Equal(a, b) && !cJSONUtils_Equal(b, a), "cJSONUtils_Equal of different trees");
+        check(!cJSONUtils_EqualHashed(hashes_a, a, hashes_b, b), "cJSONUtils_EqualHashed of different trees");
+        cJSONUtils_DeleteHashes(hashes_a);
+        cJSONUtils_DeleteHashes(hashes_b);
+        cJSON_Delete(a);
+        cJSON_Delete(b);
+    }
+
+    /* neither tree is modified, not even the member order */
+    a = cJSON_Parse("{\"b\": 2, \"a\": 1}");
+    b = cJSON_Duplicate(a, 1);
+    check(cJSONUtils_Equal(a, b), "cJSONUtils_Equal of a duplicate");
+    check_print(a, "{\"b\":2,\"a\":1}", "cJSONUtils_Equal doesn't sort");
+    cJSON_Delete(a);
+    cJSON_Delete(b);
+}
+
+/* Number of operations of a patch that turns from into to, which it has to do. */
+static int minimal_patch_size(const char *from_json, const char *to_json, int max_edits)
+{
+    cJSON *from = cJSON_Parse(from_json);
+    cJSON *to = cJSON_Parse(to_json);
+    cJSON *patch = cJSONUtils_GenerateMinimalPatches(from, to, max_edits);
+    int size = cJSON_GetArraySize(patch);
+
+    check(patch != NULL, "cJSONUtils_GenerateMinimalPatches");
+    check(cJSONUtils_ApplyPatches(from, patch) == 0, "applying a minimal patch");
+    check(cJSONUtils_Equal(from, to), "a minimal patch turns from into to");
+    cJSON_Delete(from);
+    cJSON_Delete(to);
+    cJSON_Delete(patch);
+    return size;
+}
+
+/* Array edits become a few add/remove/move operations instead of replacing every later element. */
+static void minimal_patch_tests(void)
+{
+    cJSON *from = NULL;
+    cJSON *to = NULL;
+    cJSON *patch = NULL;
+    int i = 0;
+
+    check(minimal_patch_size("[1, 2, 3, 4, 5, 6, 7, 8]", "[0, 1, 2, 3, 4, 5, 6, 7, 8]", 16) == 1, "an insert at the front");
+    check(minimal_patch_size("[1, 2, 3, 4, 5, 6, 7, 8]", "[2, 3, 4, 5, 6, 7, 8]", 16) == 1, "a removal at the front");
+    check(minimal_patch_size("[1, 2, 3, 4, 5, 6, 7, 8]", "[2, 3, 4, 5, 6, 7, 8, 1]", 16) == 1, "a move to the end");
+    check(minimal_patch_size("[1, 2, 3, 4, 5, 6, 7, 8]", "[1, 2, 3, 9, 4, 5, 7, 8]", 16) == 2, "an insert and a removal");
+    check(minimal_patch_size("[{\"a\": 1}, {\"b\": 2}]", "[{\"a\": 1}, {\"b\": 3}]", 16) == 1, "changed elements are diffed recursively");
+    check(minimal_patch_size("{\"list\": [\"x\", \"y\"], \"n\": 1}", "{\"list\": [\"w\", \"x\", \"y\"], \"m\": 1}", 16) == 3, "arrays inside objects");
+    check(minimal_patch_size("[]", "[1, 2]", 16) == 2, "from an empty array");
+    check(minimal_patch_size("[1, 2]", "[]", 16) == 2, "to an empty array");
+    check(minimal_patch_size("[1, [2, 3], 4]", "[1, [2, 3], 4]", 16) == 0, "equal trees");
+
+    /* arrays that differ more than max_edits are compared by index, which still works */
+    minimal_patch_size("[1, 2, 3, 4, 5, 6, 7, 8]", "[8, 7, 6, 5, 4, 3, 2, 1]", 2);
+    minimal_patch_size("[1, 2, 3]", "[4, 5, 6, 7, 8, 9]", 0);
+    for (i = 0; i < 15; i++)
+    {
+        minimal_patch_size("{\"a\": [1, 2, {\"b\": [3, 4]}], \"c\": \"d\"}", "{\"a\": [2, {\"b\": [4, 3, 5]}, 1], \"e\": [\"d\"]}", i);
+    }
+
+    /* objects are matched by key, small and big ones, without sorting the inputs */
+    check(minimal_patch_size("{\"z\": 1, \"y\": {\"b\": 2, \"a\": 3}, \"x\": 4}", "{\"x\": 4, \"w\": 0, \"y\": {\"a\": 3, \"b\": 5}}", 16) == 3, "objects in any order");
+    check(minimal_patch_size("{\"k9\": 9, \"k8\": 8, \"k7\": 7, \"k6\": 6, \"k5\": 5, \"k4\": 4, \"k3\": 3, \"k2\": 2, \"k1\": 1, \"k0\": 0}",
+                "{\"k0\": 0, \"K1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": -7, \"k8\": 8, \"kA\": 10}", 16) == 3, "big objects in any order");
+    from = cJSON_Parse("{\"z\": 1, \"y\": {\"b\": 2, \"a\": 3}, \"list\": [{\"d\": 1, \"c\": 2}]}");
+    to = cJSON_Parse("{\"y\": {\"b\": 2, \"c\": 3}, \"z\": 2, \"list\": [{\"e\": 1, \"d\": 1}]}");
+    patch = cJSONUtils_GenerateMinimalPatches(from, to, 16);
+    check_print(from, "{\"z\":1,\"y\":{\"b\":2,\"a\":3},\"list\":[{\"d\":1,\"c\":2}]}", "cJSONUtils_GenerateMinimalPatches leaves from as it is");
+    check_print(to, "{\"y\":{\"b\":2,\"c\":3},\"z\":2,\"list\":[{\"e\":1,\"d\":1}]}", "cJSONUtils_GenerateMinimalPatches leaves to as it is");
+    check((cJSONUtils_ApplyPatches(from, patch) == 0) && cJSONUtils_Equal(from, to), "applying a patch of unsorted objects");
+    cJSON_Delete(patch);
+    cJSON_Delete(from);
+    cJSON_Delete(to);
+}
+
+/* Compiled pointers find what cJSONUtils_GetPointer finds, one at a time or all at once. */
+static void compiled_pointer_tests(void)
+{
+    const char *json = "{\"foo\": [\"bar\", \"baz\", {\"x\": [0, 1, 2]}], \"\": 0, \"a/b\": 1, \"m~n\": 8, \"Case\": 9, \"obj\": {\"k\": {\"l\": true}}}";
+    const char *pointers[] =
+    {
+        "", "/foo", "/foo/0", "/foo/2/x/2", "/foo/2/x/3", "/foo/-", "/foo/01", "/foo/x", "/", "/a~1b", "/m~0n",
+        "/case", "/obj/k/l", "/obj/k/l/m", "/obj/k", "/missing/k", "/foo/2/x"
+    };
+    const char *malformed[] = {"foo", "/~2", "/a~", "/~"};
+    cJSONUtils_Pointer *compiled[sizeof(pointers) / sizeof(pointers[0]) + 1];
+    cJSON *results[sizeof(pointers) / sizeof(pointers[0]) + 1];
+    const int count = (int)(sizeof(pointers) / sizeof(pointers[0]));
+    cJSON *root = cJSON_Parse(json);
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        compiled[i] = cJSONUtils_CompilePointer(pointers[i]);
+        check(compiled[i] != NULL, "cJSONUtils_CompilePointer");
+        check(cJSONUtils_GetCompiledPointer(root, compiled[i]) == cJSONUtils_GetPointer(root, pointers[i]), "cJSONUtils_GetCompiledPointer");
+        /* a compiled pointer can be used many times */
+        check(cJSONUtils_GetCompiledPointer(root, compiled[i]) == cJSONUtils_GetPointer(root, pointers[i]), "cJSONUtils_GetCompiledPointer again");
+    }
+    compiled[count] = NULL;
+    check(cJSONUtils_GetPointers(root, (const cJSONUtils_Pointer * const *)compiled, count + 1, results), "cJSONUtils_GetPointers");
+    for (i = 0; i < count; i++)
+    {
+        check(results[i] == cJSONUtils_GetPointer(root, pointers[i]), "cJSONUtils_GetPointers finds each pointer");
+    }
+    check(results[count] == NULL, "cJSONUtils_GetPointers of a NULL pointer");
+    check(cJSONUtils_GetCompiledPointer(root, compiled[0]) == root, "the empty pointer is the root");
+    check(cJSONUtils_GetCompiledPointer(NULL, compiled[1]) == NULL, "cJSONUtils_GetCompiledPointer without an object");
+    for (i = 0; i < count; i++)
+    {
+        cJSONUtils_DeletePointer(compiled[i]);
+    }
+
+    for (i = 0; i < (int)(sizeof(malformed) / sizeof(malformed[0])); i++)
+    {
+        check(cJSONUtils_CompilePointer(malformed[i]) == NULL, "malformed pointers don't compile");
+    }
+    check(cJSONUtils_CompilePointer(NULL) == NULL, "cJSONUtils_CompilePointer of NULL");
+    cJSON_Delete(root);
+
+    /* many tokens followed in one object and one array */
+    root = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "list", cJSON_CreateArray());
+    for (i = 0; i < 100; i++)
+    {
+        char key[16];
+        sprintf(key, "k%d", i);
+        cJSON_AddItemToObject(root, key, cJSON_CreateNumber(i));
+        cJSON_AddItemToArray(cJSON_GetObjectItem(root, "list"), cJSON_CreateNumber(i));
+    }
+    for (i = 0; i < 16; i++)
+    {
+        char pointer[32];
+        sprintf(pointer, (i % 2) ? "/list/%d" : "/k%d", (i * 7) % 101);
+        compiled[i] = cJSONUtils_CompilePointer(pointer);
+    }
+    check(cJSONUtils_GetPointers(root, (const cJSONUtils_Pointer * const *)compiled, 16, results), "cJSONUtils_GetPointers of many tokens");
+    for (i = 0; i < 16; i++)
+    {
+        check(results[i] == cJSONUtils_GetCompiledPointer(root, compiled[i]), "cJSONUtils_GetPointers of many tokens finds each pointer");
+        check((results[i] != NULL) && (results[i]->valueint == (i * 7) % 101), "the items at many tokens");
+        cJSONUtils_DeletePointer(compiled[i]);
+    }
+    cJSON_Delete(root);
+}
+
+/* Every item of the tree has the pointer cJSONUtils_FindPointerFromObjectTo builds, for every item below item. */
+static void check_path_index(const cJSONUtils_PathIndex *index, cJSON *root, cJSON *item)
+{
+    char *expected = cJSONUtils_FindPointerFromObjectTo(root, item);
+    char *found = cJSONUtils_FindPointerFromIndex(index, item);
+    cJSON *child = NULL;
+
+    check((expected != NULL) && (found != NULL) && (strcmp(expected, found) == 0), "cJSONUtils_FindPointerFromIndex");
+    free(expected);
+    free(found);
+    for (child = item->child; child; child = child->next)
+    {
+        check_path_index(index, root, child);
+    }
+}
+
+/* The path index finds the same pointers as searching the tree. */
+static void path_index_tests(void)
+{
+    cJSON *root = cJSON_Parse("{\"foo\": [\"bar\", {\"a/b\": [1, [2, 3]], \"m~n\": {}}], \"\": null, \"x\": {\"y\": {\"z\": true}}}");
+    cJSON *other = cJSON_CreateNumber(1);
+    cJSONUtils_PathIndex *index = cJSONUtils_BuildPathIndex(root);
+    char *pointer = NULL;
+
+    check(index != NULL, "cJSONUtils_BuildPathIndex");
+    check_path_index(index, root, root);
+    pointer = cJSONUtils_FindPointerFromIndex(index, cJSONUtils_GetPointer(root, "/foo/1/a~1b/1/0"));
+    check(strcmp(pointer, "/foo/1/a~1b/1/0") == 0, "cJSONUtils_FindPointerFromIndex escapes keys");
+    free(pointer);
+    pointer = cJSONUtils_FindPointerFromIndex(index, root);
+    check(strcmp(pointer, "") == 0, "the pointer of the root");
+    free(pointer);
+    check(cJSONUtils_FindPointerFromIndex(index, other) == NULL, "items outside the indexed tree");
+    check(cJSONUtils_FindPointerFromIndex(index, NULL) == NULL, "cJSONUtils_FindPointerFromIndex of NULL");
+    cJSONUtils_DeletePathIndex(index);
+
+    /* after a change the index is rebuilt */
+    cJSON_AddItemToArray(cJSON_GetObjectItem(root, "foo"), other);
+    index = cJSONUtils_BuildPathIndex(root);
+    pointer = cJSONUtils_FindPointerFromIndex(index, other);
+    check(strcmp(pointer, "/foo/2") == 0, "a rebuilt path index");
+    free(pointer);
+    check_path_index(index, root, root);
+    cJSONUtils_DeletePathIndex(index);
+    cJSON_Delete(root);
+
+    /* a bigger tree */
+    root = cJSON_CreateArray();
+    while (cJSON_GetArraySize(root) < 50)
+    {
+        cJSON_AddItemToArray(root, cJSON_Parse("{\"list\": [1, 2, {\"deep\": [3]}]}"));
+    }
+    index = cJSONUtils_BuildPathIndex(root);
+    check_path_index(index, root, root);
+    cJSONUtils_DeletePathIndex(index);
+    cJSON_Delete(root);
+}
+
+/* A failing patch leaves cJSONUtils_AtomicApplyPatches' object as it was, each change undone. */
+static void atomic_patch_tests(void)
+{
+    const char *json = "{\"a\": [1, 2, 3], \"b\": {\"c\": \"d\", \"e\": [true]}, \"f\": null}";
+    const char *failing[][2] =
+    {
+        {"[{\"op\": \"add\", \"path\": \"/a/1\", \"value\": 9}, {\"op\": \"remove\", \"path\": \"/b/c\"}, {\"op\": \"test\", \"path\": \"/f\", \"value\": 1}]", "failed test"},
+        {"[{\"op\": \"replace\", \"path\": \"/b\", \"value\": 1}, {\"op\": \"replace\", \"path\": \"/missing/k\", \"value\": 2}]", "replace, then a replace below nothing"},
+        {"[{\"op\": \"move\", \"from\": \"/a/0\", \"path\": \"/b/e/-\"}, {\"op\": \"copy\", \"from\": \"/b\", \"path\": \"/g\"}, {\"op\": \"bogus\", \"path\": \"/a\"}]", "move and copy, then an unknown op"},
+        {"[{\"op\": \"remove\", \"path\": \"/a/2\"}, {\"op\": \"remove\", \"path\": \"/a/0\"}, {\"op\": \"add\", \"path\": \"/x/y\", \"value\": 1}]", "removes, then an add below nothing"},
+        {"[{\"op\": \"add\", \"path\": \"/a\", \"value\": {}}, {\"op\": \"add\", \"path\": \"/a/k\", \"value\": 2}, {\"op\": \"move\", \"from\": \"/b\", \"path\": \"/b/c\"}]", "replacing adds, then a move into itself"}
+    };
+    const char *succeeding = "[{\"op\": \"add\", \"path\": \"/a/-\", \"value\": 4}, {\"op\": \"move\", \"from\": \"/f\", \"path\": \"/b/f\"}, {\"op\": \"remove\", \"path\": \"/b/e/0\"}]";
+    cJSON *object = NULL;
+    cJSON *patch = NULL;
+    cJSON *expected = NULL;
+    char *original = NULL;
+    char *text = NULL;
+    size_t i = 0;
+
+    object = cJSON_Parse(json);
+    original = cJSON_PrintUnformatted(object);
+    cJSON_Delete(object);
+    for (i = 0; i < sizeof(failing) / sizeof(failing[0]); i++)
+    {
+        object = cJSON_Parse(json);
+        patch = cJSON_Parse(failing[i][0]);
+        check(cJSONUtils_AtomicApplyPatches(object, patch) != 0, failing[i][1]);
+        check_print(object, original, failing[i][1]);
+        cJSON_Delete(patch);
+        cJSON_Delete(object);
+    }
+
+    /* on success it does what cJSONUtils_ApplyPatches does */
+    object = cJSON_Parse(json);
+    expected = cJSON_Parse(json);
+    patch = cJSON_Parse(succeeding);
+    check(cJSONUtils_AtomicApplyPatches(object, patch) == 0, "cJSONUtils_AtomicApplyPatches");
+    check(cJSONUtils_ApplyPatches(expected, patch) == 0, "cJSONUtils_ApplyPatches");
+    text = cJSON_PrintUnformatted(expected);
+    check_print(object, text, "cJSONUtils_AtomicApplyPatches does what cJSONUtils_ApplyPatches does");
+    free(text);
+    cJSON_Delete(patch);
+    cJSON_Delete(expected);
+    cJSON_Delete(object);
+
+    /* unlike cJSONUtils_ApplyPatches, which leaves the first changes */
+    object = cJSON_Parse(json);
+    patch = cJSON_Parse(failing[0][0]);
+    check(cJSONUtils_ApplyPatches(object, patch) != 0, "cJSONUtils_ApplyPatches fails");
+    check(cJSON_GetArraySize(cJSON_GetObjectItem(object, "a")) == 4, "cJSONUtils_ApplyPatches isn't atomic");
+    cJSON_Delete(patch);
+    cJSON_Delete(object);
+    free(original);
+}
+
+/* Patches unshare the levels they change, so copies of a shared tree are patched without touching the others. */
+static void shared_patch_tests(void)
+{
+    const char *patch_json = "[{\"op\": \"replace\", \"path\": \"/a/1/b\", \"value\": 3}, {\"op\": \"add\", \"path\": \"/c/-\", \"value\": true}, {\"op\": \"move\", \"from\": \"/d\", \"path\": \"/a/0\"}, {\"op\": \"remove\", \"path\": \"/c/0\"}]";
+    const char *original = "{\"a\":[0,{\"b\":1}],\"c\":[null],\"d\":\"x\"}";
+    const char *patched = "{\"a\":[\"x\",0,{\"b\":3}],\"c\":[true]}";
+    cJSON *shared = cJSON_Share(cJSON_Parse(original));
+    cJSON *patch = cJSON_Parse(patch_json);
+    cJSON *copy = cJSON_Duplicate(shared, 1);
+    cJSON *expected = cJSON_Parse(patched);
+
+    check(cJSONUtils_ApplyPatches(copy, patch) == 0, "cJSONUtils_ApplyPatches of a shared item");
+    check(cJSONUtils_Equal(copy, expected), "a patched shared item");
+    check_print(shared, original, "patching a copy leaves the shared tree alone");
+    cJSON_Delete(copy);
+
+    copy = cJSON_Duplicate(shared, 1);
+    check(cJSONUtils_AtomicApplyPatches(copy, patch) == 0, "cJSONUtils_AtomicApplyPatches of a shared item");
+    check(cJSONUtils_Equal(copy, expected), "an atomically patched shared item");
+    check_print(shared, original, "patching a copy atomically leaves the shared tree alone");
+    cJSON_Delete(copy);
+
+    /* the frozen items can't be patched */
+    cJSON_Delete(patch);
+    patch = cJSON_Parse("[{\"op\": \"replace\", \"path\": \"/1/b\", \"value\": 3}]");
+    check(cJSONUtils_ApplyPatches(cJSON_GetObjectItem(shared, "a"), patch) == 11, "patching a frozen item");
+    check(cJSONUtils_AtomicApplyPatches(cJSON_GetObjectItem(shared, "a"), patch) == 11, "patching a frozen item atomically");
+    check_print(shared, original, "a frozen item is unchanged");
+
+    cJSON_Delete(patch);
+    cJSON_Delete(expected);
+    cJSON_Delete(shared);
+}
+
 int main(void)
 {
     /* Some variables */
@@ -202,5 +575,13 @@ int main(void)
         free(patchedtext);
     }
 
+    /* Checks of the newer functions: */
+    equal_tests();
+    minimal_patch_tests();
+    compiled_pointer_tests();
+    path_index_tests();
+    atomic_patch_tests();
+    shared_patch_tests();
+
     return 0;
 }